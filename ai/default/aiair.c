@@ -66,7 +66,7 @@ static struct tile *find_nearest_airbase(const struct unit *punit,
 
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   pf_map_move_costs_iterate(pfm, ptile, move_cost, TRUE) {
     if (move_cost > punit->moves_left) {
@@ -209,7 +209,7 @@ static int find_something_to_bomb(struct ai_type *ait, struct unit *punit,
 
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   /* Let's find something to bomb */
   pf_map_move_costs_iterate(pfm, ptile, move_cost, FALSE) {
@@ -274,7 +274,7 @@ static struct tile *dai_find_strategic_airbase(struct ai_type *ait,
 
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
   pf_map_move_costs_iterate(pfm, ptile, move_cost, FALSE) {
     if (move_cost >= punit->moves_left) {
       break; /* Too far! */
@@ -353,7 +353,7 @@ void dai_manage_airunit(struct ai_type *ait, struct player *pplayer,
         && NULL != punit->goto_tile
         && !same_pos(unit_tile(punit), punit->goto_tile)
         && is_airunit_refuel_point(punit->goto_tile, pplayer, punit)) {
-      pfm = pf_map_new(&parameter);
+      pfm = pf_map_new_shared(&parameter);
       path = pf_map_path(pfm, punit->goto_tile);
       if (path) {
         bool alive = adv_follow_path(punit, path, punit->goto_tile);
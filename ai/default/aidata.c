@@ -61,6 +61,7 @@ void dai_data_init(struct ai_type *ait, struct player *pplayer)
   struct ai_plr *ai = def_ai_player_data(pplayer, ait);
 
   ai->phase_initialized = FALSE;
+  ai->danger_assessed = FALSE;
 
   ai->last_num_continents = -1;
   ai->last_num_oceans = -1;
@@ -284,6 +285,7 @@ void dai_data_phase_finished(struct ai_type *ait, struct player *pplayer)
   free(ai->stats.ocean_workers);
   ai->stats.ocean_workers = NULL;
 
+  ai->danger_assessed = FALSE;
   ai->phase_initialized = FALSE;
 }
 
@@ -451,9 +453,7 @@ void dai_adjust_policies(struct ai_type *ait, struct player *pplayer)
 
         pplayer->multipliers[pidx] = MAX(mp_val - ppol->step, ppol->start);
 
-        city_list_iterate(pplayer->cities, acity) {
-          auto_arrange_workers(acity);
-        } city_list_iterate_end;
+        auto_arrange_workers_list(pplayer->cities);
 
         city_list_iterate(pplayer->cities, pcity) {
           new_value += dai_city_want(pplayer, pcity, adv, NULL);
@@ -474,9 +474,7 @@ void dai_adjust_policies(struct ai_type *ait, struct player *pplayer)
 
         pplayer->multipliers[pidx] = MIN(mp_val + ppol->step, ppol->stop);
 
-        city_list_iterate(pplayer->cities, acity) {
-          auto_arrange_workers(acity);
-        } city_list_iterate_end;
+        auto_arrange_workers_list(pplayer->cities);
 
         city_list_iterate(pplayer->cities, pcity) {
           new_value += dai_city_want(pplayer, pcity, adv, NULL);
@@ -500,9 +498,7 @@ void dai_adjust_policies(struct ai_type *ait, struct player *pplayer)
   } multipliers_iterate_end;
 
   if (needs_back_rearrange) {
-    city_list_iterate(pplayer->cities, acity) {
-      auto_arrange_workers(acity);
-    } city_list_iterate_end;
+    auto_arrange_workers_list(pplayer->cities);
   }
 }
 
@@ -535,9 +531,7 @@ void dai_gov_value(struct ai_type *ait, struct player *pplayer,
   /* Ideally we should change tax rates here, but since
    * this is a rather big CPU operation, we'd rather not. */
   check_player_max_rates(pplayer);
-  city_list_iterate(pplayer->cities, acity) {
-    auto_arrange_workers(acity);
-  } city_list_iterate_end;
+  auto_arrange_workers_list(pplayer->cities);
   city_list_iterate(pplayer->cities, pcity) {
     bool capital;
 
@@ -72,6 +72,7 @@ BV_DEFINE(bv_id, MAX_NUM_ID);
 struct ai_plr
 {
   bool phase_initialized;
+  bool danger_assessed;  /* Done by dai_plan_first_activities() */
 
   int last_num_continents;
   int last_num_oceans;
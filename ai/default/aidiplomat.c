@@ -342,6 +342,7 @@ static void dai_diplomat_city(struct ai_type *ait, struct unit *punit,
   chosen_action = NULL;
   chosen_action_utility = -1;
   chosen_sub_tgt_id = 0;
+  action_cache_scope_begin();
   action_iterate(act_id) {
     struct action *paction = action_by_number(act_id);
     adv_want action_utility;
@@ -385,6 +386,7 @@ static void dai_diplomat_city(struct ai_type *ait, struct unit *punit,
     if (action_prob_possible(
           action_prob_vs_city(punit, action_number(chosen_action),
                               ctarget))) {
+      action_cache_scope_end();
       log_base(LOG_DIPLOMAT, "%s %s[%d] does %s at %s",
                nation_rule_name(nation_of_unit(punit)),
                unit_rule_name(punit), punit->id,
@@ -396,6 +398,7 @@ static void dai_diplomat_city(struct ai_type *ait, struct unit *punit,
       return;
     }
   }
+  action_cache_scope_end();
 
   /* This can happen for a number of odd and esoteric reasons  */
   UNIT_LOG(LOG_DIPLOMAT, punit,
@@ -729,7 +732,7 @@ void dai_manage_diplomat(struct ai_type *ait, struct player *pplayer,
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
   parameter.get_zoc = NULL; /* kludge */
   parameter.get_TB = no_intermediate_fights;
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   pcity = tile_city(unit_tile(punit));
 
@@ -799,7 +802,7 @@ void dai_manage_diplomat(struct ai_type *ait, struct player *pplayer,
     parameter.omniscience = !has_handicap(pplayer, H_MAP);
     parameter.get_zoc = NULL; /* kludge */
     parameter.get_TB = no_intermediate_fights;
-    pfm = pf_map_new(&parameter);
+    pfm = pf_map_new_shared(&parameter);
   }
 
   /* If we are not busy, acquire a target. */
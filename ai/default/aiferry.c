@@ -934,7 +934,7 @@ static bool aiferry_findcargo(struct ai_type *ait, struct unit *pferry)
    * might be "blocked" by unknown.  We don't want to fight though */
   parameter.get_TB = no_fights;
   
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
   pf_map_tiles_iterate(pfm, ptile, TRUE) {
     unit_list_iterate(ptile->units, aunit) {
       struct unit_ai *unit_data = def_ai_unit_data(aunit, ait);
@@ -993,7 +993,7 @@ static bool aiferry_find_interested_city(struct ai_type *ait,
   /* We are looking for our own cities, no need to look into the unknown */
   parameter.get_TB = no_fights_or_unknown;
   parameter.omniscience = FALSE;
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   pf_map_positions_iterate(pfm, pos, TRUE) {
     struct city *pcity;
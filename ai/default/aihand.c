@@ -728,14 +728,34 @@ static void dai_manage_government(struct ai_type *ait, struct player *pplayer)
   }
 }
 
+/*************************************************************************//**
+  Planning to be done by AI _before_ first activities. This may be called
+  for several players at once from different threads, so it only assesses
+  the danger to our cities, which doesn't change the game state.
+*****************************************************************************/
+void dai_plan_first_activities(struct ai_type *ait, struct player *pplayer)
+{
+  struct ai_plr *ai = def_ai_player_data(pplayer, ait);
+
+  dai_assess_danger_player(ait, pplayer, &(wld.map));
+  ai->danger_assessed = TRUE;
+}
+
 /*************************************************************************//**
   Activities to be done by AI _before_ human turn.  Here we just move the
   units intelligently.
 *****************************************************************************/
 void dai_do_first_activities(struct ai_type *ait, struct player *pplayer)
 {
+  struct ai_plr *ai = def_ai_player_data(pplayer, ait);
+
   TIMING_LOG(AIT_ALL, TIMER_START);
-  dai_assess_danger_player(ait, pplayer, &(wld.map));
+  if (ai->danger_assessed) {
+    /* Already done by dai_plan_first_activities(). */
+    ai->danger_assessed = FALSE;
+  } else {
+    dai_assess_danger_player(ait, pplayer, &(wld.map));
+  }
   /* TODO: Make assess_danger save information on what is threatening
    * us and make dai_manage_units and Co act upon this information, trying
    * to eliminate the source of danger */
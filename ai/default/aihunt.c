@@ -326,7 +326,7 @@ static void dai_hunter_try_launch(struct ai_type *ait,
       UNIT_LOG(LOGLEVEL_HUNT, missile, "checking for hunt targets");
       pft_fill_unit_parameter(&parameter, punit);
       parameter.omniscience = !has_handicap(pplayer, H_MAP);
-      pfm = pf_map_new(&parameter);
+      pfm = pf_map_new_shared(&parameter);
 
       pf_map_move_costs_iterate(pfm, ptile, move_cost, FALSE) {
         if (move_cost > missile->moves_left / SINGLE_MOVE) {
@@ -452,7 +452,7 @@ int dai_hunter_manage(struct ai_type *ait, struct player *pplayer,
 
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   if (original_target) {
     dai_hunter_juiciness(pplayer, punit, original_target, 
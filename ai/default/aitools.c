@@ -331,7 +331,7 @@ struct tile *immediate_destination(struct unit *punit,
 
     pft_fill_unit_parameter(&parameter, punit);
     parameter.omniscience = !has_handicap(pplayer, H_MAP);
-    pfm = pf_map_new(&parameter);
+    pfm = pf_map_new_shared(&parameter);
     path = pf_map_path(pfm, punit->goto_tile);
 
     if (path) {
@@ -397,6 +397,7 @@ bool dai_unit_goto_constrained(struct ai_type *ait, struct unit *punit,
                                struct pf_parameter *parameter)
 {
   bool alive = TRUE;
+  struct pf_parameter goal_parameter;
   struct pf_map *pfm;
   struct pf_path *path;
 
@@ -427,7 +428,10 @@ bool dai_unit_goto_constrained(struct ai_type *ait, struct unit *punit,
     return TRUE;
   }
 
-  pfm = pf_map_new(parameter);
+  /* Only one destination, direct the search to it. */
+  goal_parameter = *parameter;
+  goal_parameter.goal_directed = TRUE;
+  pfm = pf_map_new(&goal_parameter);
   path = pf_map_path(pfm, ptile);
 
   if (path) {
@@ -460,7 +464,8 @@ bool goto_is_sane(struct unit *punit, struct tile *ptile)
     struct pf_map *pfm;
 
     pft_fill_unit_attack_param(&parameter, punit);
-    pfm = pf_map_new(&parameter);
+    parameter.goal_directed = TRUE;
+    pfm = pf_map_new_shared(&parameter);
 
     if (pf_map_move_cost(pfm, ptile) != PF_IMPOSSIBLE_MC) {
       can_get_there = TRUE;
@@ -1115,9 +1120,7 @@ void dai_government_change(struct player *pplayer, struct government *gov)
 
   handle_player_change_government(pplayer, government_number(gov));
 
-  city_list_iterate(pplayer->cities, pcity) {
-    auto_arrange_workers(pcity); /* update cities */
-  } city_list_iterate_end;
+  auto_arrange_workers_list(pplayer->cities); /* update cities */
 }
 
 /**********************************************************************//**
@@ -27,6 +27,7 @@
 #include "timing.h"
 
 /* common */
+#include "actions.h"
 #include "city.h"
 #include "combat.h"
 #include "game.h"
@@ -527,7 +528,7 @@ static struct pf_path *find_rampage_target(struct unit *punit,
    * Hence no call ai_avoid_risks()
    */
 
-  tgt_map = pf_map_new(&parameter);
+  tgt_map = pf_map_new_shared(&parameter);
   pf_map_move_costs_iterate(tgt_map, iter_tile, move_cost, FALSE) {
     int want;
     bool move_needed;
@@ -723,7 +724,7 @@ int look_for_charge(struct ai_type *ait, struct player *pplayer,
 
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   pf_map_move_costs_iterate(pfm, ptile, move_cost, TRUE) {
     if (move_cost > max_move_cost) {
@@ -1244,7 +1245,7 @@ int find_something_to_kill(struct ai_type *ait, struct player *pplayer,
 
   pft_fill_unit_attack_param(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  punit_map = pf_map_new(&parameter);
+  punit_map = pf_map_new_shared(&parameter);
 
   if (MOVE_NONE == punit_class->adv.sea_move) {
     /* We need boat to move over sea. */
@@ -1271,7 +1272,7 @@ int find_something_to_kill(struct ai_type *ait, struct player *pplayer,
     boattype = unit_type_get(ferryboat);
     pft_fill_unit_overlap_param(&parameter, ferryboat);
     parameter.omniscience = !has_handicap(pplayer, H_MAP);
-    ferry_map = pf_map_new(&parameter);
+    ferry_map = pf_map_new_shared(&parameter);
   } else {
     boattype = best_role_unit_for_player(pplayer, L_FERRYBOAT);
     if (NULL == boattype) {
@@ -1283,7 +1284,7 @@ int find_something_to_kill(struct ai_type *ait, struct player *pplayer,
       pft_fill_utype_overlap_param(&parameter, boattype, punit_tile,
                                    pplayer);
       parameter.omniscience = !has_handicap(pplayer, H_MAP);
-      ferry_map = pf_map_new(&parameter);
+      ferry_map = pf_map_new_shared(&parameter);
     } else {
       ferry_map = NULL;
     }
@@ -1593,7 +1594,7 @@ struct city *find_nearest_safe_city(struct unit *punit)
 
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   pf_map_move_costs_iterate(pfm, ptile, move_cost, TRUE) {
     if (move_cost > best) {
@@ -2729,6 +2730,10 @@ static void dai_set_defenders(struct ai_type *ait, struct player *pplayer)
 **************************************************************************/
 void dai_manage_units(struct ai_type *ait, struct player *pplayer) 
 {
+  /* Units, caravans and diplomats in particular, ask about the same
+   * actions and targets several times while deciding what to do. */
+  action_cache_scope_begin();
+
   TIMING_LOG(AIT_AIRLIFT, TIMER_START);
   dai_airlift(ait, pplayer);
   TIMING_LOG(AIT_AIRLIFT, TIMER_STOP);
@@ -2755,6 +2760,8 @@ void dai_manage_units(struct ai_type *ait, struct player *pplayer)
       dai_manage_unit(ait, pplayer, punit);
     }
   } unit_list_iterate_safe_end;
+
+  action_cache_scope_end();
 }
 
 /**********************************************************************//**
@@ -2872,7 +2879,7 @@ static void dai_manage_barbarian_leader(struct ai_type *ait,
   if (0 < body_guards) {
     pft_fill_unit_parameter(&parameter, leader);
     parameter.omniscience = !has_handicap(pplayer, H_MAP);
-    pfm = pf_map_new(&parameter);
+    pfm = pf_map_new_shared(&parameter);
 
     /* Find the closest body guard. FIXME: maybe choose the strongest too? */
     pf_map_tiles_iterate(pfm, ptile, FALSE) {
@@ -2925,7 +2932,7 @@ static void dai_manage_barbarian_leader(struct ai_type *ait,
 
   pft_fill_unit_parameter(&parameter, worst_danger);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
   best_move_cost = pf_map_move_cost(pfm, leader_tile);
 
   /* Try to escape. */
@@ -3312,7 +3319,7 @@ bool dai_unit_can_strike_my_unit(const struct unit *attacker,
 
   pft_fill_unit_parameter(&parameter, attacker);
   parameter.omniscience = !has_handicap(unit_owner(defender), H_MAP);
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   pf_map_move_costs_iterate(pfm, ptile, move_cost, FALSE) {
     if (move_cost > max_move_cost) {
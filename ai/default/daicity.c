@@ -24,6 +24,7 @@
 
 /* common */
 #include "actions.h"
+#include "effects.h"
 #include "game.h"
 #include "government.h"
 #include "research.h"
@@ -1503,6 +1504,7 @@ static adv_want base_want(struct ai_type *ait, struct player *pplayer,
 
     pplayer->wonders[improvement_index(pimprove)] = wonder_city_id;
   }
+  effect_cache_invalidate();
 
   return final_want;
 }
@@ -67,10 +67,12 @@ struct texai_req
 
 #define SPECLIST_TAG texaimsg
 #define SPECLIST_TYPE struct texai_msg
+#define SPECLIST_MUTEX
 #include "speclist.h"
 
 #define SPECLIST_TAG texaireq
 #define SPECLIST_TYPE struct texai_req
+#define SPECLIST_MUTEX
 #include "speclist.h"
 
 void texai_send_msg(enum texaimsgtype type, struct player *pplayer,
@@ -410,6 +410,15 @@ static void twai_switch_to_explore(struct unit *punit, struct tile *target,
   TAI_DFUNC(dai_switch_to_explore, punit, target, allow);
 }
 
+/**********************************************************************//**
+  Call default ai with threaded ai type as parameter.
+**************************************************************************/
+static void twai_plan_first_activities(struct player *pplayer)
+{
+  TAI_AIT;
+  TAI_DFUNC(dai_plan_first_activities, pplayer);
+}
+
 /**********************************************************************//**
   Call default ai with threaded ai type as parameter.
 **************************************************************************/
@@ -622,6 +631,7 @@ bool fc_ai_threaded_setup(struct ai_type *ai)
 
   ai->funcs.want_to_explore = twai_switch_to_explore;
 
+  ai->funcs.first_activities_plan = twai_plan_first_activities;
   ai->funcs.first_activities = twai_first_activities;
   ai->funcs.restart_phase = twai_restart_phase;
   ai->funcs.diplomacy_actions = twai_diplomacy_actions;
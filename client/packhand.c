@@ -3326,6 +3326,9 @@ void handle_rulesets_ready(void)
     unit_type_action_cache_set(ptype);
   } unit_type_iterate_end;
 
+  /* What units of each type may do, given the caches above. */
+  actions_utype_tables_build();
+
   /* Cache what city production can receive help from caravans. */
   city_production_caravan_shields_init();
 
@@ -99,6 +99,87 @@ static bool actions_initialized = FALSE;
 
 static struct action_enabler_list *action_enablers_by_action[MAX_NUM_ACTIONS];
 
+/* What units of each type may do, as far as the ruleset alone can tell.
+ * The type of a unit never changes while it acts, so these parts of the
+ * action rules need not be evaluated again at each query. Built by
+ * actions_utype_tables_build(). */
+static struct {
+  bool ready;
+  int num_utypes;
+
+  /* The enablers of each unit performed action that a unit of each type
+   * may use, in the same order as in action_enablers_by_action. An
+   * enabler is left out when its actor requirements contradict the unit
+   * type. */
+  struct action_enabler_list **by_utype[MAX_NUM_ACTIONS];
+
+  /* The unit types that pass the unit type hard requirements of each
+   * action result. */
+  bv_unit_types hard_reqs_ok[ACTRES_NONE + 1];
+
+  /* The unit types that can do an action that may block each action. */
+  bv_unit_types may_be_blocked[MAX_NUM_ACTIONS];
+
+  /* The unit types that may be forced to act by each action auto
+   * performer cause. */
+  bv_unit_types may_auto_perf[AAPC_COUNT];
+} utype_tables;
+
+static void actions_utype_tables_free(void);
+static bool
+action_actor_utype_hard_reqs_ok_full(enum action_result result,
+                                     const struct unit_type *actor_unittype,
+                                     bool ignore_third_party);
+
+/* What an action cache memo was computed for. The target kind is given
+ * by the action. */
+struct action_memo_key {
+  action_id act;
+  bool prob;            /* action_prob_*() rather than is_action_enabled_*() */
+  int actor_id;
+  int target_id;        /* City or unit id or tile index, 0 for self. */
+  int extra_id;         /* Target extra, or -1 */
+};
+
+/* The result of an is_action_enabled_unit_on_*() or action_prob_*() call,
+ * and the state of the actor unit it was computed for. */
+struct action_memo {
+  struct action_memo_key key;
+  bool valid;
+  int tile_index;
+  int homecity;
+  int owner;
+  const struct unit_type *utype;
+  int moves_left;
+  int hp;
+  int veteran;
+  enum unit_activity activity;
+  int transporter_id;
+  bool enabled;
+  struct act_prob prob;
+};
+
+static genhash_val_t action_memo_key_val(const struct action_memo_key *key);
+static bool action_memo_key_comp(const struct action_memo_key *key1,
+                                 const struct action_memo_key *key2);
+
+#define SPECHASH_TAG action_memo
+#define SPECHASH_IKEY_TYPE struct action_memo_key *
+#define SPECHASH_IDATA_TYPE struct action_memo *
+#define SPECHASH_IKEY_VAL action_memo_key_val
+#define SPECHASH_IKEY_COMP action_memo_key_comp
+#define SPECHASH_IDATA_FREE (action_memo_hash_data_free_fn_t) free
+#include "spechash.h"
+
+/* The results of the unit action queries made between
+ * action_cache_scope_begin() and action_cache_scope_end(). */
+static struct {
+  int scopes;                   /* Nesting depth. */
+  struct action_memo_hash *memos;
+  unsigned int hits;
+  unsigned int misses;
+} action_cache;
+
 /* Hard requirements relates to action result. */
 static struct obligatory_req_vector obligatory_hard_reqs[ACTRES_NONE];
 
@@ -1220,6 +1301,12 @@ void actions_free(void)
   /* Don't consider the actions to be initialized any longer. */
   actions_initialized = FALSE;
 
+  actions_utype_tables_free();
+  log_debug("Action cache: %u hits, %u misses",
+            action_cache.hits, action_cache.misses);
+  action_cache.hits = 0;
+  action_cache.misses = 0;
+
   action_iterate(act) {
     action_enabler_list_iterate(action_enablers_by_action[act], enabler) {
       action_enabler_free(enabler);
@@ -2123,6 +2210,7 @@ void action_enabler_add(struct action_enabler *enabler)
   action_enabler_list_append(
         action_enablers_for_action(enabler->action),
         enabler);
+  actions_utype_tables_free();
 }
 
 /**********************************************************************//**
@@ -2137,6 +2225,8 @@ bool action_enabler_remove(struct action_enabler *enabler)
   /* Sanity check: a non existing action doesn't have enablers. */
   fc_assert_ret_val(action_id_exists(enabler->action), FALSE);
 
+  actions_utype_tables_free();
+
   return action_enabler_list_remove(
         action_enablers_for_action(enabler->action),
         enabler);
@@ -2154,6 +2244,191 @@ action_enablers_for_action(action_id action)
   return action_enablers_by_action[action];
 }
 
+/**********************************************************************//**
+  Free the unit type action tables. They are built again when needed.
+**************************************************************************/
+static void actions_utype_tables_free(void)
+{
+  int i;
+
+  if (!utype_tables.ready) {
+    return;
+  }
+
+  action_iterate(act) {
+    if (NULL == utype_tables.by_utype[act]) {
+      continue;
+    }
+
+    for (i = 0; i < utype_tables.num_utypes; i++) {
+      action_enabler_list_destroy(utype_tables.by_utype[act][i]);
+    }
+    free(utype_tables.by_utype[act]);
+    utype_tables.by_utype[act] = NULL;
+  } action_iterate_end;
+
+  utype_tables.ready = FALSE;
+}
+
+/**********************************************************************//**
+  (Re)build the tables of what units of each type may do: the enablers
+  they may use, the action results whose unit type hard requirements
+  they pass, the actions they may be blocked from and the causes that may
+  force them to act.
+
+  They must be built again when the requirements of an enabler have been
+  changed in place, as ruleset compatibility processing does, and after
+  the unit type action caches have been set, since those tell what
+  blocking actions a unit type can do. Both the server and the client
+  build them once the ruleset is loaded, so that they are only read
+  while AI players plan in parallel.
+**************************************************************************/
+void actions_utype_tables_build(void)
+{
+  int res;
+
+  actions_utype_tables_free();
+
+  utype_tables.num_utypes = utype_count();
+
+  for (res = 0; res <= ACTRES_NONE; res++) {
+    BV_CLR_ALL(utype_tables.hard_reqs_ok[res]);
+    unit_type_iterate(putype) {
+      if (action_actor_utype_hard_reqs_ok_full(res, putype, TRUE)) {
+        BV_SET(utype_tables.hard_reqs_ok[res], utype_index(putype));
+      }
+    } unit_type_iterate_end;
+  }
+
+  for (res = 0; res < AAPC_COUNT; res++) {
+    BV_CLR_ALL(utype_tables.may_auto_perf[res]);
+  }
+  action_auto_perf_iterate(autoperf) {
+    unit_type_iterate(putype) {
+      if (!requirement_fulfilled_by_unit_type(putype, &autoperf->reqs)) {
+        /* Never selected for units of this type. */
+        continue;
+      }
+
+      action_auto_perf_actions_iterate(autoperf, act) {
+        if (AAK_UNIT == action_id_get_actor_kind(act)
+            && utype_can_do_action(putype, act)) {
+          BV_SET(utype_tables.may_auto_perf[autoperf->cause],
+                 utype_index(putype));
+          break;
+        }
+      } action_auto_perf_actions_iterate_end;
+    } unit_type_iterate_end;
+  } action_auto_perf_iterate_end;
+
+  action_iterate(act) {
+    BV_CLR_ALL(utype_tables.may_be_blocked[act]);
+
+    if (AAK_UNIT != action_id_get_actor_kind(act)) {
+      /* Not performed by units. */
+      continue;
+    }
+
+    unit_type_iterate(putype) {
+      action_iterate(blocker) {
+        if (action_id_would_be_blocked_by(act, blocker)
+            && utype_can_do_action(putype, blocker)) {
+          BV_SET(utype_tables.may_be_blocked[act], utype_index(putype));
+          break;
+        }
+      } action_iterate_end;
+    } unit_type_iterate_end;
+
+    utype_tables.by_utype[act]
+      = fc_malloc(utype_tables.num_utypes
+                  * sizeof(*utype_tables.by_utype[act]));
+
+    unit_type_iterate(putype) {
+      struct action_enabler_list *enablers = action_enabler_list_new();
+
+      action_enabler_list_iterate(action_enablers_by_action[act], enabler) {
+        if (requirement_fulfilled_by_unit_type(putype,
+                                               &enabler->actor_reqs)) {
+          action_enabler_list_append(enablers, enabler);
+        }
+      } action_enabler_list_iterate_end;
+
+      utype_tables.by_utype[act][utype_index(putype)] = enablers;
+    } unit_type_iterate_end;
+  } action_iterate_end;
+
+  utype_tables.ready = TRUE;
+}
+
+/**********************************************************************//**
+  Get the enablers of the action that an actor of the given unit type may
+  use. Others have actor requirements that the unit type contradicts.
+  Gives all the enablers of the action if the type is NULL.
+**************************************************************************/
+static struct action_enabler_list *
+action_enablers_for_utype(action_id act, const struct unit_type *putype)
+{
+  if (NULL == putype) {
+    return action_enablers_for_action(act);
+  }
+
+  if (!utype_tables.ready) {
+    actions_utype_tables_build();
+  }
+
+  if (NULL == utype_tables.by_utype[act]
+      || utype_index(putype) >= utype_tables.num_utypes) {
+    return action_enablers_for_action(act);
+  }
+
+  return utype_tables.by_utype[act][utype_index(putype)];
+}
+
+/**********************************************************************//**
+  Returns TRUE iff units of the given type pass the unit type hard
+  requirements of the action result, third parties aside. Looked up in
+  the unit type action tables.
+**************************************************************************/
+static bool utype_passes_hard_reqs(enum action_result result,
+                                   const struct unit_type *putype)
+{
+  if (!utype_tables.ready) {
+    actions_utype_tables_build();
+  }
+
+  return BV_ISSET(utype_tables.hard_reqs_ok[result], utype_index(putype));
+}
+
+/**********************************************************************//**
+  Returns TRUE iff a unit of the given type may be blocked from doing the
+  action, that is, if it can do any action that blocks it.
+**************************************************************************/
+static bool utype_may_be_blocked(action_id act,
+                                 const struct unit_type *putype)
+{
+  if (!utype_tables.ready) {
+    actions_utype_tables_build();
+  }
+
+  return BV_ISSET(utype_tables.may_be_blocked[act], utype_index(putype));
+}
+
+/**********************************************************************//**
+  Returns TRUE iff a unit of the given type may be forced to perform an
+  action by the cause. When FALSE, no action auto performer of the cause
+  applies to the unit type or has an action it can do, so there is no
+  point in asking for the probability of a forced action.
+**************************************************************************/
+bool utype_may_auto_perform(const struct unit_type *putype,
+                            enum action_auto_perf_cause cause)
+{
+  if (!utype_tables.ready) {
+    actions_utype_tables_build();
+  }
+
+  return BV_ISSET(utype_tables.may_auto_perf[cause], utype_index(putype));
+}
+
 /**********************************************************************//**
   Returns a suggestion to add an obligatory hard requirement to an action
   enabler or NULL if no hard obligatory reqs were missing. It is the
@@ -2796,14 +3071,20 @@ struct action *action_is_blocked_by(const action_id act_id,
                                     const struct city *target_city_arg,
                                     const struct unit *target_unit)
 {
+  const struct tile *target_tile;
+  const struct city *target_city;
 
+  if (actor_unit != NULL
+      && !utype_may_be_blocked(act_id, unit_type_get(actor_unit))) {
+    /* The actor can't do any of the actions that would block it. */
+    return NULL;
+  }
 
-  const struct tile *target_tile
-      = blocked_find_target_tile(act_id, actor_unit, target_tile_arg,
-                                 target_city_arg, target_unit);
-  const struct city *target_city
-      = blocked_find_target_city(act_id, actor_unit, target_tile,
-                                 target_city_arg, target_unit);
+  target_tile = blocked_find_target_tile(act_id, actor_unit,
+                                         target_tile_arg,
+                                         target_city_arg, target_unit);
+  target_city = blocked_find_target_city(act_id, actor_unit, target_tile,
+                                         target_city_arg, target_unit);
 
   action_iterate(blocker_id) {
     fc_assert_action(action_id_get_actor_kind(blocker_id) == AAK_UNIT,
@@ -2814,6 +3095,11 @@ struct action *action_is_blocked_by(const action_id act_id,
       continue;
     }
 
+    if (actor_unit != NULL && !unit_can_do_action(actor_unit, blocker_id)) {
+      /* Can't be enabled for this unit type. */
+      continue;
+    }
+
     switch (action_id_get_target_kind(blocker_id)) {
     case ATK_CITY:
       if (!target_city) {
@@ -3065,7 +3351,8 @@ action_hard_reqs_actor(enum action_result result,
                        const bool omniscient,
                        const struct city *homecity)
 {
-  if (!action_actor_utype_hard_reqs_ok_full(result, actor_unittype, TRUE)) {
+  if (NULL != actor_unittype
+      && !utype_passes_hard_reqs(result, actor_unittype)) {
     /* Info leak: The actor player knows the type of his unit. */
     /* The actor unit type can't perform the action because of hard
      * unit type requirements. */
@@ -4072,6 +4359,172 @@ is_action_possible(const action_id wanted_action,
   return out;
 }
 
+/**********************************************************************//**
+  Hash function for action_memo_key.
+**************************************************************************/
+static genhash_val_t action_memo_key_val(const struct action_memo_key *key)
+{
+  genhash_val_t result = key->act;
+
+  result = result * 31 + key->prob;
+  result = result * 31 + key->actor_id;
+  result = result * 31 + key->target_id;
+  result = result * 31 + key->extra_id;
+
+  return result;
+}
+
+/**********************************************************************//**
+  Comparison function for action_memo_key.
+**************************************************************************/
+static bool action_memo_key_comp(const struct action_memo_key *key1,
+                                 const struct action_memo_key *key2)
+{
+  return (key1->act == key2->act
+          && key1->prob == key2->prob
+          && key1->actor_id == key2->actor_id
+          && key1->target_id == key2->target_id
+          && key1->extra_id == key2->extra_id);
+}
+
+/**********************************************************************//**
+  Open an action cache scope. Until the matching action_cache_scope_end(),
+  the results of the is_action_enabled_unit_on_*() and action_prob_*()
+  queries are remembered and given again for the same action, actor unit
+  and target. A result is computed again if the actor unit has moved or
+  its state has changed in between. Anything else that may change a
+  result must call action_cache_invalidate(), so scopes are only meant
+  to be opened around code that asks questions about units before
+  acting. Scopes nest, and are only opened from the main thread.
+**************************************************************************/
+void action_cache_scope_begin(void)
+{
+  if (0 == action_cache.scopes++) {
+    action_cache.memos = action_memo_hash_new();
+  }
+}
+
+/**********************************************************************//**
+  Close an action cache scope opened by action_cache_scope_begin(). When
+  the outermost scope is closed, the remembered results are dropped.
+**************************************************************************/
+void action_cache_scope_end(void)
+{
+  fc_assert_ret(0 < action_cache.scopes);
+
+  if (0 == --action_cache.scopes) {
+    action_memo_hash_destroy(action_cache.memos);
+    action_cache.memos = NULL;
+  }
+}
+
+/**********************************************************************//**
+  Forget the results remembered in the open action cache scopes. Must be
+  called when units move, appear or disappear, are loaded or unloaded or
+  when cities change hands.
+**************************************************************************/
+void action_cache_invalidate(void)
+{
+  if (NULL != action_cache.memos) {
+    action_memo_hash_clear(action_cache.memos);
+  }
+}
+
+/**********************************************************************//**
+  Get the action cache memo of the query, or NULL if no action cache scope
+  is open. If the memo's valid field is set, the query has been answered
+  already for the actor unit in its current state. Otherwise the result
+  should be stored in it with action_memo_enabled() or action_memo_prob().
+**************************************************************************/
+static struct action_memo *action_memo_get(action_id act, bool prob,
+                                           const struct unit *actor_unit,
+                                           int target_id,
+                                           const struct extra_type *extra)
+{
+  struct action_memo_key key;
+  struct action_memo *memo;
+  const struct unit *ptrans;
+
+  if (NULL == action_cache.memos || NULL == actor_unit
+      || NULL == unit_tile(actor_unit)
+      || IDENTITY_NUMBER_ZERO == actor_unit->id) {
+    /* Virtual units, e.g. the ones the AI evaluates, share the same id
+     * and are not remembered. */
+    return NULL;
+  }
+
+  key.act = act;
+  key.prob = prob;
+  key.actor_id = actor_unit->id;
+  key.target_id = target_id;
+  key.extra_id = (NULL != extra ? extra_number(extra) : -1);
+
+  ptrans = unit_transport_get(actor_unit);
+
+  if (action_memo_hash_lookup(action_cache.memos, &key, &memo)) {
+    if (memo->valid
+        && memo->tile_index == tile_index(unit_tile(actor_unit))
+        && memo->homecity == actor_unit->homecity
+        && memo->owner == player_number(unit_owner(actor_unit))
+        && memo->utype == unit_type_get(actor_unit)
+        && memo->moves_left == actor_unit->moves_left
+        && memo->hp == actor_unit->hp
+        && memo->veteran == actor_unit->veteran
+        && memo->activity == actor_unit->activity
+        && memo->transporter_id == (NULL != ptrans ? ptrans->id : 0)) {
+      action_cache.hits++;
+      return memo;
+    }
+  } else {
+    memo = fc_malloc(sizeof(*memo));
+    memo->key = key;
+    action_memo_hash_insert(action_cache.memos, &memo->key, memo);
+  }
+
+  memo->valid = FALSE;
+  memo->tile_index = tile_index(unit_tile(actor_unit));
+  memo->homecity = actor_unit->homecity;
+  memo->owner = player_number(unit_owner(actor_unit));
+  memo->utype = unit_type_get(actor_unit);
+  memo->moves_left = actor_unit->moves_left;
+  memo->hp = actor_unit->hp;
+  memo->veteran = actor_unit->veteran;
+  memo->activity = actor_unit->activity;
+  memo->transporter_id = (NULL != ptrans ? ptrans->id : 0);
+  action_cache.misses++;
+
+  return memo;
+}
+
+/**********************************************************************//**
+  Store the result of an is_action_enabled_unit_on_*() query in its memo,
+  if any, and return it.
+**************************************************************************/
+static bool action_memo_enabled(struct action_memo *memo, bool enabled)
+{
+  if (NULL != memo) {
+    memo->enabled = enabled;
+    memo->valid = TRUE;
+  }
+
+  return enabled;
+}
+
+/**********************************************************************//**
+  Store the result of an action_prob_*() query in its memo, if any, and
+  return it.
+**************************************************************************/
+static struct act_prob action_memo_prob(struct action_memo *memo,
+                                        struct act_prob prob)
+{
+  if (NULL != memo) {
+    memo->prob = prob;
+    memo->valid = TRUE;
+  }
+
+  return prob;
+}
+
 /**********************************************************************//**
   Return TRUE iff the action enabler is active
 **************************************************************************/
@@ -4155,7 +4608,8 @@ static bool is_action_enabled(const action_id wanted_action,
     return FALSE;
   }
 
-  action_enabler_list_iterate(action_enablers_for_action(wanted_action),
+  action_enabler_list_iterate(action_enablers_for_utype(wanted_action,
+                                                        actor_unittype),
                               enabler) {
     if (is_enabler_active(enabler, actor_player, actor_city,
                           actor_building, actor_tile,
@@ -4239,10 +4693,19 @@ bool is_action_enabled_unit_on_city(const action_id wanted_action,
                                     const struct unit *actor_unit,
                                     const struct city *target_city)
 {
-  return is_action_enabled_unit_on_city_full(wanted_action, actor_unit,
-                                             unit_home(actor_unit),
-                                             unit_tile(actor_unit),
-                                             target_city);
+  struct action_memo *memo
+    = action_memo_get(wanted_action, FALSE, actor_unit,
+                      NULL != target_city ? target_city->id : -1, NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->enabled;
+  }
+
+  return action_memo_enabled(memo,
+      is_action_enabled_unit_on_city_full(wanted_action, actor_unit,
+                                          unit_home(actor_unit),
+                                          unit_tile(actor_unit),
+                                          target_city));
 }
 
 /**********************************************************************//**
@@ -4308,10 +4771,19 @@ bool is_action_enabled_unit_on_unit(const action_id wanted_action,
                                     const struct unit *actor_unit,
                                     const struct unit *target_unit)
 {
-  return is_action_enabled_unit_on_unit_full(wanted_action, actor_unit,
-                                             unit_home(actor_unit),
-                                             unit_tile(actor_unit),
-                                             target_unit);
+  struct action_memo *memo
+    = action_memo_get(wanted_action, FALSE, actor_unit,
+                      NULL != target_unit ? target_unit->id : -1, NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->enabled;
+  }
+
+  return action_memo_enabled(memo,
+      is_action_enabled_unit_on_unit_full(wanted_action, actor_unit,
+                                          unit_home(actor_unit),
+                                          unit_tile(actor_unit),
+                                          target_unit));
 }
 
 /**********************************************************************//**
@@ -4385,10 +4857,20 @@ bool is_action_enabled_unit_on_units(const action_id wanted_action,
                                      const struct unit *actor_unit,
                                      const struct tile *target_tile)
 {
-  return is_action_enabled_unit_on_units_full(wanted_action, actor_unit,
-                                              unit_home(actor_unit),
-                                              unit_tile(actor_unit),
-                                              target_tile);
+  struct action_memo *memo
+    = action_memo_get(wanted_action, FALSE, actor_unit,
+                      NULL != target_tile ? tile_index(target_tile) : -1,
+                      NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->enabled;
+  }
+
+  return action_memo_enabled(memo,
+      is_action_enabled_unit_on_units_full(wanted_action, actor_unit,
+                                           unit_home(actor_unit),
+                                           unit_tile(actor_unit),
+                                           target_tile));
 }
 
 /**********************************************************************//**
@@ -4454,10 +4936,20 @@ bool is_action_enabled_unit_on_tile(const action_id wanted_action,
                                     const struct tile *target_tile,
                                     const struct extra_type *target_extra)
 {
-  return is_action_enabled_unit_on_tile_full(wanted_action, actor_unit,
-                                             unit_home(actor_unit),
-                                             unit_tile(actor_unit),
-                                             target_tile, target_extra);
+  struct action_memo *memo
+    = action_memo_get(wanted_action, FALSE, actor_unit,
+                      NULL != target_tile ? tile_index(target_tile) : -1,
+                      target_extra);
+
+  if (NULL != memo && memo->valid) {
+    return memo->enabled;
+  }
+
+  return action_memo_enabled(memo,
+      is_action_enabled_unit_on_tile_full(wanted_action, actor_unit,
+                                          unit_home(actor_unit),
+                                          unit_tile(actor_unit),
+                                          target_tile, target_extra));
 }
 
 /**********************************************************************//**
@@ -4519,9 +5011,17 @@ is_action_enabled_unit_on_self_full(const action_id wanted_action,
 bool is_action_enabled_unit_on_self(const action_id wanted_action,
                                     const struct unit *actor_unit)
 {
-  return is_action_enabled_unit_on_self_full(wanted_action, actor_unit,
-                                             unit_home(actor_unit),
-                                             unit_tile(actor_unit));
+  struct action_memo *memo
+    = action_memo_get(wanted_action, FALSE, actor_unit, 0, NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->enabled;
+  }
+
+  return action_memo_enabled(memo,
+      is_action_enabled_unit_on_self_full(wanted_action, actor_unit,
+                                          unit_home(actor_unit),
+                                          unit_tile(actor_unit)));
 }
 
 /**********************************************************************//**
@@ -4561,8 +5061,11 @@ action_enabled_local(const action_id wanted_action,
   enum fc_tristate result;
 
   result = TRI_NO;
-  action_enabler_list_iterate(action_enablers_for_action(wanted_action),
-                              enabler) {
+  action_enabler_list_iterate(
+      action_enablers_for_utype(wanted_action,
+                                actor_unit != NULL
+                                ? unit_type_get(actor_unit) : NULL),
+      enabler) {
     current = fc_tristate_and(mke_eval_reqs(actor_player, actor_player,
                                             target_player, actor_city,
                                             actor_building, actor_tile,
@@ -5173,10 +5676,19 @@ struct act_prob action_prob_vs_city(const struct unit* actor_unit,
                                     const action_id act_id,
                                     const struct city* target_city)
 {
-  return action_prob_vs_city_full(actor_unit,
-                                  unit_home(actor_unit),
-                                  unit_tile(actor_unit),
-                                  act_id, target_city);
+  struct action_memo *memo
+    = action_memo_get(act_id, TRUE, actor_unit,
+                      NULL != target_city ? target_city->id : -1, NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->prob;
+  }
+
+  return action_memo_prob(memo,
+                          action_prob_vs_city_full(actor_unit,
+                                                   unit_home(actor_unit),
+                                                   unit_tile(actor_unit),
+                                                   act_id, target_city));
 }
 
 /**********************************************************************//**
@@ -5246,11 +5758,20 @@ struct act_prob action_prob_vs_unit(const struct unit* actor_unit,
                                     const action_id act_id,
                                     const struct unit* target_unit)
 {
-  return action_prob_vs_unit_full(actor_unit,
-                                  unit_home(actor_unit),
-                                  unit_tile(actor_unit),
-                                  act_id,
-                                  target_unit);
+  struct action_memo *memo
+    = action_memo_get(act_id, TRUE, actor_unit,
+                      NULL != target_unit ? target_unit->id : -1, NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->prob;
+  }
+
+  return action_memo_prob(memo,
+                          action_prob_vs_unit_full(actor_unit,
+                                                   unit_home(actor_unit),
+                                                   unit_tile(actor_unit),
+                                                   act_id,
+                                                   target_unit));
 }
 
 /**********************************************************************//**
@@ -5415,11 +5936,21 @@ struct act_prob action_prob_vs_units(const struct unit* actor_unit,
                                      const action_id act_id,
                                      const struct tile* target_tile)
 {
-  return action_prob_vs_units_full(actor_unit,
-                                   unit_home(actor_unit),
-                                   unit_tile(actor_unit),
-                                   act_id,
-                                   target_tile);
+  struct action_memo *memo
+    = action_memo_get(act_id, TRUE, actor_unit,
+                      NULL != target_tile ? tile_index(target_tile) : -1,
+                      NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->prob;
+  }
+
+  return action_memo_prob(memo,
+                          action_prob_vs_units_full(actor_unit,
+                                                    unit_home(actor_unit),
+                                                    unit_tile(actor_unit),
+                                                    act_id,
+                                                    target_tile));
 }
 
 /**********************************************************************//**
@@ -5488,10 +6019,21 @@ struct act_prob action_prob_vs_tile(const struct unit *actor_unit,
                                     const struct tile *target_tile,
                                     const struct extra_type *target_extra)
 {
-  return action_prob_vs_tile_full(actor_unit,
-                                  unit_home(actor_unit),
-                                  unit_tile(actor_unit),
-                                  act_id, target_tile, target_extra);
+  struct action_memo *memo
+    = action_memo_get(act_id, TRUE, actor_unit,
+                      NULL != target_tile ? tile_index(target_tile) : -1,
+                      target_extra);
+
+  if (NULL != memo && memo->valid) {
+    return memo->prob;
+  }
+
+  return action_memo_prob(memo,
+                          action_prob_vs_tile_full(actor_unit,
+                                                   unit_home(actor_unit),
+                                                   unit_tile(actor_unit),
+                                                   act_id, target_tile,
+                                                   target_extra));
 }
 
 /**********************************************************************//**
@@ -5549,10 +6091,18 @@ action_prob_self_full(const struct unit* actor_unit,
 struct act_prob action_prob_self(const struct unit* actor_unit,
                                  const action_id act_id)
 {
-  return action_prob_self_full(actor_unit,
-                               unit_home(actor_unit),
-                               unit_tile(actor_unit),
-                               act_id);
+  struct action_memo *memo
+    = action_memo_get(act_id, TRUE, actor_unit, 0, NULL);
+
+  if (NULL != memo && memo->valid) {
+    return memo->prob;
+  }
+
+  return action_memo_prob(memo,
+                          action_prob_self_full(actor_unit,
+                                                unit_home(actor_unit),
+                                                unit_tile(actor_unit),
+                                                act_id));
 }
 
 /**********************************************************************//**
@@ -6239,7 +6789,8 @@ bool action_maybe_possible_actor_unit(const action_id act_id,
     return FALSE;
   }
 
-  action_enabler_list_iterate(action_enablers_for_action(act_id),
+  action_enabler_list_iterate(action_enablers_for_utype(act_id,
+                                                        actor_unittype),
                               enabler) {
     const enum fc_tristate current
         = mke_eval_reqs(actor_player,
@@ -620,6 +620,9 @@ struct action_enabler *
 action_enabler_copy(const struct action_enabler *original);
 void action_enabler_add(struct action_enabler *enabler);
 bool action_enabler_remove(struct action_enabler *enabler);
+void actions_utype_tables_build(void);
+bool utype_may_auto_perform(const struct unit_type *putype,
+                            enum action_auto_perf_cause cause);
 
 struct req_vec_problem *
 action_enabler_suggest_repair_oblig(const struct action_enabler *enabler);
@@ -636,6 +639,10 @@ action_enabler_vector_by_number(const void *enabler,
                                 req_vec_num_in_item vec);
 const char *action_enabler_vector_by_number_name(req_vec_num_in_item vec);
 
+void action_cache_scope_begin(void);
+void action_cache_scope_end(void);
+void action_cache_invalidate(void);
+
 struct action *action_is_blocked_by(const action_id act_id,
                                     const struct unit *actor_unit,
                                     const struct tile *target_tile,
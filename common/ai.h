@@ -24,7 +24,7 @@ extern "C" {
  * structure below. When changing mandatory capability part, check that
  * there's enough reserved_xx pointers in the end of the structure for
  * taking to use without need to bump mandatory capability again. */
-#define FC_AI_MOD_CAPSTR "+Freeciv-3.1-ai-module-2019.Feb.16"
+#define FC_AI_MOD_CAPSTR "+Freeciv-3.1-ai-module-2026.Oct.18"
 
 /* Timers for all AI activities. Define it to get statistics about the AI. */
 #ifdef FREECIV_DEBUG
@@ -242,6 +242,12 @@ struct ai_type
     void (*want_to_explore)(struct unit *punit, struct tile *target,
                             enum override_bool *allow);
 
+    /* Called for player AI type in the beginning of player phase, before
+     * first_activities. When the 'aithreads' server setting is set, it's
+     * called for several players at once from different threads: it may
+     * only read the game state, and write only data of the player. */
+    void (*first_activities_plan)(struct player *pplayer);
+
     /* Called for player AI type in the beginning of player phase.
      * Unlike with phase_begin, everything is set up for phase already. */
     void (*first_activities)(struct player *pplayer);
@@ -20,6 +20,7 @@
 
 /* utility */
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "mem.h"
 #include "shared.h"
@@ -28,10 +29,12 @@
 
 /* common */
 #include "city.h"
+#include "effects.h"
 #include "game.h"
 #include "government.h"
 #include "map.h"
 #include "specialist.h"
+#include "traderoutes.h"
 
 #include "cm.h"
 
@@ -101,6 +104,9 @@ static struct {
     struct timer *wall_timer;
     int query_count;
     int apply_count;
+    int lattice_reuse_count;
+    int warm_start_count;
+    int warm_start_kept_count;
     const char *name;
   } greedy, opt;
 
@@ -198,13 +204,15 @@ struct cm_state {
   struct cm_parameter parameter;
   /*mutable*/ struct city *pcity;
 
-  /* the tile lattice */
+  /* the tile lattice, whose tile types belong to 'cache' */
+  struct cm_lattice_cache *cache;
   struct tile_type_vector lattice;
   struct tile_type_vector lattice_by_prod[O_LAST];
 
   /* the best known solution, and its fitness */
   struct partial_solution best;
   struct cm_fitness best_value;
+  bool best_is_seed; /* best is the warm start, not found by the search */
 
   /* hard constraints on production: any solution with less production than
    * this fails to satisfy the constraints, so we can stop investigating
@@ -230,6 +238,56 @@ struct cm_state {
   bool *workers_map; /* placement of the workers within the city map */
 };
 
+/*
+ * The tile-type lattice of a city, kept between queries.  The lattice
+ * only depends on the city size and on what each workable tile and usable
+ * specialist produces; those inputs are stored as the key, and the lattice
+ * is reused for as long as the key computed at query time matches.  Any
+ * difference, even a single tile, makes the whole lattice be built again:
+ * it is not updated in place.  The lattice is stored in the order it was
+ * built in, so a reused lattice sorts exactly like a freshly built one.
+ *
+ * The queries write their lattice_index and estimated_fitness into the
+ * cached tile types, so only one query at a time may use a lattice;
+ * 'in_use' checks that.
+ */
+struct cm_lattice_cache {
+  int *key;
+  int key_len;
+  struct tile_type_vector lattice;
+  bool in_use;
+};
+
+static void cm_lattice_cache_destroy(struct cm_lattice_cache *pcache);
+
+#define SPECHASH_TAG cm_lattice
+#define SPECHASH_INT_KEY_TYPE
+#define SPECHASH_IDATA_TYPE struct cm_lattice_cache *
+#define SPECHASH_IDATA_FREE cm_lattice_cache_destroy
+#include "spechash.h"
+
+/* Cached lattices by city id.  The mutex guards the hash table itself,
+ * not the lattices: queries for the same city are never run at once. */
+static struct cm_lattice_hash *lattice_cache = NULL;
+static fc_mutex lattice_cache_mutex;
+
+/* struct cm_query_index_hash: index of the query of each city in a batch. */
+#define SPECHASH_TAG cm_query_index
+#define SPECHASH_INT_KEY_TYPE
+#define SPECHASH_INT_DATA_TYPE
+#include "spechash.h"
+
+/* The queries of a batch, shared by the threads solving them.  Queries
+ * are solved group by group; see cm_batch_make_groups(). */
+struct cm_batch {
+  fc_mutex mutex;
+  struct cm_query *queries;
+  int *next_in_group;   /* Next query of the same group, or -1. */
+  int *groups;          /* First query of each group. */
+  int num_groups;
+  int next_group;       /* First group no thread has taken yet. */
+};
+
 
 /* return #fields + specialist types */
 static int num_types(const struct cm_state *state);
@@ -298,6 +356,8 @@ void cm_init(void)
   performance.opt.wall_timer = timer_new(TIMER_USER, TIMER_ACTIVE);
   performance.opt.name = "opt";
 #endif /* GATHER_TIME_STATS */
+
+  fc_init_mutex(&lattice_cache_mutex);
 }
 
 /************************************************************************//**
@@ -311,11 +371,16 @@ void cm_init_citymap(void)
 }
 
 /************************************************************************//**
-  Clear the cache for a city.
+  Clear the cache for a city.  Cached lattices are checked against the
+  city before they are reused, so this only releases the memory.
 ****************************************************************************/
 void cm_clear_cache(struct city *pcity)
 {
-  /* The B&B algorithm doesn't have city caches so there's nothing to do. */
+  fc_allocate_mutex(&lattice_cache_mutex);
+  if (lattice_cache != NULL) {
+    cm_lattice_hash_remove(lattice_cache, pcity->id);
+  }
+  fc_release_mutex(&lattice_cache_mutex);
 }
 
 /************************************************************************//**
@@ -331,6 +396,12 @@ void cm_free(void)
   timer_destroy(performance.opt.wall_timer);
   memset(&performance, 0, sizeof(performance));
 #endif /* GATHER_TIME_STATS */
+
+  if (lattice_cache != NULL) {
+    cm_lattice_hash_destroy(lattice_cache);
+    lattice_cache = NULL;
+  }
+  fc_destroy_mutex(&lattice_cache_mutex);
 }
 
 /************************************************************************//**
@@ -427,6 +498,16 @@ static void tile_type_vector_free_all(struct tile_type_vector *vec)
   tile_type_vector_free(vec);
 }
 
+/************************************************************************//**
+  Free a cached lattice, along with all its tile types.
+****************************************************************************/
+static void cm_lattice_cache_destroy(struct cm_lattice_cache *pcache)
+{
+  tile_type_vector_free_all(&pcache->lattice);
+  free(pcache->key);
+  free(pcache);
+}
+
 /************************************************************************//**
   Return TRUE iff all categories of the two types are equal.  This means
   all production outputs are equal and the is_specialist fields are also
@@ -879,43 +960,39 @@ static int compare_tile_type_by_fitness(const void *va, const void *vb)
   return compare_tile_type_by_lattice_order(*a, *b);
 }
 
-static Output_type_id compare_key;
-static double compare_key_trade_bonus;
+/* A tile type, with its production of the output the lattice is being
+ * sorted by.  The value is computed by the caller of qsort(), so that
+ * queries running in different threads don't share a sort key. */
+struct cm_type_by_stat {
+  double value;
+  struct cm_tile_type *ptype;
+};
 
 /************************************************************************//**
-  Compare by the production of type compare_key.
+  Compare by the production of the output sorted by.
   If a produces more food than b, then a cannot be a child of b, so
   this respects the partial order -- unless a and b produce equal food.
   In that case, use compare_tile_type_by_lattice_order.
 ****************************************************************************/
 static int compare_tile_type_by_stat(const void *va, const void *vb)
 {
-  struct cm_tile_type * const *a = va;
-  struct cm_tile_type * const *b = vb;
+  const struct cm_type_by_stat *a = va;
+  const struct cm_type_by_stat *b = vb;
 
-  if (*a == *b) {
+  if (a->ptype == b->ptype) {
     return 0;
   }
 
-  /* consider the influence of trade on science, luxury, gold
-     for compute_max_stats_heuristics, which uses these sorted arrays,
-     it is essential, that the sorting is correct, else promising 
-     branches get pruned */
-  double valuea = (*a)->production[compare_key] + 
-                    compare_key_trade_bonus * (*a)->production[O_TRADE];
-  double valueb = (*b)->production[compare_key] +
-                    compare_key_trade_bonus * (*b)->production[O_TRADE];
-
   /* most production of what we care about goes first */
   /* double compare is ok, both values are calculated in the same way
-     and should only be considered equal, if equal in compare_key 
-     and O_TRADE */
-  if (valuea != valueb) {
+     and should only be considered equal, if equal in the output sorted
+     by and O_TRADE */
+  if (a->value != b->value) {
     /* b-a so we sort big numbers first */
-    return valueb - valuea;
+    return b->value - a->value;
   }
 
-  return compare_tile_type_by_lattice_order(*a, *b);
+  return compare_tile_type_by_lattice_order(a->ptype, b->ptype);
 }
 
 /****************************************************************************
@@ -923,18 +1000,55 @@ static int compare_tile_type_by_stat(const void *va, const void *vb)
 ****************************************************************************/
 
 /************************************************************************//**
-  Compute the production of tile [x,y] and stuff it into the tile type.
-  Doesn't touch the other fields.
+  Return the number of ints lattice_key_compute() may write for the city.
 ****************************************************************************/
-static void compute_tile_production(const struct city *pcity,
-                                    const struct tile *ptile,
-                                    struct cm_tile_type *out)
+static int lattice_key_max_len(const struct city *pcity)
+{
+  return 3 + (city_map_tiles_from_city(pcity) + SP_MAX) * (1 + O_LAST);
+}
+
+/************************************************************************//**
+  Fill 'key' with everything the tile-type lattice of the city is built
+  from: the city size and radius, then the city map index and production
+  of each workable tile, a -1 separator, and the id and production of each
+  specialist the city can use.  Returns the number of ints written.
+****************************************************************************/
+static int lattice_key_compute(const struct city *pcity, int *key)
 {
   bool is_celebrating = base_city_celebrating(pcity);
+  int radius_sq = city_map_radius_sq_get(pcity);
+  int len = 0;
 
-  output_type_iterate(o) {
-    out->production[o] = city_tile_output(pcity, ptile, is_celebrating, o);
-  } output_type_iterate_end;
+  key[len++] = city_size_get(pcity);
+  key[len++] = radius_sq;
+
+  city_tile_iterate_index(radius_sq, city_tile(pcity), ptile, ctindex) {
+    if (is_free_worked(pcity, ptile)) {
+      continue;
+    } else if (city_can_work_tile(pcity, ptile)) {
+      key[len++] = ctindex;
+      output_type_iterate(o) {
+        key[len++] = city_tile_output(pcity, ptile, is_celebrating, o);
+      } output_type_iterate_end;
+    }
+  } city_tile_iterate_index_end;
+
+  key[len++] = -1;
+
+  /* the production of a specialist is the bonus for the specialist (if
+   * the city is allowed to use it) */
+  specialist_type_iterate(i) {
+    if (city_can_use_specialist(pcity, i)) {
+      key[len++] = i;
+      output_type_iterate(o) {
+        key[len++] = get_specialist_output(pcity, i, o);
+      } output_type_iterate_end;
+    }
+  } specialist_type_iterate_end;
+
+  fc_assert(len <= lattice_key_max_len(pcity));
+
+  return len;
 }
 
 /************************************************************************//**
@@ -986,36 +1100,6 @@ static void tile_type_lattice_add(struct tile_type_vector *lattice,
   }
 }
 
-/*
- * Add the specialist types to the lattice.
- */
-
-/************************************************************************//**
-  Create lattice nodes for each type of specialist.  This adds a new
-  tile_type for each specialist type.
-****************************************************************************/
-static void init_specialist_lattice_nodes(struct tile_type_vector *lattice,
-                                          const struct city *pcity)
-{
-  struct cm_tile_type type;
-
-  tile_type_init(&type);
-  type.is_specialist = TRUE;
-
-  /* for each specialist type, create a tile_type that has as production
-   * the bonus for the specialist (if the city is allowed to use it) */
-  specialist_type_iterate(i) {
-    if (city_can_use_specialist(pcity, i)) {
-      type.spec = i;
-      output_type_iterate(output) {
-        type.production[output] = get_specialist_output(pcity, i, output);
-      } output_type_iterate_end;
-
-      tile_type_lattice_add(lattice, &type, 0);
-    }
-  } specialist_type_iterate_end;
-}
-
 /************************************************************************//**
   Topologically sort the lattice.
   Sets the lattice_depth field.
@@ -1179,7 +1263,8 @@ static void sort_lattice_by_fitness(const struct cm_state *state,
 {
   int i;
 
-  /* compute fitness */
+  /* compute fitness; the tile types are the city's cached ones, which
+   * no other query uses meanwhile */
   tile_type_vector_iterate(lattice, ptype) {
     ptype->estimated_fitness = estimate_fitness(state, ptype->production);
   } tile_type_vector_iterate_end;
@@ -1198,29 +1283,38 @@ static void sort_lattice_by_fitness(const struct cm_state *state,
 }
 
 /************************************************************************//**
-  Create the lattice.
+  Create the lattice from a key made by lattice_key_compute().
 ****************************************************************************/
-static void init_tile_lattice(struct city *pcity,
+static void init_tile_lattice(const struct city *pcity,
+                              const int *key, int key_len,
                               struct tile_type_vector *lattice)
 {
   struct cm_tile_type type;
-  struct tile *pcenter = city_tile(pcity);
+  int i = 2;
 
   /* add all the fields into the lattice */
   tile_type_init(&type); /* init just once */
 
-  city_tile_iterate_index(city_map_radius_sq_get(pcity), pcenter, ptile,
-                          ctindex) {
-    if (is_free_worked(pcity, ptile)) {
-      continue;
-    } else if (city_can_work_tile(pcity, ptile)) {
-      compute_tile_production(pcity, ptile, &type); /* clobbers type */
-      tile_type_lattice_add(lattice, &type, ctindex); /* copy type if needed */
-    }
-  } city_tile_iterate_index_end;
+  while (key[i] >= 0) {
+    int ctindex = key[i++];
 
-  /* Add all the specialists into the lattice.  */
-  init_specialist_lattice_nodes(lattice, pcity);
+    output_type_iterate(o) {
+      type.production[o] = key[i++];
+    } output_type_iterate_end;
+    tile_type_lattice_add(lattice, &type, ctindex); /* copy type if needed */
+  }
+  i++;
+
+  /* Add all the specialists into the lattice; each specialist type is a
+   * tile_type of its own. */
+  type.is_specialist = TRUE;
+  while (i < key_len) {
+    type.spec = key[i++];
+    output_type_iterate(o) {
+      type.production[o] = key[i++];
+    } output_type_iterate_end;
+    tile_type_lattice_add(lattice, &type, 0);
+  }
 
   /* Set the lattice_depth fields, and clean up unreachable nodes. */
   top_sort_lattice(lattice);
@@ -1230,6 +1324,61 @@ static void init_tile_lattice(struct city *pcity,
   print_lattice(LOG_LATTICE, lattice);
 }
 
+/************************************************************************//**
+  Return the cached lattice of the city, building it first if the city
+  has none yet or if anything it depends on changed since.  It is the
+  caller's until lattice_cache_release().
+****************************************************************************/
+static struct cm_lattice_cache *lattice_cache_get(const struct city *pcity)
+{
+  int key[lattice_key_max_len(pcity)];
+  int key_len = lattice_key_compute(pcity, key);
+  struct cm_lattice_cache *pcache;
+
+  fc_allocate_mutex(&lattice_cache_mutex);
+  if (lattice_cache == NULL) {
+    lattice_cache = cm_lattice_hash_new();
+  }
+  if (!cm_lattice_hash_lookup(lattice_cache, pcity->id, &pcache)) {
+    pcache = fc_calloc(1, sizeof(*pcache));
+    tile_type_vector_init(&pcache->lattice);
+    cm_lattice_hash_insert(lattice_cache, pcity->id, pcache);
+  }
+  /* Two queries for the same city at once would mix up the lattice
+   * indices and fitness they write into the shared tile types. */
+  fc_assert(!pcache->in_use);
+  pcache->in_use = TRUE;
+  fc_release_mutex(&lattice_cache_mutex);
+
+  if (pcache->key_len == key_len
+      && 0 == memcmp(pcache->key, key, key_len * sizeof(*key))) {
+#ifdef GATHER_TIME_STATS
+    performance.opt.lattice_reuse_count++;
+#endif
+    return pcache;
+  }
+
+  pcache->key = fc_realloc(pcache->key, key_len * sizeof(*key));
+  memcpy(pcache->key, key, key_len * sizeof(*key));
+  pcache->key_len = key_len;
+
+  tile_type_vector_free_all(&pcache->lattice);
+  tile_type_vector_init(&pcache->lattice);
+  init_tile_lattice(pcity, key, key_len, &pcache->lattice);
+
+  return pcache;
+}
+
+/************************************************************************//**
+  Let other queries use the lattice got from lattice_cache_get().
+****************************************************************************/
+static void lattice_cache_release(struct cm_lattice_cache *pcache)
+{
+  fc_allocate_mutex(&lattice_cache_mutex);
+  pcache->in_use = FALSE;
+  fc_release_mutex(&lattice_cache_mutex);
+}
+
 
 /****************************************************************************
 
@@ -1789,10 +1938,17 @@ static bool bb_next(struct cm_state *state, bool negative_ok)
     struct cm_fitness value = evaluate_solution(state, &state->current);
 
     print_partial_solution(LOG_REACHED_LEAF, &state->current, state);
-    if (fitness_better(value, state->best_value)) {
+    /* A solution as good as the warm start seed replaces it too.  That
+     * doesn't make the result independent of the city's arrangement:
+     * choice_is_promising() prunes against the seed, so of several
+     * equally good solutions the existing one may be kept. */
+    if (fitness_better(value, state->best_value)
+        || (state->best_is_seed
+            && !fitness_better(state->best_value, value))) {
       log_base(LOG_BETTER_LEAF, "-> replaces previous best");
       copy_partial_solution(&state->best, &state->current, state);
       state->best_value = value;
+      state->best_is_seed = FALSE;
     }
   }
 
@@ -1823,7 +1979,8 @@ static struct cm_state *cm_state_init(struct city *pcity, bool negative_ok)
 {
   const int SCIENCE = 0, TAX = 1, LUXURY = 2;
   const struct player *pplayer = city_owner(pcity);
-  int numtypes;
+  int numtypes, i;
+  struct cm_type_by_stat *by_stat;
   struct cm_state *state = fc_malloc(sizeof(*state));
   int rates[3];
 
@@ -1833,37 +1990,59 @@ static struct cm_state *cm_state_init(struct city *pcity, bool negative_ok)
   /* copy the arguments */
   state->pcity = pcity;
 
-  /* create the lattice */
+  /* get the lattice, restoring the order it was built in; the indices
+   * are written into the cached tile types, which is fine as no other
+   * query uses them now (see struct cm_lattice_cache) */
+  state->cache = lattice_cache_get(pcity);
   tile_type_vector_init(&state->lattice);
-  init_tile_lattice(pcity, &state->lattice);
+  tile_type_vector_copy(&state->lattice, &state->cache->lattice);
   numtypes = tile_type_vector_size(&state->lattice);
+  for (i = 0; i < numtypes; i++) {
+    state->lattice.p[i]->lattice_index = i;
+  }
 
   get_tax_rates(pplayer, rates);
 
   /* For the heuristic, make sorted copies of the lattice */
+  by_stat = fc_malloc(MAX(numtypes, 1) * sizeof(*by_stat));
   output_type_iterate(stat_index) {
+    double trade_bonus;
+
     tile_type_vector_init(&state->lattice_by_prod[stat_index]);
     tile_type_vector_copy(&state->lattice_by_prod[stat_index], &state->lattice);
-    compare_key = stat_index;
     /* calculate effect of 1 trade production on interesting production */
     switch (stat_index) {
       case O_SCIENCE:
-        compare_key_trade_bonus = rates[SCIENCE] * pcity->bonus[O_TRADE] / 100.0;
+        trade_bonus = rates[SCIENCE] * pcity->bonus[O_TRADE] / 100.0;
         break;
       case O_LUXURY:
-        compare_key_trade_bonus = rates[LUXURY] * pcity->bonus[O_TRADE] / 100.0;
+        trade_bonus = rates[LUXURY] * pcity->bonus[O_TRADE] / 100.0;
         break;
       case O_GOLD:
-        compare_key_trade_bonus = rates[TAX] * pcity->bonus[O_TRADE] / 100.0;
+        trade_bonus = rates[TAX] * pcity->bonus[O_TRADE] / 100.0;
         break;
       default:
-        compare_key_trade_bonus = 0.0;
+        trade_bonus = 0.0;
         break;
     }
-    qsort(state->lattice_by_prod[stat_index].p, state->lattice_by_prod[stat_index].size,
-          sizeof(*state->lattice_by_prod[stat_index].p),
-          compare_tile_type_by_stat);
+
+    /* consider the influence of trade on science, luxury, gold
+       for compute_max_stats_heuristics, which uses these sorted arrays,
+       it is essential, that the sorting is correct, else promising
+       branches get pruned */
+    for (i = 0; i < numtypes; i++) {
+      struct cm_tile_type *ptype = state->lattice_by_prod[stat_index].p[i];
+
+      by_stat[i].value = ptype->production[stat_index]
+                         + trade_bonus * ptype->production[O_TRADE];
+      by_stat[i].ptype = ptype;
+    }
+    qsort(by_stat, numtypes, sizeof(*by_stat), compare_tile_type_by_stat);
+    for (i = 0; i < numtypes; i++) {
+      state->lattice_by_prod[stat_index].p[i] = by_stat[i].ptype;
+    }
   } output_type_iterate_end;
+  free(by_stat);
 
   state->min_luxury = - FC_INFINITY;
 
@@ -1871,6 +2050,7 @@ static struct cm_state *cm_state_init(struct city *pcity, bool negative_ok)
   init_partial_solution(&state->best, numtypes, city_size_get(pcity),
                         negative_ok);
   state->best_value = worst_fitness();
+  state->best_is_seed = FALSE;
 
   /* Initialize the current solution and choice stack to empty */
   init_partial_solution(&state->current, numtypes, city_size_get(pcity),
@@ -1962,6 +2142,7 @@ static void begin_search(struct cm_state *state,
 
   /* clear out the old solution */
   state->best_value = worst_fitness();
+  state->best_is_seed = FALSE;
   destroy_partial_solution(&state->current);
   init_partial_solution(&state->current, num_types(state),
                         city_size_get(state->pcity),
@@ -1991,10 +2172,12 @@ static void end_search(struct cm_state *state)
 ****************************************************************************/
 static void cm_state_free(struct cm_state *state)
 {
-  tile_type_vector_free_all(&state->lattice);
+  /* the tile types belong to the lattice cache */
+  tile_type_vector_free(&state->lattice);
   output_type_iterate(stat_index) {
     tile_type_vector_free(&state->lattice_by_prod[stat_index]);
   } output_type_iterate_end;
+  lattice_cache_release(state->cache);
   destroy_partial_solution(&state->best);
   destroy_partial_solution(&state->current);
 
@@ -2003,6 +2186,94 @@ static void cm_state_free(struct cm_state *state)
   FC_FREE(state);
 }
 
+/************************************************************************//**
+  Seed the search with the arrangement the city currently has.  That is
+  usually the result of the previous query, and after a small change to
+  the city still close to the best one, so starting from it lets the
+  heuristic prune most branches right away.  The seed is dropped if the
+  current arrangement can't be expressed on the lattice (the city grew,
+  or works a tile that is no longer available) or doesn't satisfy the
+  parameter.  Returns TRUE iff the seed was kept.
+****************************************************************************/
+static bool init_warm_start(struct cm_state *state, bool negative_ok)
+{
+  struct city *pcity = state->pcity;
+  const struct cm_tile_type *by_index[city_map_tiles_from_city(pcity)];
+  int counts[num_types(state)];
+  int citizens = 0, min_luxury = state->min_luxury;
+  int i, j;
+  struct cm_fitness value;
+
+  memset(by_index, 0, sizeof(by_index));
+  memset(counts, 0, sizeof(counts));
+
+  for (i = 0; i < num_types(state); i++) {
+    const struct cm_tile_type *ptype = tile_type_get(state, i);
+
+    if (ptype->is_specialist) {
+      continue;
+    }
+    for (j = 0; j < tile_vector_size(&ptype->tiles); j++) {
+      by_index[tile_get(ptype, j)->index] = ptype;
+    }
+  }
+
+  city_tile_iterate_index(city_map_radius_sq_get(pcity), city_tile(pcity),
+                          ptile, ctindex) {
+    if (tile_worked(ptile) != pcity || is_free_worked(pcity, ptile)) {
+      continue;
+    }
+    if (by_index[ctindex] == NULL) {
+      return FALSE;
+    }
+    counts[by_index[ctindex]->lattice_index]++;
+    citizens++;
+  } city_tile_iterate_index_end;
+
+  specialist_type_iterate(sp) {
+    if (pcity->specialists[sp] == 0) {
+      continue;
+    }
+    for (i = 0; i < num_types(state); i++) {
+      const struct cm_tile_type *ptype = tile_type_get(state, i);
+
+      if (ptype->is_specialist && ptype->spec == sp) {
+        break;
+      }
+    }
+    if (i == num_types(state)) {
+      return FALSE;
+    }
+    counts[i] += pcity->specialists[sp];
+    citizens += pcity->specialists[sp];
+  } specialist_type_iterate_end;
+
+  if (citizens != city_size_get(pcity)) {
+    return FALSE;
+  }
+
+  for (i = 0; i < num_types(state); i++) {
+    add_workers(&state->best, i, counts[i], state);
+  }
+
+  value = evaluate_solution(state, &state->best);
+  if (!value.sufficient) {
+    /* Any solution the search finds would replace it anyway, and the
+     * production of an insufficient seed may prune the ones that don't
+     * fall short. */
+    destroy_partial_solution(&state->best);
+    init_partial_solution(&state->best, num_types(state),
+                          city_size_get(pcity), negative_ok);
+    state->min_luxury = min_luxury;
+    return FALSE;
+  }
+
+  state->best_value = value;
+  state->best_is_seed = TRUE;
+
+  return TRUE;
+}
+
 /************************************************************************//**
   Run B&B until we find the best solution.
 ****************************************************************************/
@@ -2031,6 +2302,12 @@ static void cm_find_best_solution(struct cm_state *state,
 
   result->aborted = FALSE;
 
+  if (init_warm_start(state, negative_ok)) {
+#ifdef GATHER_TIME_STATS
+    performance.current->warm_start_count++;
+#endif
+  }
+
   /* search until we find a feasible solution */
   while (!bb_next(state, negative_ok)) {
     /* Limit the number of loops. */
@@ -2044,6 +2321,12 @@ static void cm_find_best_solution(struct cm_state *state,
     }
   }
 
+#ifdef GATHER_TIME_STATS
+  if (state->best_is_seed) {
+    performance.current->warm_start_kept_count++;
+  }
+#endif
+
   /* convert to the caller's format */
   convert_solution_to_result(state, &state->best, result);
 
@@ -2071,6 +2354,155 @@ void cm_query_result(struct city *pcity,
   cm_state_free(state);
 }
 
+/************************************************************************//**
+  Split the queries of the batch into groups, each to be solved by a
+  single thread in the order of the queries.  Cities linked by a trade
+  route read each other while the CM tries arrangements on them, so they
+  must be in the same group.
+****************************************************************************/
+static void cm_batch_make_groups(struct cm_batch *batch, int num_queries)
+{
+  struct cm_query_index_hash *indices = cm_query_index_hash_new();
+  int parent[num_queries], last[num_queries];
+  int i;
+
+  for (i = 0; i < num_queries; i++) {
+    bool added = cm_query_index_hash_insert(indices,
+                                            batch->queries[i].pcity->id, i);
+
+    fc_assert(added);
+    parent[i] = i;
+  }
+
+  /* Join the groups of trading cities, the group taking the smallest
+   * index of the two. */
+  for (i = 0; i < num_queries; i++) {
+    trade_routes_iterate(batch->queries[i].pcity, proute) {
+      int root_i = i, root_j;
+
+      if (!cm_query_index_hash_lookup(indices, proute->partner, &root_j)) {
+        continue;
+      }
+      while (parent[root_i] != root_i) {
+        root_i = parent[root_i];
+      }
+      while (parent[root_j] != root_j) {
+        root_j = parent[root_j];
+      }
+      if (root_i < root_j) {
+        parent[root_j] = root_i;
+      } else {
+        parent[root_i] = root_j;
+      }
+    } trade_routes_iterate_end;
+  }
+
+  /* Link the queries of each group in order.  The first query of a group
+   * is its root. */
+  batch->num_groups = 0;
+  for (i = 0; i < num_queries; i++) {
+    int root = i;
+
+    while (parent[root] != root) {
+      root = parent[root];
+    }
+    batch->next_in_group[i] = -1;
+    if (root == i) {
+      batch->groups[batch->num_groups++] = i;
+    } else {
+      batch->next_in_group[last[root]] = i;
+    }
+    last[root] = i;
+  }
+
+  cm_query_index_hash_destroy(indices);
+}
+
+/************************************************************************//**
+  Solving thread: solve the groups of queries of the batch until there
+  are none left.
+****************************************************************************/
+static void cm_batch_thread(void *arg)
+{
+  struct cm_batch *batch = (struct cm_batch *) arg;
+  int group, i;
+
+  do {
+    fc_allocate_mutex(&batch->mutex);
+    if (batch->next_group < batch->num_groups) {
+      group = batch->groups[batch->next_group++];
+    } else {
+      group = -1;
+    }
+    fc_release_mutex(&batch->mutex);
+
+    for (i = group; i >= 0; i = batch->next_in_group[i]) {
+      struct cm_query *query = &batch->queries[i];
+
+      cm_query_result(query->pcity, query->parameter, query->result,
+                      query->negative_ok);
+    }
+  } while (group >= 0);
+}
+
+/************************************************************************//**
+  Run the queries of several cities at once, using up to 'num_threads'
+  threads.  Each query only changes its own city, and restores it before
+  returning, so the results are those cm_query_result() would give for
+  each city in turn, whatever the number of threads.
+****************************************************************************/
+void cm_query_result_batch(struct cm_query *queries, int num_queries,
+                           int num_threads)
+{
+  struct cm_batch batch;
+  fc_thread threads[CM_MAX_THREADS];
+  bool parallel;
+  int i;
+
+  if (0 == num_queries) {
+    return;
+  }
+
+#ifdef GATHER_TIME_STATS
+  /* The time statistics are not thread safe. */
+  num_threads = 1;
+#endif
+
+  batch.queries = queries;
+  batch.next_in_group = fc_malloc(num_queries * sizeof(*batch.next_in_group));
+  batch.groups = fc_malloc(num_queries * sizeof(*batch.groups));
+  batch.next_group = 0;
+  cm_batch_make_groups(&batch, num_queries);
+
+  fc_init_mutex(&batch.mutex);
+
+  /* The main thread solves too. */
+  num_threads = MIN(MIN(num_threads, CM_MAX_THREADS), batch.num_groups) - 1;
+  parallel = (0 < num_threads);
+  if (parallel) {
+    /* Lookups may not fill the effect cache from several threads. */
+    effect_cache_freeze(TRUE);
+  }
+  for (i = 0; i < num_threads; i++) {
+    if (0 != fc_thread_start(&threads[i], cm_batch_thread, &batch)) {
+      log_error("Failed to start CM thread.");
+      num_threads = i;
+      break;
+    }
+  }
+  cm_batch_thread(&batch);
+  for (i = 0; i < num_threads; i++) {
+    fc_thread_wait(&threads[i]);
+  }
+  if (parallel) {
+    effect_cache_freeze(FALSE);
+  }
+
+  fc_destroy_mutex(&batch.mutex);
+  free(batch.next_in_group);
+  free(batch.groups);
+}
+
 /************************************************************************//**
   Returns true if the two cm_parameters are equal.
 ****************************************************************************/
@@ -2355,8 +2787,11 @@ static void print_performance(struct one_perf *counts)
   applies = counts->apply_count;
 
   log_base(LOG_TIME_STATS,
-           "CM-%s: overall=%fs queries=%d %fms / query, %d applies",
-           counts->name, s, queries, ms / q, applies);
+           "CM-%s: overall=%fs queries=%d %fms / query, %d applies, "
+           "%d lattices reused, %d warm starts (%d kept)",
+           counts->name, s, queries, ms / q, applies,
+           counts->lattice_reuse_count, counts->warm_start_count,
+           counts->warm_start_kept_count);
 }
 #endif /* GATHER_TIME_STATS */
 
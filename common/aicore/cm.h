@@ -77,9 +77,28 @@ void cm_query_result(struct city *pcity,
                      const struct cm_parameter *const parameter,
                      struct cm_result *result, bool negative_ok);
 
+/* The arguments of one cm_query_result() call of a batch. */
+struct cm_query {
+  struct city *pcity;
+  const struct cm_parameter *parameter;
+  struct cm_result *result;
+  bool negative_ok;
+};
+
+#define CM_MAX_THREADS 64
+
+/*
+ * Like cm_query_result() for each of the queries, solved by up to
+ * 'num_threads' threads.  The cities must all be different, and nothing
+ * else may run meanwhile.
+ */
+void cm_query_result_batch(struct cm_query *queries, int num_queries,
+                           int num_threads);
+
 /*
- * Call this function if the city has changed. To be safe call it
- * everytime before you call cm_query_result().
+ * Releases what the CM keeps for the city between queries.  That is
+ * checked against the city at every query, so this is only needed when
+ * the city goes away.
  */
 void cm_clear_cache(struct city *pcity);
 
@@ -15,8 +15,11 @@
 #include <fc_config.h>
 #endif
 
+#include <limits.h>
+
 /* utility */
 #include "bitvector.h"
+#include "fcthread.h"
 #include "log.h"
 #include "mem.h"
 #include "support.h"
@@ -25,6 +28,8 @@
 #include "game.h"
 #include "map.h"
 #include "movement.h"
+#include "road.h"
+#include "terrain.h"
 
 /* common/aicore */
 #include "pf_tools.h"
@@ -56,7 +61,8 @@ enum pf_mode {
 #endif /* PF_DEBUG */
 
 enum pf_node_status {
-  NS_UNINIT = 0,        /* memory is calloced, hence zero means
+  NS_UNINIT = 0,        /* node memory is zeroed on first access (see
+                         * pf_lattice_node()), hence zero means
                          * uninitialised. */
   NS_INIT,              /* node initialized, but we didn't search a route
                          * yet. */
@@ -91,11 +97,221 @@ struct pf_map {
   /* Private data. */
   struct tile *tile;          /* The current position (aka iterator). */
   struct pf_parameter params; /* Initial parameters. */
+  struct pf_shared_map *shared; /* Cache entry, see pf_map_new_shared(). */
 };
 
 /* Down-cast macro. */
 #define PF_MAP(pfm) ((struct pf_map *) (pfm))
 
+/* Node storage of pf_normal_map, pf_danger_map and pf_fuel_map. Lattices
+ * are recycled through the pool below instead of being allocated for every
+ * map. To avoid clearing the whole lattice at each reuse, every node has a
+ * generation stamp: a node whose stamp doesn't match the generation of the
+ * lattice belongs to a previous search and is zeroed on first access. */
+struct pf_lattice {
+  size_t node_size;             /* Size of a single node. */
+  int num_nodes;                /* Number of nodes (MAP_INDEX_SIZE). */
+  unsigned int generation;      /* Stamp of the current search. */
+  unsigned int *stamps;         /* Generation stamp of every node. */
+  void *nodes;                  /* The nodes themselves. */
+};
+
+/* Maximum number of unused lattices and queues kept in the pool. Several
+ * maps are often alive at the same time (e.g. nested searches for ferries
+ * and their passengers), so keep a few of each. */
+#define PF_POOL_SIZE 8
+
+/* Pool of lattices and priority queues. */
+static struct {
+  bool initialized;
+  fc_mutex mutex;
+  int num_lattices;
+  struct pf_lattice *lattices[PF_POOL_SIZE];
+  int num_queues;
+  struct map_index_pq *queues[2 * PF_POOL_SIZE];
+} pf_pool;
+
+/* ============================ Pool functions =========================== */
+
+/************************************************************************//**
+  Free a lattice.
+****************************************************************************/
+static void pf_lattice_destroy(struct pf_lattice *lattice)
+{
+  free(lattice->stamps);
+  free(lattice->nodes);
+  free(lattice);
+}
+
+/************************************************************************//**
+  Get a lattice of 'node_size' sized nodes for the current map, from the
+  pool if possible. All nodes of the returned lattice are considered
+  uninitialized.
+****************************************************************************/
+static struct pf_lattice *pf_lattice_get(size_t node_size)
+{
+  struct pf_lattice *lattice = NULL;
+
+  if (pf_pool.initialized) {
+    int i;
+
+    fc_allocate_mutex(&pf_pool.mutex);
+    for (i = pf_pool.num_lattices - 1; i >= 0; i--) {
+      struct pf_lattice *pooled = pf_pool.lattices[i];
+
+      if (pooled->num_nodes != MAP_INDEX_SIZE) {
+        /* Made for a previous map. */
+        pf_pool.lattices[i] = pf_pool.lattices[--pf_pool.num_lattices];
+        pf_lattice_destroy(pooled);
+      } else if (NULL == lattice && pooled->node_size == node_size) {
+        pf_pool.lattices[i] = pf_pool.lattices[--pf_pool.num_lattices];
+        lattice = pooled;
+      }
+    }
+    fc_release_mutex(&pf_pool.mutex);
+  }
+
+  if (NULL != lattice) {
+    /* Invalidate all nodes of the previous search. */
+    if (0 == ++lattice->generation) {
+      memset(lattice->stamps, 0, lattice->num_nodes
+                                 * sizeof(*lattice->stamps));
+      lattice->generation = 1;
+    }
+    return lattice;
+  }
+
+  lattice = fc_malloc(sizeof(*lattice));
+  lattice->node_size = node_size;
+  lattice->num_nodes = MAP_INDEX_SIZE;
+  lattice->generation = 1;
+  lattice->stamps = fc_calloc(lattice->num_nodes, sizeof(*lattice->stamps));
+  lattice->nodes = fc_malloc(lattice->num_nodes * node_size);
+
+  return lattice;
+}
+
+/************************************************************************//**
+  Give back a lattice to the pool, or free it if the pool is full.
+****************************************************************************/
+static void pf_lattice_release(struct pf_lattice *lattice)
+{
+  if (pf_pool.initialized) {
+    fc_allocate_mutex(&pf_pool.mutex);
+    if (PF_POOL_SIZE > pf_pool.num_lattices) {
+      pf_pool.lattices[pf_pool.num_lattices++] = lattice;
+      lattice = NULL;
+    }
+    fc_release_mutex(&pf_pool.mutex);
+  }
+
+  if (NULL != lattice) {
+    pf_lattice_destroy(lattice);
+  }
+}
+
+/************************************************************************//**
+  Returns TRUE iff the node at 'tindex' was accessed during the current
+  search.
+****************************************************************************/
+static inline bool pf_lattice_node_used(const struct pf_lattice *lattice,
+                                        int tindex)
+{
+  return lattice->stamps[tindex] == lattice->generation;
+}
+
+/************************************************************************//**
+  Returns the node at 'tindex'. If it was not accessed yet during the
+  current search, it is zeroed first, i.e. it gets the NS_UNINIT status.
+****************************************************************************/
+static inline void *pf_lattice_node(struct pf_lattice *lattice, int tindex)
+{
+  void *node = (char *) lattice->nodes + tindex * lattice->node_size;
+
+  if (lattice->stamps[tindex] != lattice->generation) {
+    memset(node, 0, lattice->node_size);
+    lattice->stamps[tindex] = lattice->generation;
+  }
+
+  return node;
+}
+
+/************************************************************************//**
+  Get an empty priority queue, from the pool if possible.
+****************************************************************************/
+static struct map_index_pq *pf_queue_get(void)
+{
+  struct map_index_pq *queue = NULL;
+
+  if (pf_pool.initialized) {
+    fc_allocate_mutex(&pf_pool.mutex);
+    if (0 < pf_pool.num_queues) {
+      queue = pf_pool.queues[--pf_pool.num_queues];
+    }
+    fc_release_mutex(&pf_pool.mutex);
+  }
+
+  if (NULL != queue) {
+    map_index_pq_clear(queue);
+    return queue;
+  }
+
+  return map_index_pq_new(INITIAL_QUEUE_SIZE);
+}
+
+/************************************************************************//**
+  Give back a priority queue to the pool, or free it if the pool is full.
+****************************************************************************/
+static void pf_queue_release(struct map_index_pq *queue)
+{
+  if (pf_pool.initialized) {
+    fc_allocate_mutex(&pf_pool.mutex);
+    if (ARRAY_SIZE(pf_pool.queues) > pf_pool.num_queues) {
+      pf_pool.queues[pf_pool.num_queues++] = queue;
+      queue = NULL;
+    }
+    fc_release_mutex(&pf_pool.mutex);
+  }
+
+  if (NULL != queue) {
+    map_index_pq_destroy(queue);
+  }
+}
+
+/************************************************************************//**
+  Initialize the pool of lattices and priority queues.
+****************************************************************************/
+void pf_map_pool_init(void)
+{
+  fc_assert_ret(!pf_pool.initialized);
+
+  fc_init_mutex(&pf_pool.mutex);
+  pf_pool.num_lattices = 0;
+  pf_pool.num_queues = 0;
+  pf_pool.initialized = TRUE;
+}
+
+/************************************************************************//**
+  Free the pool of lattices and priority queues.
+****************************************************************************/
+void pf_map_pool_free(void)
+{
+  if (!pf_pool.initialized) {
+    return;
+  }
+
+  fc_allocate_mutex(&pf_pool.mutex);
+  while (0 < pf_pool.num_lattices) {
+    pf_lattice_destroy(pf_pool.lattices[--pf_pool.num_lattices]);
+  }
+  while (0 < pf_pool.num_queues) {
+    map_index_pq_destroy(pf_pool.queues[--pf_pool.num_queues]);
+  }
+  pf_pool.initialized = FALSE;
+  fc_release_mutex(&pf_pool.mutex);
+  fc_destroy_mutex(&pf_pool.mutex);
+}
+
 /* ========================== Common functions =========================== */
 
 /************************************************************************//**
@@ -228,8 +444,14 @@ struct pf_normal_map {
 
   struct map_index_pq *queue; /* Queue of nodes we have reached but not
                                * processed yet (NS_NEW), sorted by their
-                               * total_CC. */
-  struct pf_normal_node *lattice; /* Lattice of nodes. */
+                               * total_CC (plus the estimated remaining
+                               * cost for goal-directed searches). */
+  struct pf_lattice *lattice; /* Lattice of nodes. */
+
+  /* Goal-directed search, see 'goal_directed' in struct pf_parameter. */
+  bool goal_pending;          /* The goal can still be set. */
+  struct tile *goal;          /* The destination, or NULL. */
+  int min_move_cost;          /* The cheapest possible single move. */
 };
 
 /* Up-cast macro. */
@@ -249,6 +471,15 @@ pf_normal_map_check(struct pf_map *pfm, const char *file,
 #define PF_NORMAL_MAP(pfm) ((struct pf_normal_map *) (pfm))
 #endif /* PF_DEBUG */
 
+/************************************************************************//**
+  Returns the node at 'tindex'.
+****************************************************************************/
+static inline struct pf_normal_node *
+pf_normal_map_node(const struct pf_normal_map *pfnm, int tindex)
+{
+  return pf_lattice_node(pfnm->lattice, tindex);
+}
+
 /* ================  Specific pf_normal_* mode functions ================= */
 
 /************************************************************************//**
@@ -328,7 +559,7 @@ static inline bool pf_normal_node_init(struct pf_normal_map *pfnm,
       node->action = action;
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
     } else {
-      /* Nodes are allocated by fc_calloc(), so should be already set to
+      /* Nodes are zeroed by pf_lattice_node(), so should be already set to
        * 0. */
       node->action = PF_ACTION_NONE;
 #endif
@@ -365,7 +596,7 @@ static inline bool pf_normal_node_init(struct pf_normal_map *pfnm,
                           ? ZOC_ALLIED : ZOC_NO);
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
     } else {
-      /* Nodes are allocated by fc_calloc(), so should be already set to
+      /* Nodes are zeroed by pf_lattice_node(), so should be already set to
        * 0. */
       node->zoc_number = ZOC_MINE;
 #endif
@@ -373,7 +604,7 @@ static inline bool pf_normal_node_init(struct pf_normal_map *pfnm,
   } else {
     node->move_scope = PF_MS_NATIVE;
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
-    /* Nodes are allocated by fc_calloc(), so  should be already set to 0. */
+    /* Nodes are zeroed by pf_lattice_node(), so should be already set to 0. */
     node->action = PF_ACTION_NONE;
     node->zoc_number = ZOC_MINE;
 #endif
@@ -384,7 +615,7 @@ static inline bool pf_normal_node_init(struct pf_normal_map *pfnm,
     node->extra_tile = params->get_EC(ptile, node_known_type, params);
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
   } else {
-    /* Nodes are allocated by fc_calloc(), so  should be already set to 0. */
+    /* Nodes are zeroed by pf_lattice_node(), so should be already set to 0. */
     node->extra_tile = 0;
 #endif
   }
@@ -392,6 +623,93 @@ static inline bool pf_normal_node_init(struct pf_normal_map *pfnm,
   return TRUE;
 }
 
+/************************************************************************//**
+  Returns the cost of the cheapest single move the unit type could ever
+  do with the standard move cost callbacks. It can be 0, e.g. with
+  railroads, and then no estimation of the remaining cost can be done.
+****************************************************************************/
+static int pf_normal_map_min_move_cost(const struct pf_parameter *params)
+{
+  const struct unit_class *pclass = utype_class(params->utype);
+  int min_mc;
+
+  /* Moves to unknown tiles, actions, non-native tiles and transports. */
+  min_mc = MIN(SINGLE_MOVE, params->utype->unknown_move_cost);
+  min_mc = MIN(min_mc, params->move_rate);
+
+  if (uclass_has_flag(pclass, UCF_TERRAIN_SPEED)) {
+    terrain_type_iterate(pterrain) {
+      min_mc = MIN(min_mc, pterrain->movement_cost * SINGLE_MOVE);
+    } terrain_type_iterate_end;
+
+    extra_type_list_iterate(pclass->cache.bonus_roads, pextra) {
+      min_mc = MIN(min_mc, extra_road_get(pextra)->move_cost);
+    } extra_type_list_iterate_end;
+
+    if (utype_has_flag(params->utype, UTYF_IGTER)) {
+      min_mc = MIN(min_mc, MOVE_COST_IGTER);
+    }
+  }
+
+  return MAX(min_mc, 0);
+}
+
+/************************************************************************//**
+  Returns a lower bound of the cost still needed to reach the goal from
+  'ptile', when 'ptile' is reached with 'cost'. As every step costs at
+  least 'min_move_cost', but a step can always be done with the moves
+  left of the turn (see pf_normal_map_adjust_cost()), the bound counts the
+  turns needed to do the remaining steps at that rate.
+
+  The bound never decreases by more than the cost of a step, so the nodes
+  are still processed with their best cost (i.e. it is consistent).
+****************************************************************************/
+static inline int pf_normal_map_estimate(const struct pf_normal_map *pfnm,
+                                         const struct tile *ptile, int cost)
+{
+  const struct pf_parameter *params = pf_map_parameter(PF_MAP(pfnm));
+  int move_rate = pf_move_rate(params);
+  int min_mc = pfnm->min_move_cost;
+  int dist, moves_left, steps, turns, estimate;
+
+  if (NULL == pfnm->goal) {
+    return 0;
+  }
+
+  dist = real_map_distance(ptile, pfnm->goal);
+  moves_left = pf_moves_left(params, cost);
+
+  /* Steps doable during the current turn. */
+  steps = (moves_left + min_mc - 1) / min_mc;
+  if (dist <= steps) {
+    return MIN(dist * min_mc, moves_left);
+  }
+  dist -= steps;
+  estimate = moves_left;
+
+  /* Complete turns, then the last one. */
+  steps = (move_rate + min_mc - 1) / min_mc;
+  turns = (dist - 1) / steps;
+  dist -= turns * steps;
+  estimate += turns * move_rate + MIN(dist * min_mc, move_rate);
+
+  /* Costs cannot be higher anyway, see 'cost' in struct pf_normal_node. */
+  return MIN(estimate, MAX(SHRT_MAX - cost, 0));
+}
+
+/************************************************************************//**
+  Returns the priority of a node in the queue: the total_CC, plus the
+  estimated remaining cost for goal-directed searches. As we prefer lower
+  costs, it is reversed.
+****************************************************************************/
+static inline int pf_normal_map_priority(const struct pf_normal_map *pfnm,
+                                         const struct tile *ptile,
+                                         int cost_of_path, int cost)
+{
+  return -(cost_of_path
+           + PF_TURN_FACTOR * pf_normal_map_estimate(pfnm, ptile, cost));
+}
+
 /************************************************************************//**
   Fill in the position which must be discovered already. A helper
   for pf_normal_map_position(). This also "finalizes" the position.
@@ -401,7 +719,7 @@ static void pf_normal_map_fill_position(const struct pf_normal_map *pfnm,
                                         struct pf_position *pos)
 {
   int tindex = tile_index(ptile);
-  struct pf_normal_node *node = pfnm->lattice + tindex;
+  struct pf_normal_node *node = pf_normal_map_node(pfnm, tindex);
   const struct pf_parameter *params = pf_map_parameter(PF_MAP(pfnm));
 
 #ifdef PF_DEBUG
@@ -436,7 +754,8 @@ static struct pf_path *
 pf_normal_map_construct_path(const struct pf_normal_map *pfnm,
                              struct tile *dest_tile)
 {
-  struct pf_normal_node *node = pfnm->lattice + tile_index(dest_tile);
+  struct pf_normal_node *node = pf_normal_map_node(pfnm,
+                                                   tile_index(dest_tile));
   const struct pf_parameter *params = pf_map_parameter(PF_MAP(pfnm));
   enum direction8 dir_next = direction8_invalid();
   struct pf_path *path;
@@ -461,7 +780,7 @@ pf_normal_map_construct_path(const struct pf_normal_map *pfnm,
     }
 
     ptile = mapstep(params->map, ptile, DIR_REVERSE(node->dir_to_here));
-    node = pfnm->lattice + tile_index(ptile);
+    node = pf_normal_map_node(pfnm, tile_index(ptile));
   }
 
   /* 2: Allocate the memory */
@@ -470,7 +789,7 @@ pf_normal_map_construct_path(const struct pf_normal_map *pfnm,
 
   /* 3: Backtrack again and fill the positions this time */
   ptile = dest_tile;
-  node = pfnm->lattice + tile_index(ptile);
+  node = pf_normal_map_node(pfnm, tile_index(ptile));
 
   for (; i >= 0; i--) {
     pf_normal_map_fill_position(pfnm, ptile, &path->positions[i]);
@@ -482,7 +801,7 @@ pf_normal_map_construct_path(const struct pf_normal_map *pfnm,
     if (i > 0) {
       /* Step further back, if we haven't finished yet */
       ptile = mapstep(params->map, ptile, DIR_REVERSE(dir_next));
-      node = pfnm->lattice + tile_index(ptile);
+      node = pf_normal_map_node(pfnm, tile_index(ptile));
     }
   }
 
@@ -521,7 +840,7 @@ static bool pf_jumbo_map_iterate(struct pf_map *pfm)
   struct pf_normal_map *pfnm = PF_NORMAL_MAP(pfm);
   struct tile *tile = pfm->tile;
   int tindex = tile_index(tile);
-  struct pf_normal_node *node = pfnm->lattice + tindex;
+  struct pf_normal_node *node = pf_normal_map_node(pfnm, tindex);
   const struct pf_parameter *params = pf_map_parameter(pfm);
 
   /* Processing Stage */
@@ -534,7 +853,7 @@ static bool pf_jumbo_map_iterate(struct pf_map *pfm)
     /* Calculate the cost of every adjacent position and set them in the
      * priority queue for next call to pf_jumbo_map_iterate(). */
     int tindex1 = tile_index(tile1);
-    struct pf_normal_node *node1 = pfnm->lattice + tindex1;
+    struct pf_normal_node *node1 = pf_normal_map_node(pfnm, tindex1);
     int priority, cost1, extra_cost1;
 
     /* As for the previous position, 'tile1', 'node1' and 'tindex1' are
@@ -582,12 +901,12 @@ static bool pf_jumbo_map_iterate(struct pf_map *pfm)
   }
 
 #ifdef PF_DEBUG
-  fc_assert(NS_NEW == pfnm->lattice[tindex].status);
+  fc_assert(NS_NEW == pf_normal_map_node(pfnm, tindex)->status);
 #endif
 
   /* Change the pf_map iterator. Node status step B. to C. */
   pfm->tile = index_to_tile(params->map, tindex);
-  pfnm->lattice[tindex].status = NS_PROCESSED;
+  pf_normal_map_node(pfnm, tindex)->status = NS_PROCESSED;
 
   return TRUE;
 }
@@ -613,11 +932,15 @@ static bool pf_normal_map_iterate(struct pf_map *pfm)
   struct pf_normal_map *pfnm = PF_NORMAL_MAP(pfm);
   struct tile *tile = pfm->tile;
   int tindex = tile_index(tile);
-  struct pf_normal_node *node = pfnm->lattice + tindex;
+  struct pf_normal_node *node = pf_normal_map_node(pfnm, tindex);
   const struct pf_parameter *params = pf_map_parameter(pfm);
   int cost_of_path;
   enum pf_move_scope scope = node->move_scope;
 
+  /* The search is started, the nodes queued so far would not be sorted
+   * correctly for a new goal. */
+  pfnm->goal_pending = FALSE;
+
   /* There is no exit from DONT_LEAVE tiles! */
   if (node->behavior != TB_DONT_LEAVE
       && scope != PF_MS_NONE
@@ -632,7 +955,7 @@ static bool pf_normal_map_iterate(struct pf_map *pfm)
       /* Calculate the cost of every adjacent position and set them in the
        * priority queue for next call to pf_normal_map_iterate(). */
       int tindex1 = tile_index(tile1);
-      struct pf_normal_node *node1 = pfnm->lattice + tindex1;
+      struct pf_normal_node *node1 = pf_normal_map_node(pfnm, tindex1);
       int cost;
       int extra = 0;
 
@@ -712,8 +1035,9 @@ static bool pf_normal_map_iterate(struct pf_map *pfm)
         node1->extra_cost = extra;
         node1->cost = cost;
         node1->dir_to_here = dir;
-        /* As we prefer lower costs, let's reverse the cost of the path. */
-        map_index_pq_insert(pfnm->queue, tindex1, -cost_of_path);
+        map_index_pq_insert(pfnm->queue, tindex1,
+                            pf_normal_map_priority(pfnm, tile1,
+                                                   cost_of_path, cost));
       } else if (cost_of_path < pf_total_CC(params, node1->cost,
                                             node1->extra_cost)) {
         /* We found a better route to 'tile1'. Let's register 'tindex1' to
@@ -722,8 +1046,9 @@ static bool pf_normal_map_iterate(struct pf_map *pfm)
         node1->extra_cost = extra;
         node1->cost = cost;
         node1->dir_to_here = dir;
-        /* As we prefer lower costs, let's reverse the cost of the path. */
-        map_index_pq_replace(pfnm->queue, tindex1, -cost_of_path);
+        map_index_pq_replace(pfnm->queue, tindex1,
+                             pf_normal_map_priority(pfnm, tile1,
+                                                    cost_of_path, cost));
       }
     } adjc_dir_iterate_end;
   }
@@ -735,12 +1060,12 @@ static bool pf_normal_map_iterate(struct pf_map *pfm)
   }
 
 #ifdef PF_DEBUG
-  fc_assert(NS_NEW == pfnm->lattice[tindex].status);
+  fc_assert(NS_NEW == pf_normal_map_node(pfnm, tindex)->status);
 #endif
 
   /* Change the pf_map iterator. Node status step C. to D. */
   pfm->tile = index_to_tile(params->map, tindex);
-  pfnm->lattice[tindex].status = NS_PROCESSED;
+  pf_normal_map_node(pfnm, tindex)->status = NS_PROCESSED;
 
   return TRUE;
 }
@@ -752,7 +1077,7 @@ static inline bool pf_normal_map_iterate_until(struct pf_normal_map *pfnm,
                                                struct tile *ptile)
 {
   struct pf_map *pfm = PF_MAP(pfnm);
-  struct pf_normal_node *node = pfnm->lattice + tile_index(ptile);
+  struct pf_normal_node *node = pf_normal_map_node(pfnm, tile_index(ptile));
 
   if (NULL == pf_map_parameter(pfm)->get_costs) {
     /* Start position is handled in every function calling this function. */
@@ -768,6 +1093,12 @@ static inline bool pf_normal_map_iterate_until(struct pf_normal_map *pfnm,
     }
   } /* Else, this is a jumbo map, not dealing with normal nodes. */
 
+  if (pfnm->goal_pending) {
+    /* First destination asked, direct the search to it. */
+    pfnm->goal = ptile;
+    pfnm->goal_pending = FALSE;
+  }
+
   while (NS_PROCESSED != node->status) {
     if (!pf_map_iterate(pfm)) {
       /* All reachable destination have been iterated, 'ptile' is
@@ -791,7 +1122,7 @@ static int pf_normal_map_move_cost(struct pf_map *pfm, struct tile *ptile)
   if (ptile == pfm->params.start_tile) {
     return 0;
   } else if (pf_normal_map_iterate_until(pfnm, ptile)) {
-    return (pfnm->lattice[tile_index(ptile)].cost
+    return (pf_normal_map_node(pfnm, tile_index(ptile))->cost
             - pf_move_rate(pf_map_parameter(pfm))
             + pf_moves_left_initially(pf_map_parameter(pfm)));
   } else {
@@ -845,8 +1176,8 @@ static void pf_normal_map_destroy(struct pf_map *pfm)
 {
   struct pf_normal_map *pfnm = PF_NORMAL_MAP(pfm);
 
-  free(pfnm->lattice);
-  map_index_pq_destroy(pfnm->queue);
+  pf_lattice_release(pfnm->lattice);
+  pf_queue_release(pfnm->queue);
   free(pfnm);
 }
 
@@ -867,10 +1198,11 @@ static struct pf_map *pf_normal_map_new(const struct pf_parameter *parameter)
   /* Set the mode, used for cast check. */
   base_map->mode = PF_NORMAL;
 #endif /* PF_DEBUG */
+  base_map->shared = NULL;
 
   /* Allocate the map. */
-  pfnm->lattice = fc_calloc(MAP_INDEX_SIZE, sizeof(struct pf_normal_node));
-  pfnm->queue = map_index_pq_new(INITIAL_QUEUE_SIZE);
+  pfnm->lattice = pf_lattice_get(sizeof(struct pf_normal_node));
+  pfnm->queue = pf_queue_get();
 
   if (NULL == parameter->get_costs) {
     /* 'get_MC' callback must be set. */
@@ -883,6 +1215,17 @@ static struct pf_map *pf_normal_map_new(const struct pf_parameter *parameter)
   /* Copy parameters. */
   *params = *parameter;
 
+  /* Goal-directed search. */
+  pfnm->goal = NULL;
+  if (params->goal_directed && NULL == params->get_costs
+      && 0 < params->move_rate) {
+    pfnm->min_move_cost = pf_normal_map_min_move_cost(params);
+    pfnm->goal_pending = (0 < pfnm->min_move_cost);
+  } else {
+    pfnm->min_move_cost = 0;
+    pfnm->goal_pending = FALSE;
+  }
+
   /* Initialize virtual function table. */
   base_map->destroy = pf_normal_map_destroy;
   base_map->get_move_cost = pf_normal_map_move_cost;
@@ -895,7 +1238,7 @@ static struct pf_map *pf_normal_map_new(const struct pf_parameter *parameter)
   }
 
   /* Initialise starting node. */
-  node = pfnm->lattice + tile_index(params->start_tile);
+  node = pf_normal_map_node(pfnm, tile_index(params->start_tile));
   if (NULL == params->get_costs) {
     if (!pf_normal_node_init(pfnm, node, params->start_tile, PF_MS_NONE)) {
       /* Always fails. */
@@ -979,7 +1322,7 @@ struct pf_danger_map {
                                  * processed yet (NS_NEW and NS_WAITING),
                                  * sorted by their total_CC. */
   struct map_index_pq *danger_queue; /* Dangerous positions. */
-  struct pf_danger_node *lattice; /* Lattice of nodes. */
+  struct pf_lattice *lattice; /* Lattice of nodes. */
 };
 
 /* Up-cast macro. */
@@ -999,6 +1342,15 @@ pf_danger_map_check(struct pf_map *pfm, const char *file,
 #define PF_DANGER_MAP(pfm) ((struct pf_danger_map *) (pfm))
 #endif /* PF_DEBUG */
 
+/************************************************************************//**
+  Returns the node at 'tindex'.
+****************************************************************************/
+static inline struct pf_danger_node *
+pf_danger_map_node(const struct pf_danger_map *pfdm, int tindex)
+{
+  return pf_lattice_node(pfdm->lattice, tindex);
+}
+
 /* ===============  Specific pf_danger_* mode functions ================== */
 
 /************************************************************************//**
@@ -1078,7 +1430,7 @@ static inline bool pf_danger_node_init(struct pf_danger_map *pfdm,
       node->action = action;
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
     } else {
-      /* Nodes are allocated by fc_calloc(), so should be already set to
+      /* Nodes are zeroed by pf_lattice_node(), so should be already set to
        * 0. */
       node->action = PF_ACTION_NONE;
 #endif
@@ -1115,7 +1467,7 @@ static inline bool pf_danger_node_init(struct pf_danger_map *pfdm,
                           ? ZOC_ALLIED : ZOC_NO);
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
     } else {
-      /* Nodes are allocated by fc_calloc(), so should be already set to
+      /* Nodes are zeroed by pf_lattice_node(), so should be already set to
        * 0. */
       node->zoc_number = ZOC_MINE;
 #endif
@@ -1123,7 +1475,7 @@ static inline bool pf_danger_node_init(struct pf_danger_map *pfdm,
   } else {
     node->move_scope = PF_MS_NATIVE;
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
-    /* Nodes are allocated by fc_calloc(), so  should be already set to 0. */
+    /* Nodes are zeroed by pf_lattice_node(), so should be already set to 0. */
     node->action = PF_ACTION_NONE;
     node->zoc_number = ZOC_MINE;
 #endif
@@ -1134,13 +1486,13 @@ static inline bool pf_danger_node_init(struct pf_danger_map *pfdm,
     node->extra_tile = params->get_EC(ptile, node_known_type, params);
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
   } else {
-    /* Nodes are allocated by fc_calloc(), so should be already set to 0. */
+    /* Nodes are zeroed by pf_lattice_node(), so should be already set to 0. */
     node->extra_tile = 0;
 #endif
   }
 
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
-  /* Nodes are allocated by fc_calloc(), so should be already set to
+  /* Nodes are zeroed by pf_lattice_node(), so should be already set to
    * FALSE. */
   node->waited = FALSE;
 #endif
@@ -1160,7 +1512,7 @@ static void pf_danger_map_fill_position(const struct pf_danger_map *pfdm,
                                         struct pf_position *pos)
 {
   int tindex = tile_index(ptile);
-  struct pf_danger_node *node = pfdm->lattice + tindex;
+  struct pf_danger_node *node = pf_danger_map_node(pfdm, tindex);
   const struct pf_parameter *params = pf_map_parameter(PF_MAP(pfdm));
 
 #ifdef PF_DEBUG
@@ -1218,7 +1570,7 @@ pf_danger_map_construct_path(const struct pf_danger_map *pfdm,
   enum direction8 dir_next = direction8_invalid();
   struct pf_danger_pos *danger_seg = NULL;
   bool waited = FALSE;
-  struct pf_danger_node *node = pfdm->lattice + tile_index(ptile);
+  struct pf_danger_node *node = pf_danger_map_node(pfdm, tile_index(ptile));
   int length = 1;
   struct tile *iter_tile = ptile;
   const struct pf_parameter *params = pf_map_parameter(PF_MAP(pfdm));
@@ -1255,7 +1607,7 @@ pf_danger_map_construct_path(const struct pf_danger_map *pfdm,
 
     /* Step backward. */
     iter_tile = mapstep(params->map, iter_tile, DIR_REVERSE(dir_next));
-    node = pfdm->lattice + tile_index(iter_tile);
+    node = pf_danger_map_node(pfdm, tile_index(iter_tile));
   }
 
   /* Allocate memory for path. */
@@ -1264,7 +1616,7 @@ pf_danger_map_construct_path(const struct pf_danger_map *pfdm,
 
   /* Reset variables for main iteration. */
   iter_tile = ptile;
-  node = pfdm->lattice + tile_index(ptile);
+  node = pf_danger_map_node(pfdm, tile_index(ptile));
   danger_seg = NULL;
   waited = FALSE;
 
@@ -1346,7 +1698,7 @@ pf_danger_map_construct_path(const struct pf_danger_map *pfdm,
 
     /* 5: Step further back. */
     iter_tile = mapstep(params->map, iter_tile, DIR_REVERSE(dir_next));
-    node = pfdm->lattice + tile_index(iter_tile);
+    node = pf_danger_map_node(pfdm, tile_index(iter_tile));
   }
 
   fc_assert_msg(FALSE, "Cannot get to the starting point!");
@@ -1375,7 +1727,7 @@ static void pf_danger_map_create_segment(struct pf_danger_map *pfdm,
                                          struct pf_danger_node *node1)
 {
   struct tile *ptile = PF_MAP(pfdm)->tile;
-  struct pf_danger_node *node = pfdm->lattice + tile_index(ptile);
+  struct pf_danger_node *node = pf_danger_map_node(pfdm, tile_index(ptile));
   struct pf_danger_pos *pos;
   int length = 0, i;
   const struct pf_parameter *params = pf_map_parameter(PF_MAP(pfdm));
@@ -1390,7 +1742,7 @@ static void pf_danger_map_create_segment(struct pf_danger_map *pfdm,
   while (node->is_dangerous && direction8_is_valid(node->dir_to_here)) {
     length++;
     ptile = mapstep(params->map, ptile, DIR_REVERSE(node->dir_to_here));
-    node = pfdm->lattice + tile_index(ptile);
+    node = pf_danger_map_node(pfdm, tile_index(ptile));
   }
 
   /* Allocate memory for segment */
@@ -1398,7 +1750,7 @@ static void pf_danger_map_create_segment(struct pf_danger_map *pfdm,
 
   /* Reset tile and node pointers for main iteration */
   ptile = PF_MAP(pfdm)->tile;
-  node = pfdm->lattice + tile_index(ptile);
+  node = pf_danger_map_node(pfdm, tile_index(ptile));
 
   /* Now fill the positions */
   for (i = 0, pos = node1->danger_segment; i < length; i++, pos++) {
@@ -1413,7 +1765,7 @@ static void pf_danger_map_create_segment(struct pf_danger_map *pfdm,
 
     /* Step further down the tree */
     ptile = mapstep(params->map, ptile, DIR_REVERSE(node->dir_to_here));
-    node = pfdm->lattice + tile_index(ptile);
+    node = pf_danger_map_node(pfdm, tile_index(ptile));
   }
 
 #ifdef PF_DEBUG
@@ -1487,7 +1839,7 @@ static bool pf_danger_map_iterate(struct pf_map *pfm)
   const struct pf_parameter *const params = pf_map_parameter(pfm);
   struct tile *tile = pfm->tile;
   int tindex = tile_index(tile);
-  struct pf_danger_node *node = pfdm->lattice + tindex;
+  struct pf_danger_node *node = pf_danger_map_node(pfdm, tindex);
   enum pf_move_scope scope = node->move_scope;
 
   /* The previous position is defined by 'tile' (tile pointer), 'node'
@@ -1528,7 +1880,7 @@ static bool pf_danger_map_iterate(struct pf_map *pfm)
         /* Calculate the cost of every adjacent position and set them in
          * the priority queues for next call to pf_danger_map_iterate(). */
         int tindex1 = tile_index(tile1);
-        struct pf_danger_node *node1 = pfdm->lattice + tindex1;
+        struct pf_danger_node *node1 = pf_danger_map_node(pfdm, tindex1);
         int cost;
         int extra = 0;
 
@@ -1698,7 +2050,7 @@ static bool pf_danger_map_iterate(struct pf_map *pfm)
       /* Change the pf_map iterator and reset data. */
       tile = index_to_tile(params->map, tindex);
       pfm->tile = tile;
-      node = pfdm->lattice + tindex;
+      node = pf_danger_map_node(pfdm, tindex);
     } else {
       /* No dangerous nodes to process, go for a safe one. */
       if (!map_index_pq_remove(pfdm->queue, &tindex)) {
@@ -1707,13 +2059,13 @@ static bool pf_danger_map_iterate(struct pf_map *pfm)
       }
 
 #ifdef PF_DEBUG
-      fc_assert(NS_PROCESSED != pfdm->lattice[tindex].status);
+      fc_assert(NS_PROCESSED != pf_danger_map_node(pfdm, tindex)->status);
 #endif
 
       /* Change the pf_map iterator and reset data. */
       tile = index_to_tile(params->map, tindex);
       pfm->tile = tile;
-      node = pfdm->lattice + tindex;
+      node = pf_danger_map_node(pfdm, tindex);
       if (NS_WAITING != node->status) {
         /* Node status step C. and D. */
 #ifdef PF_DEBUG
@@ -1750,7 +2102,7 @@ static inline bool pf_danger_map_iterate_until(struct pf_danger_map *pfdm,
                                                struct tile *ptile)
 {
   struct pf_map *pfm = PF_MAP(pfdm);
-  struct pf_danger_node *node = pfdm->lattice + tile_index(ptile);
+  struct pf_danger_node *node = pf_danger_map_node(pfdm, tile_index(ptile));
 
   /* Start position is handled in every function calling this function. */
 
@@ -1789,7 +2141,7 @@ static int pf_danger_map_move_cost(struct pf_map *pfm, struct tile *ptile)
   if (ptile == pfm->params.start_tile) {
     return 0;
   } else if (pf_danger_map_iterate_until(pfdm, ptile)) {
-    return (pfdm->lattice[tile_index(ptile)].cost
+    return (pf_danger_map_node(pfdm, tile_index(ptile))->cost
             - pf_move_rate(pf_map_parameter(pfm))
             + pf_moves_left_initially(pf_map_parameter(pfm)));
   } else {
@@ -1846,14 +2198,18 @@ static void pf_danger_map_destroy(struct pf_map *pfm)
   int i;
 
   /* Need to clean up the dangling danger segments. */
-  for (i = 0, node = pfdm->lattice; i < MAP_INDEX_SIZE; i++, node++) {
+  for (i = 0; i < MAP_INDEX_SIZE; i++) {
+    if (!pf_lattice_node_used(pfdm->lattice, i)) {
+      continue;
+    }
+    node = pf_danger_map_node(pfdm, i);
     if (node->danger_segment) {
       free(node->danger_segment);
     }
   }
-  free(pfdm->lattice);
-  map_index_pq_destroy(pfdm->queue);
-  map_index_pq_destroy(pfdm->danger_queue);
+  pf_lattice_release(pfdm->lattice);
+  pf_queue_release(pfdm->queue);
+  pf_queue_release(pfdm->danger_queue);
   free(pfdm);
 }
 
@@ -1874,11 +2230,12 @@ static struct pf_map *pf_danger_map_new(const struct pf_parameter *parameter)
   /* Set the mode, used for cast check. */
   base_map->mode = PF_DANGER;
 #endif /* PF_DEBUG */
+  base_map->shared = NULL;
 
   /* Allocate the map. */
-  pfdm->lattice = fc_calloc(MAP_INDEX_SIZE, sizeof(struct pf_danger_node));
-  pfdm->queue = map_index_pq_new(INITIAL_QUEUE_SIZE);
-  pfdm->danger_queue = map_index_pq_new(INITIAL_QUEUE_SIZE);
+  pfdm->lattice = pf_lattice_get(sizeof(struct pf_danger_node));
+  pfdm->queue = pf_queue_get();
+  pfdm->danger_queue = pf_queue_get();
 
   /* 'get_MC' callback must be set. */
   fc_assert_ret_val(parameter->get_MC != NULL, NULL);
@@ -1900,7 +2257,7 @@ static struct pf_map *pf_danger_map_new(const struct pf_parameter *parameter)
   base_map->iterate = pf_danger_map_iterate;
 
   /* Initialise starting node. */
-  node = pfdm->lattice + tile_index(params->start_tile);
+  node = pf_danger_map_node(pfdm, tile_index(params->start_tile));
   if (!pf_danger_node_init(pfdm, node, params->start_tile, PF_MS_NONE)) {
     /* Always fails. */
     fc_assert(TRUE == pf_danger_node_init(pfdm, node, params->start_tile,
@@ -1993,7 +2350,7 @@ struct pf_fuel_map {
                                  * total_CC */
   struct map_index_pq *waited_queue; /* Queue of nodes to reach farer
                                       * positions after having refueled. */
-  struct pf_fuel_node *lattice; /* Lattice of nodes */
+  struct pf_lattice *lattice; /* Lattice of nodes */
 };
 
 /* Up-cast macro. */
@@ -2013,6 +2370,15 @@ pf_fuel_map_check(struct pf_map *pfm, const char *file,
 #define PF_FUEL_MAP(pfm) ((struct pf_fuel_map *) (pfm))
 #endif /* PF_DEBUG */
 
+/************************************************************************//**
+  Returns the node at 'tindex'.
+****************************************************************************/
+static inline struct pf_fuel_node *
+pf_fuel_map_node(const struct pf_fuel_map *pffm, int tindex)
+{
+  return pf_lattice_node(pffm->lattice, tindex);
+}
+
 /* =================  Specific pf_fuel_* mode functions ================== */
 
 /************************************************************************//**
@@ -2113,7 +2479,7 @@ static inline bool pf_fuel_node_init(struct pf_fuel_map *pffm,
 #endif
     } else {
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
-      /* Nodes are allocated by fc_calloc(), so should be already set to
+      /* Nodes are zeroed by pf_lattice_node(), so should be already set to
        * 0. */
       node->action = PF_ACTION_NONE;
 #endif
@@ -2161,7 +2527,7 @@ static inline bool pf_fuel_node_init(struct pf_fuel_map *pffm,
                           ? ZOC_ALLIED : ZOC_NO);
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
     } else {
-      /* Nodes are allocated by fc_calloc(), so should be already set to
+      /* Nodes are zeroed by pf_lattice_node(), so should be already set to
        * 0. */
       node->zoc_number = ZOC_MINE;
 #endif
@@ -2181,7 +2547,7 @@ static inline bool pf_fuel_node_init(struct pf_fuel_map *pffm,
 
     node->move_scope = PF_MS_NATIVE;
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
-    /* Nodes are allocated by fc_calloc(), so  should be already set to 0. */
+    /* Nodes are zeroed by pf_lattice_node(), so should be already set to 0. */
     node->action = PF_ACTION_NONE;
     node->zoc_number = ZOC_MINE;
 #endif
@@ -2192,13 +2558,13 @@ static inline bool pf_fuel_node_init(struct pf_fuel_map *pffm,
     node->extra_tile = params->get_EC(ptile, node_known_type, params);
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
   } else {
-    /* Nodes are allocated by fc_calloc(), so should be already set to 0. */
+    /* Nodes are zeroed by pf_lattice_node(), so should be already set to 0. */
     node->extra_tile = 0;
 #endif
   }
 
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
-  /* Nodes are allocated by fc_calloc(), so should be already set to 0. */
+  /* Nodes are zeroed by pf_lattice_node(), so should be already set to 0. */
   node->pos = NULL;
   node->segment = NULL;
 #endif
@@ -2324,7 +2690,7 @@ static void pf_fuel_map_fill_position(const struct pf_fuel_map *pffm,
                                       struct pf_position *pos)
 {
   int tindex = tile_index(ptile);
-  struct pf_fuel_node *node = pffm->lattice + tindex;
+  struct pf_fuel_node *node = pf_fuel_map_node(pffm, tindex);
   struct pf_fuel_pos *head = node->segment;
   const struct pf_parameter *params = pf_map_parameter(PF_MAP(pffm));
 
@@ -2366,7 +2732,7 @@ pf_fuel_map_construct_path(const struct pf_fuel_map *pffm,
 {
   struct pf_path *path = fc_malloc(sizeof(*path));
   enum direction8 dir_next = direction8_invalid();
-  struct pf_fuel_node *node = pffm->lattice + tile_index(ptile);
+  struct pf_fuel_node *node = pf_fuel_map_node(pffm, tile_index(ptile));
   struct pf_fuel_pos *segment = node->segment;
   int length = 1;
   struct tile *iter_tile = ptile;
@@ -2399,7 +2765,7 @@ pf_fuel_map_construct_path(const struct pf_fuel_map *pffm,
     /* Step backward. */
     iter_tile = mapstep(params->map, iter_tile,
                         DIR_REVERSE(segment->dir_to_here));
-    node = pffm->lattice + tile_index(iter_tile);
+    node = pf_fuel_map_node(pffm, tile_index(iter_tile));
     segment = segment->prev;
 #ifdef PF_DEBUG
     fc_assert(NULL != segment);
@@ -2416,7 +2782,7 @@ pf_fuel_map_construct_path(const struct pf_fuel_map *pffm,
 
   /* Reset variables for main iteration. */
   iter_tile = ptile;
-  node = pffm->lattice + tile_index(ptile);
+  node = pf_fuel_map_node(pffm, tile_index(ptile));
   segment = node->segment;
 
   for (i = length - 1; i >= 0; i--) {
@@ -2469,7 +2835,7 @@ pf_fuel_map_construct_path(const struct pf_fuel_map *pffm,
 
     /* 5: Step further back. */
     iter_tile = mapstep(params->map, iter_tile, DIR_REVERSE(dir_next));
-    node = pffm->lattice + tile_index(iter_tile);
+    node = pf_fuel_map_node(pffm, tile_index(iter_tile));
     segment = segment->prev;
 #ifdef PF_DEBUG
     fc_assert(NULL != segment);
@@ -2511,7 +2877,7 @@ static inline void pf_fuel_map_create_segment(struct pf_fuel_map *pffm,
   do {
     next = pos;
     ptile = mapstep(params->map, ptile, DIR_REVERSE(node->dir_to_here));
-    node = pffm->lattice + tile_index(ptile);
+    node = pf_fuel_map_node(pffm, tile_index(ptile));
     pos = node->pos;
     if (NULL != pos) {
       if (pos->cost == node->cost
@@ -2621,7 +2987,7 @@ static bool pf_fuel_map_iterate(struct pf_map *pfm)
   const struct pf_parameter *const params = pf_map_parameter(pfm);
   struct tile *tile = pfm->tile;
   int tindex = tile_index(tile);
-  struct pf_fuel_node *node = pffm->lattice + tindex;
+  struct pf_fuel_node *node = pf_fuel_map_node(pffm, tindex);
   enum pf_move_scope scope = node->move_scope;
   int priority, waited_priority;
   bool waited = FALSE;
@@ -2667,7 +3033,7 @@ static bool pf_fuel_map_iterate(struct pf_map *pfm)
         /* Calculate the cost of every adjacent position and set them in
          * the priority queues for next call to pf_fuel_map_iterate(). */
         int tindex1 = tile_index(tile1);
-        struct pf_fuel_node *node1 = pffm->lattice + tindex1;
+        struct pf_fuel_node *node1 = pf_fuel_map_node(pffm, tindex1);
         int cost, extra = 0;
         int moves_left;
         int cost_of_path, old_cost_of_path;
@@ -2904,7 +3270,7 @@ static bool pf_fuel_map_iterate(struct pf_map *pfm)
       /* Change the pf_map iterator and reset data. */
       tile = index_to_tile(params->map, tindex);
       pfm->tile = tile;
-      node = pffm->lattice + tindex;
+      node = pf_fuel_map_node(pffm, tindex);
       waited = TRUE;
 #ifdef PF_DEBUG
       fc_assert(0 < node->moves_left_req);
@@ -2922,7 +3288,7 @@ static bool pf_fuel_map_iterate(struct pf_map *pfm)
       /* Change the pf_map iterator and reset data. */
       tile = index_to_tile(params->map, tindex);
       pfm->tile = tile;
-      node = pffm->lattice + tindex;
+      node = pf_fuel_map_node(pffm, tindex);
 
 #ifdef PF_DEBUG
       fc_assert(NS_PROCESSED != node->status);
@@ -2966,7 +3332,7 @@ static inline bool pf_fuel_map_iterate_until(struct pf_fuel_map *pffm,
                                              struct tile *ptile)
 {
   struct pf_map *pfm = PF_MAP(pffm);
-  struct pf_fuel_node *node = pffm->lattice + tile_index(ptile);
+  struct pf_fuel_node *node = pf_fuel_map_node(pffm, tile_index(ptile));
 
   /* Start position is handled in every function calling this function. */
 
@@ -3004,7 +3370,8 @@ static int pf_fuel_map_move_cost(struct pf_map *pfm, struct tile *ptile)
   if (ptile == pfm->params.start_tile) {
     return 0;
   } else if (pf_fuel_map_iterate_until(pffm, ptile)) {
-    const struct pf_fuel_node *node = pffm->lattice + tile_index(ptile);
+    const struct pf_fuel_node *node = pf_fuel_map_node(pffm,
+                                                       tile_index(ptile));
 
     return (node->segment->cost
             - pf_move_rate(pf_map_parameter(pfm))
@@ -3063,13 +3430,17 @@ static void pf_fuel_map_destroy(struct pf_map *pfm)
   int i;
 
   /* Need to clean up the dangling fuel segments. */
-  for (i = 0, node = pffm->lattice; i < MAP_INDEX_SIZE; i++, node++) {
+  for (i = 0; i < MAP_INDEX_SIZE; i++) {
+    if (!pf_lattice_node_used(pffm->lattice, i)) {
+      continue;
+    }
+    node = pf_fuel_map_node(pffm, i);
     pf_fuel_pos_unref(node->pos);
     pf_fuel_pos_unref(node->segment);
   }
-  free(pffm->lattice);
-  map_index_pq_destroy(pffm->queue);
-  map_index_pq_destroy(pffm->waited_queue);
+  pf_lattice_release(pffm->lattice);
+  pf_queue_release(pffm->queue);
+  pf_queue_release(pffm->waited_queue);
   free(pffm);
 }
 
@@ -3090,11 +3461,12 @@ static struct pf_map *pf_fuel_map_new(const struct pf_parameter *parameter)
   /* Set the mode, used for cast check. */
   base_map->mode = PF_FUEL;
 #endif /* PF_DEBUG */
+  base_map->shared = NULL;
 
   /* Allocate the map. */
-  pffm->lattice = fc_calloc(MAP_INDEX_SIZE, sizeof(struct pf_fuel_node));
-  pffm->queue = map_index_pq_new(INITIAL_QUEUE_SIZE);
-  pffm->waited_queue = map_index_pq_new(INITIAL_QUEUE_SIZE);
+  pffm->lattice = pf_lattice_get(sizeof(struct pf_fuel_node));
+  pffm->queue = pf_queue_get();
+  pffm->waited_queue = pf_queue_get();
 
   /* 'get_MC' callback must be set. */
   fc_assert_ret_val(parameter->get_MC != NULL, NULL);
@@ -3116,7 +3488,7 @@ static struct pf_map *pf_fuel_map_new(const struct pf_parameter *parameter)
   base_map->iterate = pf_fuel_map_iterate;
 
   /* Initialise starting node. */
-  node = pffm->lattice + tile_index(params->start_tile);
+  node = pf_fuel_map_node(pffm, tile_index(params->start_tile));
   if (!pf_fuel_node_init(pffm, node, params->start_tile, PF_MS_NONE)) {
     /* Always fails. */
     fc_assert(TRUE == pf_fuel_node_init(pffm, node, params->start_tile,
@@ -3145,6 +3517,441 @@ static struct pf_map *pf_fuel_map_new(const struct pf_parameter *parameter)
 
 
 
+/* ====================== pf_map cache functions ========================= */
+
+/* Maps shared between the searches made with the same parameter during a
+ * same game state, e.g. for the units of a same type stacked on a same
+ * tile. Every user gets its own view of the map, so that it can iterate
+ * it independently of the others. The cache is only used from the thread
+ * which initialized it. */
+struct pf_shared_map {
+  struct pf_parameter parameter;  /* The key, a copy of the parameter. */
+  struct pf_map *pfm;
+  int refcount;                   /* Views, plus one while cached. */
+  unsigned int last_use;
+
+  /* Indices of the tiles 'pfm' iterated through, in order. */
+  int *positions;
+  int num_positions;
+  int max_positions;
+};
+
+/* A user of a shared map. */
+struct pf_shared_view {
+  struct pf_map base_map;         /* Base structure, must be the first! */
+
+  struct pf_shared_map *shared;
+  int position;                   /* Index of the iterator in 'positions'. */
+};
+
+/* Maximum number of maps kept in the cache. */
+#define PF_CACHE_SIZE 16
+
+static genhash_val_t pf_shared_hash_val(const struct pf_parameter *param);
+static bool pf_shared_hash_cmp(const struct pf_parameter *param1,
+                               const struct pf_parameter *param2);
+
+#define SPECHASH_TAG pf_shared
+#define SPECHASH_IKEY_TYPE struct pf_parameter *
+#define SPECHASH_IDATA_TYPE struct pf_shared_map *
+#define SPECHASH_IKEY_VAL pf_shared_hash_val
+#define SPECHASH_IKEY_COMP pf_shared_hash_cmp
+#include "spechash.h"
+#define pf_shared_hash_data_iterate(hash, data)                             \
+  TYPED_HASH_DATA_ITERATE(struct pf_shared_map *, hash, data)
+#define pf_shared_hash_data_iterate_end HASH_DATA_ITERATE_END
+
+static struct {
+  struct pf_shared_hash *hash;  /* NULL when the cache is not initialized. */
+  fc_thread_id thread;          /* The thread using the cache. */
+  unsigned int clock;
+  int hits;
+  int misses;
+  int drops;
+} pf_cache = { NULL };
+
+/************************************************************************//**
+  Hash function for the parameter fingerprint.
+****************************************************************************/
+static genhash_val_t pf_shared_hash_val(const struct pf_parameter *param)
+{
+  genhash_val_t result = tile_index(param->start_tile);
+
+  result += (genhash_val_t) utype_number(param->utype) << 16;
+  result += (genhash_val_t) param->moves_left_initially << 24;
+  if (NULL != param->owner) {
+    result += (genhash_val_t) player_number(param->owner) << 8;
+  }
+
+  return result;
+}
+
+/************************************************************************//**
+  Comparison function for the parameter fingerprint. All fields which can
+  make the results differ must be the same. 'data' and 'get_costs' are
+  not compared as such parameters are never cached.
+****************************************************************************/
+static bool pf_shared_hash_cmp(const struct pf_parameter *param1,
+                               const struct pf_parameter *param2)
+{
+  return (param1->map == param2->map
+          && param1->start_tile == param2->start_tile
+          && param1->moves_left_initially == param2->moves_left_initially
+          && param1->fuel_left_initially == param2->fuel_left_initially
+          && (param1->transported_by_initially
+              == param2->transported_by_initially)
+          && param1->cargo_depth == param2->cargo_depth
+          && BV_ARE_EQUAL(param1->cargo_types, param2->cargo_types)
+          && param1->move_rate == param2->move_rate
+          && param1->fuel == param2->fuel
+          && param1->utype == param2->utype
+          && param1->owner == param2->owner
+          && param1->omniscience == param2->omniscience
+          && param1->goal_directed == param2->goal_directed
+          && param1->get_MC == param2->get_MC
+          && param1->get_move_scope == param2->get_move_scope
+          && param1->ignore_none_scopes == param2->ignore_none_scopes
+          && param1->get_TB == param2->get_TB
+          && param1->get_EC == param2->get_EC
+          && param1->get_action == param2->get_action
+          && param1->actions == param2->actions
+          && param1->is_action_possible == param2->is_action_possible
+          && param1->get_zoc == param2->get_zoc
+          && param1->is_pos_dangerous == param2->is_pos_dangerous
+          && param1->get_moves_left_req == param2->get_moves_left_req);
+}
+
+/************************************************************************//**
+  Returns TRUE iff the cache may be used by the calling thread.
+****************************************************************************/
+static inline bool pf_cache_usable(void)
+{
+  return (NULL != pf_cache.hash
+          && fc_thread_id_equal(pf_cache.thread, fc_thread_self()));
+}
+
+/************************************************************************//**
+  Record that the shared map went through 'ptile', see pf_map_iterate().
+****************************************************************************/
+static void pf_shared_map_add_position(struct pf_shared_map *shared,
+                                       const struct tile *ptile)
+{
+  if (shared->num_positions == shared->max_positions) {
+    shared->max_positions = MAX(64, 2 * shared->max_positions);
+    shared->positions = fc_realloc(shared->positions,
+                                   shared->max_positions
+                                   * sizeof(*shared->positions));
+  }
+  shared->positions[shared->num_positions++] = tile_index(ptile);
+}
+
+/************************************************************************//**
+  Release a reference to the shared map, freeing it after the last one.
+****************************************************************************/
+static void pf_shared_map_unref(struct pf_shared_map *shared)
+{
+  if (0 < --shared->refcount) {
+    return;
+  }
+
+  shared->pfm->destroy(shared->pfm);
+  free(shared->positions);
+  free(shared);
+}
+
+/************************************************************************//**
+  Returns the node lattice of the map.
+****************************************************************************/
+static const struct pf_lattice *pf_map_lattice(struct pf_map *pfm)
+{
+  /* Same choice as pf_map_new(). */
+  if (pfm->params.is_pos_dangerous) {
+    return PF_DANGER_MAP(pfm)->lattice;
+  } else if (pfm->params.get_moves_left_req) {
+    return PF_FUEL_MAP(pfm)->lattice;
+  }
+
+  return PF_NORMAL_MAP(pfm)->lattice;
+}
+
+/************************************************************************//**
+  Returns TRUE iff the search may have looked at 'ptile'. A node depends
+  on its tile and, for zones of control, on the adjacent ones.
+****************************************************************************/
+static bool pf_map_tile_used(struct pf_map *pfm, const struct tile *ptile)
+{
+  const struct pf_lattice *lattice = pf_map_lattice(pfm);
+
+  if (pf_lattice_node_used(lattice, tile_index(ptile))) {
+    return TRUE;
+  }
+  adjc_iterate(pfm->params.map, ptile, adjc_tile) {
+    if (pf_lattice_node_used(lattice, tile_index(adjc_tile))) {
+      return TRUE;
+    }
+  } adjc_iterate_end;
+
+  return FALSE;
+}
+
+/************************************************************************//**
+  Remove the map from the cache. The views still using it keep it alive.
+****************************************************************************/
+static void pf_map_cache_drop(struct pf_shared_map *shared)
+{
+  pf_shared_hash_remove(pf_cache.hash, &shared->parameter);
+  pf_cache.drops++;
+  pf_shared_map_unref(shared);
+}
+
+/************************************************************************//**
+  Initialize the cache of shared maps. Only the calling thread may use it.
+****************************************************************************/
+void pf_map_cache_init(void)
+{
+  fc_assert_ret(NULL == pf_cache.hash);
+
+  pf_cache.hash = pf_shared_hash_new();
+  pf_cache.thread = fc_thread_self();
+  pf_cache.clock = 0;
+  pf_cache.hits = 0;
+  pf_cache.misses = 0;
+  pf_cache.drops = 0;
+}
+
+/************************************************************************//**
+  Free the cache of shared maps. The maps still used are freed when they
+  are destroyed by their last user.
+****************************************************************************/
+void pf_map_cache_free(void)
+{
+  if (NULL == pf_cache.hash) {
+    return;
+  }
+
+  pf_map_cache_invalidate();
+  log_verbose("PF: shared maps cache: %d hits, %d misses, %d dropped.",
+              pf_cache.hits, pf_cache.misses, pf_cache.drops);
+  pf_shared_hash_destroy(pf_cache.hash);
+  pf_cache.hash = NULL;
+}
+
+/************************************************************************//**
+  Drop all the shared maps. Must be called whenever the game state the
+  path-finding callbacks rely on changes everywhere at once (diplomatic
+  states, turn change...), then new searches will start from scratch.
+  For changes of a tile, see pf_map_cache_invalidate_tile().
+****************************************************************************/
+void pf_map_cache_invalidate(void)
+{
+  if (NULL == pf_cache.hash) {
+    return;
+  }
+  /* Changing the game state from another thread would be a bug anyway. */
+  fc_assert_ret(pf_cache_usable());
+  if (0 == pf_shared_hash_size(pf_cache.hash)) {
+    return;
+  }
+
+  pf_shared_hash_data_iterate(pf_cache.hash, shared) {
+    pf_cache.drops++;
+    pf_shared_map_unref(shared);
+  } pf_shared_hash_data_iterate_end;
+  pf_shared_hash_clear(pf_cache.hash);
+}
+
+/************************************************************************//**
+  Drop the shared maps which may depend on what 'ptile' holds: the units,
+  the city, the terrain... If 'pplayer' is set, only the knowledge of
+  this player about the tile changed, so the other maps are kept.
+****************************************************************************/
+void pf_map_cache_invalidate_tile(const struct tile *ptile,
+                                  const struct player *pplayer)
+{
+  struct pf_shared_map *dropped[PF_CACHE_SIZE];
+  int num_dropped = 0, i;
+
+  if (NULL == pf_cache.hash) {
+    return;
+  }
+  /* Changing the game state from another thread would be a bug anyway. */
+  fc_assert_ret(pf_cache_usable());
+  if (0 == pf_shared_hash_size(pf_cache.hash)) {
+    return;
+  }
+
+  pf_shared_hash_data_iterate(pf_cache.hash, shared) {
+    if (NULL != pplayer
+        && (shared->parameter.owner != pplayer
+            || shared->parameter.omniscience)) {
+      /* Doesn't use the knowledge of 'pplayer'. */
+      continue;
+    }
+    if (num_dropped < ARRAY_SIZE(dropped)
+        && pf_map_tile_used(shared->pfm, ptile)) {
+      dropped[num_dropped++] = shared;
+    }
+  } pf_shared_hash_data_iterate_end;
+
+  for (i = 0; i < num_dropped; i++) {
+    pf_map_cache_drop(dropped[i]);
+  }
+}
+
+/************************************************************************//**
+  'pf_shared_view' destructor.
+****************************************************************************/
+static void pf_shared_view_destroy(struct pf_map *pfm)
+{
+  struct pf_shared_view *view = (struct pf_shared_view *) pfm;
+
+  pf_shared_map_unref(view->shared);
+  free(view);
+}
+
+/************************************************************************//**
+  Return the move cost at ptile, from the shared map.
+****************************************************************************/
+static int pf_shared_view_move_cost(struct pf_map *pfm, struct tile *ptile)
+{
+  struct pf_map *target = ((struct pf_shared_view *) pfm)->shared->pfm;
+
+  return target->get_move_cost(target, ptile);
+}
+
+/************************************************************************//**
+  Return the path to ptile, from the shared map.
+****************************************************************************/
+static struct pf_path *pf_shared_view_path(struct pf_map *pfm,
+                                           struct tile *ptile)
+{
+  struct pf_map *target = ((struct pf_shared_view *) pfm)->shared->pfm;
+
+  return target->get_path(target, ptile);
+}
+
+/************************************************************************//**
+  Get the position at ptile, from the shared map.
+****************************************************************************/
+static bool pf_shared_view_position(struct pf_map *pfm, struct tile *ptile,
+                                    struct pf_position *pos)
+{
+  struct pf_map *target = ((struct pf_shared_view *) pfm)->shared->pfm;
+
+  return target->get_position(target, ptile, pos);
+}
+
+/************************************************************************//**
+  Move the view to the next position of the shared map, iterating the
+  shared map itself when the view caught up with it.
+****************************************************************************/
+static bool pf_shared_view_iterate(struct pf_map *pfm)
+{
+  struct pf_shared_view *view = (struct pf_shared_view *) pfm;
+  struct pf_shared_map *shared = view->shared;
+
+  view->position++;
+  while (view->position >= shared->num_positions) {
+    if (!pf_map_iterate(shared->pfm)) {
+      return FALSE;
+    }
+  }
+
+  pfm->tile = index_to_tile(pfm->params.map,
+                            shared->positions[view->position]);
+  return TRUE;
+}
+
+/************************************************************************//**
+  'pf_shared_view' constructor. Takes a reference to the shared map.
+****************************************************************************/
+static struct pf_map *pf_shared_view_new(struct pf_shared_map *shared)
+{
+  struct pf_shared_view *view = fc_malloc(sizeof(*view));
+  struct pf_map *base_map = &view->base_map;
+
+#ifdef PF_DEBUG
+  base_map->mode = shared->pfm->mode;
+#endif /* PF_DEBUG */
+  base_map->shared = NULL;
+  base_map->params = shared->parameter;
+  base_map->tile = shared->parameter.start_tile;
+
+  base_map->destroy = pf_shared_view_destroy;
+  base_map->get_move_cost = pf_shared_view_move_cost;
+  base_map->get_path = pf_shared_view_path;
+  base_map->get_position = pf_shared_view_position;
+  base_map->iterate = pf_shared_view_iterate;
+
+  view->shared = shared;
+  view->position = 0;
+  shared->refcount++;
+  shared->last_use = ++pf_cache.clock;
+
+  return base_map;
+}
+
+/************************************************************************//**
+  Like pf_map_new(), but the map is shared with the other callers using
+  the same parameter, until the game state it depends on changes (see
+  pf_map_cache_invalidate_tile()). The map is expanded lazily, so the
+  searches made by one caller benefit to the others. Each caller gets its
+  own iterator, which goes through all the positions of the map in order:
+  unlike with pf_map_new(), asking for a position with a method A)
+  function doesn't make the iteration skip ahead. It still must be
+  destroyed with pf_map_destroy() after usage.
+
+  Parameters with private data or jumbo callbacks are not shared, nor are
+  the maps made by another thread than the one which initialized the
+  cache.
+****************************************************************************/
+struct pf_map *pf_map_new_shared(const struct pf_parameter *parameter)
+{
+  struct pf_shared_map *shared;
+
+  if (NULL != parameter->data
+      || NULL != parameter->get_costs
+      || !pf_cache_usable()) {
+    return pf_map_new(parameter);
+  }
+
+  if (pf_shared_hash_lookup(pf_cache.hash, parameter, &shared)) {
+    pf_cache.hits++;
+    return pf_shared_view_new(shared);
+  }
+
+  if (PF_CACHE_SIZE <= pf_shared_hash_size(pf_cache.hash)) {
+    /* Make room, dropping the least recently used map. */
+    struct pf_shared_map *oldest = NULL;
+
+    pf_shared_hash_data_iterate(pf_cache.hash, pcached) {
+      if (NULL == oldest || pcached->last_use < oldest->last_use) {
+        oldest = pcached;
+      }
+    } pf_shared_hash_data_iterate_end;
+    pf_map_cache_drop(oldest);
+  }
+
+  pf_cache.misses++;
+  shared = fc_malloc(sizeof(*shared));
+  shared->parameter = *parameter;
+  shared->pfm = pf_map_new(parameter);
+  if (NULL == shared->pfm) {
+    free(shared);
+    return NULL;
+  }
+  shared->pfm->shared = shared;
+  shared->refcount = 1;
+  shared->positions = NULL;
+  shared->num_positions = 0;
+  shared->max_positions = 0;
+  pf_shared_map_add_position(shared, shared->pfm->tile);
+  pf_shared_hash_insert(pf_cache.hash, &shared->parameter, shared);
+
+  return pf_shared_view_new(shared);
+}
+
+
 /* ====================== pf_map public functions ======================= */
 
 /************************************************************************//**
@@ -3273,6 +4080,11 @@ bool pf_map_iterate(struct pf_map *pfm)
     return FALSE;
   }
 
+  if (NULL != pfm->shared) {
+    /* For the views of the map, see pf_shared_view_iterate(). */
+    pf_shared_map_add_position(pfm->shared, pfm->tile);
+  }
+
   return TRUE;
 }
 
@@ -3714,7 +4526,7 @@ pf_reverse_map_pos(struct pf_reverse_map *pfrm,
   struct pf_map *pfm;
   struct pf_parameter *copy;
   struct tile *target_tile;
-  const struct pf_normal_node *lattice;
+  struct pf_normal_map *pfnm;
   int max_cost;
 
   /* Check if we already processed something similar. */
@@ -3724,12 +4536,13 @@ pf_reverse_map_pos(struct pf_reverse_map *pfrm,
 
   /* We didn't. Build map and iterate. */
   pfm = pf_normal_map_new(param);
-  lattice = PF_NORMAL_MAP(pfm)->lattice;
+  pfnm = PF_NORMAL_MAP(pfm);
   target_tile = pfrm->target_tile;
   if (pfrm->max_turns >= 0) {
     max_cost = param->move_rate * (pfrm->max_turns + 1);
     do {
-      if (lattice[tile_index(pfm->tile)].cost >= max_cost) {
+      if (pf_normal_map_node(pfnm, tile_index(pfm->tile))->cost
+          >= max_cost) {
         break;
       } else if (pfm->tile == target_tile) {
         /* Found our position. Insert in hash, destroy map, and return. */
@@ -194,6 +194,13 @@ extern "C" {
  *
  * You may call pf_map_path() multiple times with the same pfm.
  *
+ * When the same search is likely to be made several times before the game
+ * state changes, pf_map_new_shared() may be used instead of pf_map_new(),
+ * the map is then shared with the other callers. This works for B) too.
+ *
+ * If you only want to go to 'ptile', set 'parameter.goal_directed' to
+ * make the search explore less tiles (see struct pf_parameter below).
+ *
  * B) the caller doesn't know the map position of the goal yet (but knows
  * what he is looking for, e.g. a port) and wants to iterate over
  * all paths in order of increasing costs (total_CC):
@@ -364,6 +371,19 @@ struct pf_parameter {
 
   bool omniscience;             /* Do we care if the tile is visible? */
 
+  /* If TRUE, the search is directed towards the first destination asked
+   * with pf_map_move_cost(), pf_map_path() or pf_map_position() (A*
+   * search): a lower bound of the remaining cost, deduced from the real
+   * distance to the destination and the cheapest possible move, is added
+   * to the priority of the positions. Results are the same, but much less
+   * tiles are explored when only one destination is wanted. Once a
+   * destination was asked, pf_map_iterate() doesn't return the positions
+   * in order of increasing cost anymore.
+   * This requires get_MC to never be cheaper than map_move_cost(), which
+   * is the case of the pft_fill_*_parameter() callbacks. It is ignored
+   * for units with danger or fuel, and with a get_costs callback. */
+  bool goal_directed;
+
   /* Callback to get MC of a move from 'from_tile' to 'to_tile' and in the
    * direction 'dir'. Note that the callback can calculate 'to_tile' by
    * itself based on 'from_tile' and 'dir'. Excessive information 'to_tile'
@@ -471,9 +491,22 @@ struct pf_reverse_map;
 
 /* ========================= Public Interface ============================ */
 
+/* Pool of lattices and queues recycled between maps. */
+void pf_map_pool_init(void);
+void pf_map_pool_free(void);
+
+/* Cache of maps shared between identical searches. */
+void pf_map_cache_init(void);
+void pf_map_cache_free(void);
+void pf_map_cache_invalidate(void);
+void pf_map_cache_invalidate_tile(const struct tile *ptile,
+                                  const struct player *pplayer);
+
 /* Create and free. */
 struct pf_map *pf_map_new(const struct pf_parameter *parameter)
                fc__warn_unused_result;
+struct pf_map *pf_map_new_shared(const struct pf_parameter *parameter)
+               fc__warn_unused_result;
 void pf_map_destroy(struct pf_map *pfm);
 
 /* Method A) functions. */
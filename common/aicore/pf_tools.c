@@ -671,6 +671,7 @@ pft_fill_default_parameter(struct pf_parameter *parameter,
   parameter->get_action = NULL;
   parameter->is_action_possible = NULL;
   parameter->actions = PF_AA_NONE;
+  parameter->goal_directed = FALSE;
 
   parameter->utype = punittype;
 }
@@ -991,6 +992,7 @@ void pft_fill_amphibious_parameter(struct pft_amphibious *parameter)
   }
   parameter->combined.get_action = NULL;
   parameter->combined.is_action_possible = NULL;
+  parameter->combined.goal_directed = FALSE;
 
   parameter->combined.data = parameter;
 }
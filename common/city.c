@@ -3210,6 +3210,7 @@ void city_add_improvement(struct city *pcity,
     /* Client just read the info from the packets. */
     wonder_built(pcity, pimprove);
   }
+  effect_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -3227,6 +3228,7 @@ void city_remove_improvement(struct city *pcity,
     /* Client just read the info from the packets. */
     wonder_destroyed(pcity, pimprove);
   }
+  effect_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -3326,6 +3328,7 @@ struct city *create_city_virtual(struct player *pplayer,
 
   if (is_server()) {
     pcity->server.mgr_score_calc_turn = -1; /* -1 = never */
+    effect_cache_city_init(pcity);
 
     CALL_FUNC_EACH_AI(city_alloc, pcity);
   } else {
@@ -3364,6 +3367,7 @@ void destroy_city_virtual(struct city *pcity)
   if (pcity->tile_cache != NULL) {
     free(pcity->tile_cache);
   }
+  effect_cache_city_free(pcity);
 
   if (pcity->cm_parameter) {
     free(pcity->cm_parameter);
@@ -292,6 +292,8 @@ enum city_updates {
 
 struct tile_cache; /* defined and only used within city.c */
 
+struct effect_value_cache; /* defined and only used within effects.c */
+
 struct adv_city; /* defined in ./server/advisors/infracache.h */
 
 struct cm_parameter; /* defined in ./common/aicore/cm.h */
@@ -327,6 +329,9 @@ struct city {
    * radius. */
   int tile_cache_radius_sq;
 
+  /* Cached values of get_city_bonus(). */
+  struct effect_value_cache *effect_cache;
+
   /* the productions */
   int surplus[O_LAST]; /* Final surplus in each category. */
   int waste[O_LAST]; /* Waste/corruption in each category. */
@@ -418,6 +423,12 @@ struct city {
       /* the city map is synced with the client. */
       bool synced;
 
+      /* If set, city info is to be sent to the owner, or to everyone
+       * for 'info_queued_all', at the end of coalescing.  Set inside
+       * send_city_info(). */
+      bool info_queued;
+      bool info_queued_all;
+
       bool debug;                   /* not saved */
 
       struct adv_city *adv;
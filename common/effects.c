@@ -121,6 +121,37 @@ static struct {
   } reqs;
 } ruleset_cache;
 
+/**************************************************************************
+  Effect value cache. The values of get_player_bonus() and
+  get_city_bonus() are remembered until something they depend on changes.
+  Only the effect types whose requirements can only depend on techs,
+  buildings, the government, the nation and the city size are cached, see
+  effect_type_cacheable(). The government, the nation, the owner and the
+  size are checked at every lookup, while changes of techs and buildings
+  must call effect_cache_invalidate().
+**************************************************************************/
+BV_DEFINE(bv_effect_types, EFT_COUNT);
+
+struct effect_value_cache {
+  unsigned int generation;      /* Of the whole cache when filled. */
+  const struct player *owner;
+  const struct government *government;
+  const struct nation_type *nation;
+  citizens size;                /* For cities only. */
+  bv_effect_types valid;        /* Which values[] are set. */
+  int values[EFT_COUNT];
+};
+
+static struct {
+  unsigned int generation;
+  bool frozen;                  /* Read only, see effect_cache_freeze(). */
+  unsigned int hits;
+  unsigned int misses;
+  /* TRI_MAYBE when not computed yet. */
+  enum fc_tristate cacheable[EFT_COUNT];
+  struct effect_value_cache *players[MAX_NUM_PLAYER_SLOTS];
+} effect_cache;
+
 
 /**********************************************************************//**
   Get a list of effects of this type.
@@ -180,6 +211,7 @@ struct effect *effect_new(enum effect_type type, int value,
   peffect->multiplier = pmul;
 
   requirement_vector_init(&peffect->reqs);
+  effect_cache.cacheable[type] = TRI_MAYBE;
 
   /* Now add the effect to the ruleset cache. */
   effect_list_append(ruleset_cache.tracker, peffect);
@@ -211,6 +243,7 @@ void effect_req_append(struct effect *peffect, struct requirement req)
   struct effect_list *eff_list = get_req_source_effects(&req.source);
 
   requirement_vector_append(&peffect->reqs, req);
+  effect_cache.cacheable[peffect->type] = TRI_MAYBE;
 
   if (eff_list) {
     effect_list_append(eff_list, peffect);
@@ -242,6 +275,11 @@ void ruleset_cache_init(void)
   for (i = 0; i < ARRAY_SIZE(ruleset_cache.reqs.advances); i++) {
     ruleset_cache.reqs.advances[i] = effect_list_new();
   }
+
+  for (i = 0; i < ARRAY_SIZE(effect_cache.cacheable); i++) {
+    effect_cache.cacheable[i] = TRI_MAYBE;
+  }
+  effect_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -298,9 +336,232 @@ void ruleset_cache_free(void)
     }
   }
 
+  for (i = 0; i < ARRAY_SIZE(effect_cache.players); i++) {
+    free(effect_cache.players[i]);
+    effect_cache.players[i] = NULL;
+  }
+  effect_cache_invalidate();
+
   initialized = FALSE;
 }
 
+/**********************************************************************//**
+  Returns whether the requirement can only depend on what the effect
+  value cache tracks, when evaluated for a player or a city. 'depth'
+  limits the recursion through the obsolescence of buildings.
+**************************************************************************/
+static bool effect_req_cacheable(const struct requirement *preq, int depth)
+{
+  switch (preq->source.kind) {
+  case VUT_NONE:
+  case VUT_UTYPE:
+  case VUT_UTFLAG:
+  case VUT_UCLASS:
+  case VUT_UCFLAG:
+  case VUT_OTYPE:
+  case VUT_SPECIALIST:
+  case VUT_ACTION:
+    /* These targets are never given to the cached queries. */
+    return TRUE;
+  case VUT_GOVERNMENT:
+    return TRUE;
+  case VUT_ADVANCE:
+    return (REQ_RANGE_PLAYER == preq->range
+            || (REQ_RANGE_WORLD == preq->range && preq->survives));
+  case VUT_TECHFLAG:
+  case VUT_NATION:
+  case VUT_NATIONGROUP:
+    return REQ_RANGE_PLAYER == preq->range;
+  case VUT_MINSIZE:
+    return REQ_RANGE_CITY == preq->range;
+  case VUT_IMPROVEMENT:
+    if (REQ_RANGE_LOCAL != preq->range
+        && REQ_RANGE_CITY != preq->range
+        && REQ_RANGE_PLAYER != preq->range
+        && REQ_RANGE_WORLD != preq->range) {
+      return FALSE;
+    }
+    if (2 < depth) {
+      return FALSE;
+    }
+    requirement_vector_iterate(&preq->source.value.building->obsolete_by,
+                               pobs) {
+      if (!effect_req_cacheable(pobs, depth + 1)) {
+        return FALSE;
+      }
+    } requirement_vector_iterate_end;
+    return TRUE;
+  default:
+    return FALSE;
+  }
+}
+
+/**********************************************************************//**
+  Returns whether the values of the effect type can be cached. Only the
+  server caches them, the client doesn't track the changes.
+**************************************************************************/
+static bool effect_type_cacheable(enum effect_type effect_type)
+{
+  if (!is_server()) {
+    return FALSE;
+  }
+
+  if (TRI_MAYBE == effect_cache.cacheable[effect_type]) {
+    bool cacheable = TRUE;
+
+    if (effect_cache.frozen) {
+      return FALSE;
+    }
+
+    effect_list_iterate(get_effects(effect_type), peffect) {
+      if (NULL != peffect->multiplier) {
+        cacheable = FALSE;
+      } else {
+        requirement_vector_iterate(&peffect->reqs, preq) {
+          if (!effect_req_cacheable(preq, 0)) {
+            cacheable = FALSE;
+            break;
+          }
+        } requirement_vector_iterate_end;
+      }
+      if (!cacheable) {
+        break;
+      }
+    } effect_list_iterate_end;
+
+    effect_cache.cacheable[effect_type] = BOOL_TO_TRISTATE(cacheable);
+  }
+
+  return TRI_YES == effect_cache.cacheable[effect_type];
+}
+
+/**********************************************************************//**
+  Returns the value of the effect type for the player, or for the city
+  if not NULL, using the cache when possible.
+**************************************************************************/
+static int effect_cache_value(struct effect_value_cache *pcache,
+                              const struct player *pplayer,
+                              const struct city *pcity,
+                              enum effect_type effect_type)
+{
+  const struct government *gov = government_of_player(pplayer);
+  const struct nation_type *nation = pplayer->nation;
+  citizens size = (NULL != pcity ? city_size_get(pcity) : 0);
+  bool current = (NULL != pcache
+                  && pcache->generation == effect_cache.generation
+                  && pcache->owner == pplayer
+                  && pcache->government == gov
+                  && pcache->nation == nation
+                  && pcache->size == size);
+  int value;
+
+  if (current && BV_ISSET(pcache->valid, effect_type)) {
+    if (!effect_cache.frozen) {
+      effect_cache.hits++;
+    }
+    return pcache->values[effect_type];
+  }
+
+  value = get_target_bonus_effects(NULL,
+                                   pplayer, NULL, pcity, NULL,
+                                   NULL != pcity ? city_tile(pcity) : NULL,
+                                   NULL, NULL, NULL, NULL, NULL,
+                                   effect_type);
+
+  if (NULL != pcache && !effect_cache.frozen) {
+    if (!current) {
+      pcache->generation = effect_cache.generation;
+      pcache->owner = pplayer;
+      pcache->government = gov;
+      pcache->nation = nation;
+      pcache->size = size;
+      BV_CLR_ALL(pcache->valid);
+    }
+    pcache->values[effect_type] = value;
+    BV_SET(pcache->valid, effect_type);
+    effect_cache.misses++;
+  }
+
+  return value;
+}
+
+/**********************************************************************//**
+  Returns the effect value cache of the player, allocating it if needed.
+**************************************************************************/
+static struct effect_value_cache *
+effect_cache_player(const struct player *pplayer)
+{
+  int idx = player_index(pplayer);
+
+  if (NULL == effect_cache.players[idx] && !effect_cache.frozen) {
+    effect_cache.players[idx] = fc_calloc(1, sizeof(struct effect_value_cache));
+  }
+
+  return effect_cache.players[idx];
+}
+
+/**********************************************************************//**
+  Forget all the cached effect values. Must be called whenever techs or
+  buildings change, or anything else effect_req_cacheable() relies on.
+**************************************************************************/
+void effect_cache_invalidate(void)
+{
+  effect_cache.generation++;
+}
+
+/**********************************************************************//**
+  While frozen, the effect value cache is only read, so that effect
+  values can be queried from several threads at once, as long as the
+  game state doesn't change.
+**************************************************************************/
+void effect_cache_freeze(bool freeze)
+{
+  effect_cache.frozen = freeze;
+}
+
+/**********************************************************************//**
+  Get the number of effect values found in the cache and computed since
+  the previous call, and reset the counts.
+**************************************************************************/
+void effect_cache_stats(unsigned int *hits, unsigned int *misses)
+{
+  *hits = effect_cache.hits;
+  *misses = effect_cache.misses;
+  effect_cache.hits = 0;
+  effect_cache.misses = 0;
+}
+
+/**********************************************************************//**
+  Allocate the effect value cache of a new city.
+**************************************************************************/
+void effect_cache_city_init(struct city *pcity)
+{
+  if (is_server()) {
+    pcity->effect_cache = fc_calloc(1, sizeof(*pcity->effect_cache));
+  }
+}
+
+/**********************************************************************//**
+  Free the effect value cache of the city.
+**************************************************************************/
+void effect_cache_city_free(struct city *pcity)
+{
+  free(pcity->effect_cache);
+  pcity->effect_cache = NULL;
+}
+
+/**********************************************************************//**
+  Free the effect value cache of the player.
+**************************************************************************/
+void effect_cache_player_free(const struct player *pplayer)
+{
+  int idx = player_index(pplayer);
+
+  free(effect_cache.players[idx]);
+  effect_cache.players[idx] = NULL;
+  effect_cache_invalidate();
+}
+
 /**********************************************************************//**
   Get the maximum effect value in this ruleset for the universal
   (that is, the sum of all positive effects clauses that apply specifically
@@ -671,6 +932,11 @@ int get_player_bonus(const struct player *pplayer,
     return 0;
   }
 
+  if (NULL != pplayer && effect_type_cacheable(effect_type)) {
+    return effect_cache_value(effect_cache_player(pplayer), pplayer, NULL,
+                              effect_type);
+  }
+
   return get_target_bonus_effects(NULL,
                                   pplayer, NULL, NULL, NULL,
                                   NULL, NULL, NULL, NULL, NULL,
@@ -686,6 +952,11 @@ int get_city_bonus(const struct city *pcity, enum effect_type effect_type)
     return 0;
   }
 
+  if (NULL != pcity->effect_cache && effect_type_cacheable(effect_type)) {
+    return effect_cache_value(pcity->effect_cache, city_owner(pcity), pcity,
+                              effect_type);
+  }
+
   return get_target_bonus_effects(NULL,
                                   city_owner(pcity), NULL, pcity, NULL,
                                   city_tile(pcity), NULL, NULL, NULL, NULL,
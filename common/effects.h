@@ -362,6 +362,14 @@ void ruleset_cache_free(void);
 void recv_ruleset_effect(const struct packet_ruleset_effect *packet);
 void send_ruleset_cache(struct conn_list *dest);
 
+/* effect value cache */
+void effect_cache_invalidate(void);
+void effect_cache_freeze(bool freeze);
+void effect_cache_stats(unsigned int *hits, unsigned int *misses);
+void effect_cache_city_init(struct city *pcity);
+void effect_cache_city_free(struct city *pcity);
+void effect_cache_player_free(const struct player *pplayer);
+
 int effect_cumulative_max(enum effect_type type, struct universal *for_uni);
 int effect_cumulative_min(enum effect_type type, struct universal *for_uni);
 
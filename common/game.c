@@ -25,6 +25,7 @@
 
 /* aicore */
 #include "cm.h"
+#include "path_finding.h"
 
 /* common */
 #include "ai.h"
@@ -33,6 +34,7 @@
 #include "city.h"
 #include "connection.h"
 #include "disaster.h"
+#include "effects.h"
 #include "extras.h"
 #include "government.h"
 #include "idex.h"
@@ -180,6 +182,7 @@ void game_remove_unit(struct world *gworld, struct unit *punit)
 
   unit_list_remove(unit_tile(punit)->units, punit);
   unit_list_remove(unit_owner(punit)->units, punit);
+  pf_map_cache_invalidate_tile(unit_tile(punit), NULL);
 
   idex_unregister_unit(gworld, punit);
 
@@ -187,6 +190,7 @@ void game_remove_unit(struct world *gworld, struct unit *punit)
     (game.callbacks.unit_deallocate)(punit->id);
   }
   unit_virtual_destroy(punit);
+  action_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -218,10 +222,14 @@ void game_remove_city(struct world *gworld, struct city *pcity)
         tile_set_worked(ptile, NULL);
       }
     } city_tile_iterate_end;
+    pf_map_cache_invalidate_tile(pcenter, NULL);
   }
 
   idex_unregister_city(gworld, pcity);
+  cm_clear_cache(pcity);
   destroy_city_virtual(pcity);
+  effect_cache_invalidate();
+  action_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -394,6 +402,7 @@ static void game_defaults(bool keep_ruleset_value)
     game.server.nuclear_winter_percent = GAME_DEFAULT_NUCLEAR_WINTER_PERCENT;
     game.server.plrcolormode      = GAME_DEFAULT_PLRCOLORMODE;
     game.server.netwait           = GAME_DEFAULT_NETWAIT;
+    game.server.delta_cache_size  = GAME_DEFAULT_DELTA_CACHE_SIZE;
     game.server.occupychance      = GAME_DEFAULT_OCCUPYCHANCE;
     game.server.onsetbarbarian    = GAME_DEFAULT_ONSETBARBARIAN;
     game.server.additional_phase_seconds = 0;
@@ -453,6 +462,8 @@ void game_init(bool keep_ruleset_value)
   game_ruleset_init();
   idex_init(&wld);
   cm_init();
+  pf_map_pool_init();
+  pf_map_cache_init();
   researches_init();
   universal_found_functions_init();
 }
@@ -476,6 +487,8 @@ void game_map_init(void)
 **************************************************************************/
 void game_free(void)
 {
+  /* Shared path-finding maps refer to the map and the players. */
+  pf_map_cache_free();
   player_slots_free();
   main_map_free();
   free_city_map_index();
@@ -484,6 +497,7 @@ void game_free(void)
   game_ruleset_free();
   researches_free();
   cm_free();
+  pf_map_pool_free();
 }
 
 /**********************************************************************//**
@@ -693,6 +707,7 @@ void initialize_globals(void)
       } city_built_iterate_end;
     } city_list_iterate_end;
   } players_iterate_end;
+  effect_cache_invalidate();
 }
 
 /**********************************************************************//**
@@ -124,6 +124,7 @@ struct civ_game {
 
       enum city_names_mode allowed_city_names;
       enum plrcolor_mode plrcolormode;
+      int ai_threads;
       int aqueductloss;
       bool auto_ai_toggle;
       bool autoattack;
@@ -131,8 +132,10 @@ struct civ_game {
       enum barbarians_rate barbarianrate;
       int base_incite_cost;
       int civilwarsize;
+      int cm_threads;
       int conquercost;
       int contactturns;
+      int delta_cache_size;
       int diplchance;
       int diplbulbcost;
       int diplgoldcost;
@@ -175,6 +178,8 @@ struct civ_game {
       int revolution_length;
       int spaceship_travel_time;
       bool threaded_save;
+      bool binary_save;
+      bool forked_autosave;
       int save_compress_level;
       enum fz_method save_compress_type;
       int save_nturns;
@@ -656,6 +661,10 @@ extern struct world wld;
 
 #define GAME_DEFAULT_THREADED_SAVE   FALSE
 
+#define GAME_DEFAULT_BINARY_SAVE     FALSE
+
+#define GAME_DEFAULT_FORKED_AUTOSAVE FALSE
+
 #define GAME_DEFAULT_USER_META_MESSAGE ""
 
 #define GAME_DEFAULT_SKILL_LEVEL     AI_LEVEL_EASY
@@ -709,6 +718,18 @@ extern struct world wld;
 #define GAME_MIN_KICK_TIME 0            /* 0 = disabling. */
 #define GAME_MAX_KICK_TIME 86400        /* 86400 seconds = 24 hours. */
 
+#define GAME_DEFAULT_AI_THREADS 0       /* 0 = AI players planned serially. */
+#define GAME_MIN_AI_THREADS 0
+#define GAME_MAX_AI_THREADS 64
+
+#define GAME_DEFAULT_CM_THREADS 0       /* 0 = cities arranged one by one. */
+#define GAME_MIN_CM_THREADS 0
+#define GAME_MAX_CM_THREADS 64          /* CM_MAX_THREADS */
+
+#define GAME_DEFAULT_DELTA_CACHE_SIZE 0 /* In KiB per connection, 0 = no limit. */
+#define GAME_MIN_DELTA_CACHE_SIZE 0
+#define GAME_MAX_DELTA_CACHE_SIZE (1024 * 1024)
+
 /* Max distance from the capital used to calculat the bribe cost. */
 #define GAME_UNIT_BRIBE_DIST_MAX 32
 
@@ -316,7 +316,7 @@ class Field:
 '''%(cmp,b,i)
         else:
             return '''%s
-  if (differ) {
+  if (differ || force_full) {
     different++;
     BV_SET(fields, %d);
   }
@@ -400,7 +400,7 @@ class Field:
       int count = 0;
 
       for (i = 0; i < %(array_size_u)s; i++) {
-        if (old->%(name)s[i] != real_packet->%(name)s[i]) {
+        if (force_full || old->%(name)s[i] != real_packet->%(name)s[i]) {
           count++;
         }
       }
@@ -416,7 +416,7 @@ class Field:
       fc_assert(%(array_size_u)s < 255);
 
       for (i = 0; i < %(array_size_u)s; i++) {
-        if (old->%(name)s[i] != real_packet->%(name)s[i]) {
+        if (force_full || old->%(name)s[i] != real_packet->%(name)s[i]) {
 #ifdef FREECIV_JSON_CONNECTION
           /* Next diff array element. */
           field_addr.sub_location->number = count - 1;
@@ -983,6 +983,16 @@ static char *stats_%(name)s_names[] = {%(names)s};
     # Returns a code fragment which is the implementation of the send
     # function. This is one of the two real functions. So it is rather
     # complex to create.
+    # Returns true if some fields are sent only when they changed, so
+    # sending all of them can be forced (bools folded into the header
+    # are always sent).
+    def want_force_full(self):
+        for field in self.other_fields:
+            if not (fold_bool_into_header and field.struct_type=="bool"
+                    and not field.is_array):
+                return 1
+        return 0
+
     def get_send(self):
         temp='''%(send_prototype)s
 {
@@ -1038,8 +1048,13 @@ static char *stats_%(name)s_names[] = {%(names)s};
   bool differ;
   struct genhash **hash = pc->phs.sent + %(type)s;
   int different = %(diff)s;
-#endif /* FREECIV_DELTA_PROTOCOL */
+<force_full>#endif /* FREECIV_DELTA_PROTOCOL */
 '''
+                if self.want_force_full():
+                    force_full="  bool force_full = FALSE;\n"
+                else:
+                    force_full=""
+                delta_header=delta_header.replace("<force_full>",force_full)
                 body=self.get_delta_send_body()+"\n#ifndef FREECIV_DELTA_PROTOCOL"
             else:
                 delta_header=""
@@ -1087,18 +1102,27 @@ static char *stats_%(name)s_names[] = {%(names)s};
 #ifdef FREECIV_DELTA_PROTOCOL
   if (NULL == *hash) {
     *hash = genhash_new_full(hash_%(name)s, cmp_%(name)s,
-                             NULL, NULL, NULL, free);
+                             NULL, NULL, NULL, delta_cache_entry_free);
   }
   BV_CLR_ALL(fields);
 
   if (!genhash_lookup(*hash, real_packet, (void **) &old)) {
-    old = fc_malloc(sizeof(*old));
+    old = delta_cache_entry_new(pc, %(type)s, sizeof(*old));
     *old = *real_packet;
     genhash_insert(*hash, old, old);
     memset(old, 0, sizeof(*old));
     different = 1;      /* Force to send. */
+<force_full>  } else {
+    delta_cache_entry_touch(old);
   }
 '''
+        if self.want_force_full():
+            # The receiver may still have an older version of an evicted
+            # packet: send every field of it.
+            force_full="    force_full = delta_cache_evicted(pc, %(type)s);\n"
+        else:
+            force_full=""
+        intro=intro.replace("<force_full>",force_full)
         body=""
         for i in range(len(self.other_fields)):
             field=self.other_fields[i]
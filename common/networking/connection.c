@@ -547,6 +547,7 @@ void free_compression_queue(struct connection *pc)
 {
 #ifdef USE_COMPRESSION
   byte_vector_free(&pc->compression.queue);
+  conn_compression_streams_free(pc);
 #endif /* USE_COMPRESSION */
 }
 
@@ -560,6 +561,7 @@ static void init_packet_hashs(struct connection *pc)
   pc->phs.sent = fc_malloc(sizeof(*pc->phs.sent) * PACKET_LAST);
   pc->phs.received = fc_malloc(sizeof(*pc->phs.received) * PACKET_LAST);
   pc->phs.handlers = packet_handlers_initial();
+  pc->phs.sent_cache = delta_cache_new();
 
   for (i = 0; i < PACKET_LAST; i++) {
     pc->phs.sent[i] = NULL;
@@ -584,6 +586,11 @@ static void free_packet_hashes(struct connection *pc)
     pc->phs.sent = NULL;
   }
 
+  if (NULL != pc->phs.sent_cache) {
+    delta_cache_destroy(pc->phs.sent_cache);
+    pc->phs.sent_cache = NULL;
+  }
+
   if (pc->phs.received) {
     for (i = 0; i < PACKET_LAST; i++) {
       if (pc->phs.received[i] != NULL) {
@@ -618,6 +625,8 @@ void connection_common_init(struct connection *pconn)
 #ifdef USE_COMPRESSION
   byte_vector_init(&pconn->compression.queue);
   pconn->compression.frozen_level = 0;
+  pconn->compression.deflate = NULL;
+  pconn->compression.inflate = NULL;
 #endif /* USE_COMPRESSION */
 }
 
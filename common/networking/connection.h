@@ -48,6 +48,7 @@ extern "C" {
 #include "fc_types.h"
 
 struct conn_pattern_list;
+struct delta_cache;
 struct genhash;
 struct packet_handlers;
 struct timer_list;
@@ -265,6 +266,8 @@ struct connection {
     struct genhash **sent;
     struct genhash **received;
     const struct packet_handlers *handlers;
+    /* Memory accounting and order of use of the packets in 'sent'. */
+    struct delta_cache *sent_cache;
   } phs;
 
 #ifdef USE_COMPRESSION
@@ -272,6 +275,11 @@ struct connection {
     int frozen_level;
 
     struct byte_vector queue;
+
+    /* zlib contexts kept for the whole connection, when both ends agreed
+     * to stream compressed data. NULL for separate compressed batches. */
+    struct z_stream_s *deflate;
+    struct z_stream_s *inflate;
   } compression;
 #endif
   struct {
@@ -305,6 +313,7 @@ void connection_common_init(struct connection *pconn);
 void connection_common_close(struct connection *pconn);
 void conn_set_capability(struct connection *pconn, const char *capability);
 void free_compression_queue(struct connection *pconn);
+void conn_compression_streams_free(struct connection *pconn);
 void conn_reset_delta_state(struct connection *pconn);
 
 void conn_compression_freeze(struct connection *pconn);
@@ -33,11 +33,13 @@
 #include "capability.h"
 #include "fc_cmdline.h"
 #include "fcintl.h"
+#include "genhash.h"
 #include "log.h"
 #include "mem.h"
 #include "support.h"
 
 /* commmon */
+#include "capstr.h"
 #include "dataio.h"
 #include "game.h"
 #include "events.h"
@@ -67,6 +69,21 @@
 
 #define MAX_DECOMPRESSION 400
 
+/*
+ * Optional capability: the compressed packets sent to the client after
+ * the join reply are the chunks of a single raw deflate stream, each one
+ * ended by a Z_SYNC_FLUSH. Both ends keep their zlib context for the
+ * whole connection, so the dictionary is not lost between batches.
+ */
+#define ZSTREAM_CAPABILITY "zstream"
+
+/*
+ * Batches at least this big are compressed on their own even for the
+ * streamed connections, so that the chunk can be shared by every
+ * connection sent the same batch (see conn_compression_flush()).
+ */
+#define COMPRESSION_SHARE_MIN_SIZE 4096
+
 #endif /* USE_COMPRESSION */
 
 /* 
@@ -90,6 +107,30 @@ static int stat_size_alone = 0;
 static int stat_size_uncompressed = 0;
 static int stat_size_compressed = 0;
 static int stat_size_no_compression = 0;
+static int stat_size_shared = 0;
+
+/* Number of compressed frames remembered by compression_frame_get(). */
+#define COMPRESSION_FRAME_CACHE_SIZE 4
+
+/* What was sent for a flushed compression queue. The server often sends
+ * the very same packets to many connections (the ruleset, what global
+ * observers see...), so their queues only need to be compressed once. */
+struct compression_frame {
+  uLong checksum;                       /* adler32() of 'queue'. */
+  struct byte_vector queue;             /* The uncompressed data. */
+  struct byte_vector frame;             /* Header and compressed data. */
+  bool compressed;                      /* FALSE: 'queue' is sent as is. */
+  bool raw;                             /* Stream chunk, not zlib data. */
+  unsigned int last_use;
+};
+
+static struct compression_frame frame_cache[COMPRESSION_FRAME_CACHE_SIZE];
+static unsigned int frame_cache_clock = 0;
+
+/* Header and compressed data of the streamed connection being flushed. */
+static struct byte_vector stream_frame;
+
+static bool conn_compression_flush(struct connection *pconn);
 
 /**********************************************************************//**
   Returns the compression level. Initilialize it if needed.
@@ -110,68 +151,371 @@ static inline int get_compression_level(void)
 }
 
 /**********************************************************************//**
-  Send all waiting data. Return TRUE on success.
+  Put the packet header in front of the 'compressed_size' bytes of
+  compressed data stored at offset 6 of 'frame', which then holds exactly
+  what is to be sent.
 **************************************************************************/
-static bool conn_compression_flush(struct connection *pconn)
+static void compression_frame_header(struct byte_vector *frame,
+                                     unsigned long compressed_size)
+{
+  struct raw_data_out dout;
+
+  /* Include normal length field in decision */
+  if (compressed_size + 2 < JUMBO_BORDER) {
+    FC_STATIC_ASSERT(COMPRESSION_BORDER > MAX_LEN_PACKET,
+                     uncompressed_compressed_packet_len_overlap);
+
+    log_compress("COMPRESS: sending %ld as normal", compressed_size);
+    memmove(frame->p + 2, frame->p + 6, compressed_size);
+    dio_output_init(&dout, frame->p, 2);
+    dio_put_uint16_raw(&dout, 2 + compressed_size + COMPRESSION_BORDER);
+    byte_vector_reserve(frame, 2 + compressed_size);
+  } else {
+    FC_STATIC_ASSERT(JUMBO_SIZE >= JUMBO_BORDER+COMPRESSION_BORDER,
+                     compressed_normal_jumbo_packet_len_overlap);
+
+    log_compress("COMPRESS: sending %ld as jumbo", compressed_size);
+    dio_output_init(&dout, frame->p, 6);
+    dio_put_uint16_raw(&dout, JUMBO_SIZE);
+    dio_put_uint32_raw(&dout, 6 + compressed_size);
+    byte_vector_reserve(frame, 6 + compressed_size);
+  }
+}
+
+/**********************************************************************//**
+  Like compress2(), but makes a raw deflate chunk ended by a Z_SYNC_FLUSH.
+  It doesn't refer to any earlier data, so it can be put in any deflate
+  stream between two flushed chunks.
+**************************************************************************/
+static int compress_chunk(Bytef *dest, uLongf *dest_len,
+                          const Bytef *source, uLong source_len, int level)
+{
+  z_stream strm;
+  int error;
+
+  memset(&strm, 0, sizeof(strm));
+  error = deflateInit2(&strm, level, Z_DEFLATED, -MAX_WBITS, 8,
+                       Z_DEFAULT_STRATEGY);
+  if (Z_OK != error) {
+    return error;
+  }
+
+  strm.next_in = (Bytef *) source;
+  strm.avail_in = source_len;
+  strm.next_out = dest;
+  strm.avail_out = *dest_len;
+  error = deflate(&strm, Z_SYNC_FLUSH);
+  if (Z_OK == error && (0 != strm.avail_in || 0 == strm.avail_out)) {
+    /* Maybe not all flushed. */
+    error = Z_BUF_ERROR;
+  }
+  *dest_len -= strm.avail_out;
+  deflateEnd(&strm);
+
+  return error;
+}
+
+/**********************************************************************//**
+  Compress 'size' bytes of 'data' into the frame, i.e. the packet header
+  and the compressed data to send instead of them. If 'raw' is set, the
+  data is compressed as a stand-alone chunk for the streamed connections.
+  If compressing wouldn't make the data smaller, the frame is marked as
+  not compressed; the data must then be sent as is.
+**************************************************************************/
+static void compression_frame_build(struct compression_frame *pframe,
+                                    const unsigned char *data, size_t size,
+                                    bool raw)
 {
   int compression_level = get_compression_level();
-  uLongf compressed_size = 12 + 1.001 * pconn->compression.queue.size;
+  uLongf compressed_size = 12 + 1.001 * size;
   int error;
-  Bytef compressed[compressed_size];
   bool jumbo;
   unsigned long compressed_packet_len;
 
-  error = compress2(compressed, &compressed_size,
-                    pconn->compression.queue.p,
-                    pconn->compression.queue.size,
-                    compression_level);
-  fc_assert_ret_val(error == Z_OK, FALSE);
-
-  /* Compression signalling currently assumes a 2-byte packet length; if that
-   * changes, the protocol should probably be changed */
-  fc_assert_ret_val(data_type_size(pconn->packet_header.length) == 2, FALSE);
+  /* Leave room for the longest header before the compressed data. */
+  byte_vector_reserve(&pframe->frame, 6 + compressed_size);
+  if (raw) {
+    error = compress_chunk(pframe->frame.p + 6, &compressed_size, data,
+                           size, compression_level);
+  } else {
+    error = compress2(pframe->frame.p + 6, &compressed_size, data, size,
+                      compression_level);
+  }
+  fc_assert_action(error == Z_OK, compressed_size = size);
 
   /* Include normal length field in decision */
   jumbo = (compressed_size+2 >= JUMBO_BORDER);
 
   compressed_packet_len = compressed_size + (jumbo ? 6 : 2);
-  if (compressed_packet_len < pconn->compression.queue.size) {
-    struct raw_data_out dout;
+  if (error != Z_OK || compressed_packet_len >= size) {
+    log_compress("COMPRESS: would enlarge %lu bytes to %ld; "
+                 "sending uncompressed",
+                 (unsigned long) size, compressed_packet_len);
+    pframe->compressed = FALSE;
+    byte_vector_reserve(&pframe->frame, 0);
+    return;
+  }
 
-    log_compress("COMPRESS: compressed %lu bytes to %ld (level %d)",
-                 (unsigned long) pconn->compression.queue.size,
-                 compressed_size, compression_level);
-    stat_size_uncompressed += pconn->compression.queue.size;
-    stat_size_compressed += compressed_size;
+  log_compress("COMPRESS: compressed %lu bytes to %ld (level %d)",
+               (unsigned long) size, compressed_size, compression_level);
+  pframe->compressed = TRUE;
+  compression_frame_header(&pframe->frame, compressed_size);
+}
 
-    if (!jumbo) {
-      unsigned char header[2];
-      FC_STATIC_ASSERT(COMPRESSION_BORDER > MAX_LEN_PACKET,
-                       uncompressed_compressed_packet_len_overlap);
+/**********************************************************************//**
+  Returns the frame to send for the data queued for the connection, a
+  stream chunk if 'raw' is set. It is taken from the frame cache when the
+  same data was compressed the same way recently, else it is built and
+  replaces the least recently used cached frame.
+**************************************************************************/
+static const struct compression_frame *
+compression_frame_get(const struct byte_vector *queue, bool raw)
+{
+  uLong checksum = adler32(adler32(0L, Z_NULL, 0), queue->p, queue->size);
+  struct compression_frame *pframe = NULL;
+  int i;
+
+  for (i = 0; i < COMPRESSION_FRAME_CACHE_SIZE; i++) {
+    struct compression_frame *pcached = frame_cache + i;
+
+    if (pcached->checksum == checksum
+        && pcached->raw == raw
+        && pcached->queue.size == queue->size
+        && 0 < pcached->queue.size
+        && 0 == memcmp(pcached->queue.p, queue->p, queue->size)) {
+      log_compress("COMPRESS: reusing frame for %lu bytes",
+                   (unsigned long) queue->size);
+      pcached->last_use = ++frame_cache_clock;
+      stat_size_shared += queue->size;
+      return pcached;
+    }
+    if (NULL == pframe || pcached->last_use < pframe->last_use) {
+      pframe = pcached;
+    }
+  }
 
-      log_compress("COMPRESS: sending %ld as normal", compressed_size);
+  compression_frame_build(pframe, queue->p, queue->size, raw);
+  pframe->raw = raw;
+  pframe->checksum = checksum;
+  byte_vector_copy(&pframe->queue, queue);
+  pframe->last_use = ++frame_cache_clock;
 
-      dio_output_init(&dout, header, sizeof(header));
-      dio_put_uint16_raw(&dout, 2 + compressed_size + COMPRESSION_BORDER);
-      connection_send_data(pconn, header, sizeof(header));
-      connection_send_data(pconn, compressed, compressed_size);
-    } else {
-      unsigned char header[6];
-      FC_STATIC_ASSERT(JUMBO_SIZE >= JUMBO_BORDER+COMPRESSION_BORDER,
-                       compressed_normal_jumbo_packet_len_overlap);
-
-      log_compress("COMPRESS: sending %ld as jumbo", compressed_size);
-      dio_output_init(&dout, header, sizeof(header));
-      dio_put_uint16_raw(&dout, JUMBO_SIZE);
-      dio_put_uint32_raw(&dout, 6 + compressed_size);
-      connection_send_data(pconn, header, sizeof(header));
-      connection_send_data(pconn, compressed, compressed_size);
+  return pframe;
+}
+
+/**********************************************************************//**
+  Send all waiting data as the next chunk of the connection's deflate
+  stream. Return TRUE on success.
+**************************************************************************/
+static bool conn_compression_stream_flush(struct connection *pconn)
+{
+  z_stream *strm = pconn->compression.deflate;
+  size_t size = pconn->compression.queue.size;
+  unsigned long compressed_size;
+  int error;
+
+  /* Leave room for the longest header before the compressed data. */
+  byte_vector_reserve(&stream_frame, 6 + deflateBound(strm, size) + 16);
+  strm->next_in = pconn->compression.queue.p;
+  strm->avail_in = size;
+  strm->next_out = stream_frame.p + 6;
+  strm->avail_out = stream_frame.size - 6;
+
+  for (;;) {
+    size_t used;
+
+    error = deflate(strm, Z_SYNC_FLUSH);
+    if ((Z_OK != error && Z_BUF_ERROR != error)
+        || 0 != strm->avail_out) {
+      break;
+    }
+
+    /* Out of room, everything isn't flushed yet. */
+    used = stream_frame.size;
+    byte_vector_reserve(&stream_frame, 2 * used);
+    strm->next_out = stream_frame.p + used;
+    strm->avail_out = stream_frame.size - used;
+  }
+
+  if ((Z_OK != error && Z_BUF_ERROR != error) || 0 != strm->avail_in) {
+    log_error("Compressing the packet stream for %s failed (%d).",
+              conn_description(pconn), error);
+    connection_close(pconn, _("compression error"));
+    return FALSE;
+  }
+
+  compressed_size = stream_frame.size - 6 - strm->avail_out;
+  log_compress("COMPRESS: streamed %lu bytes as %ld",
+               (unsigned long) size, compressed_size);
+  stat_size_uncompressed += size;
+  stat_size_compressed += compressed_size;
+
+  compression_frame_header(&stream_frame, compressed_size);
+  connection_send_data(pconn, stream_frame.p, stream_frame.size);
+
+  return pconn->used;
+}
+
+/**********************************************************************//**
+  Returns TRUE if both ends of the connection support streaming
+  compression. 'peer_capability' is the capability string of the other
+  end.
+**************************************************************************/
+static bool conn_compression_stream_wanted(const char *peer_capability)
+{
+  return (has_capability(ZSTREAM_CAPABILITY, our_capability)
+          && has_capability(ZSTREAM_CAPABILITY, peer_capability));
+}
+
+/**********************************************************************//**
+  Starts compressing the data sent to the connection as a deflate stream.
+  What is already queued is flushed first, the old way, as the other end
+  will only expect the stream after it got it.
+**************************************************************************/
+static void conn_compression_deflate_start(struct connection *pconn)
+{
+  z_stream *strm;
+
+  fc_assert_ret(NULL == pconn->compression.deflate);
+
+  if (0 < pconn->compression.queue.size) {
+    if (!conn_compression_flush(pconn)) {
+      return;
     }
+    byte_vector_reserve(&pconn->compression.queue, 0);
+  }
+
+  strm = fc_calloc(1, sizeof(*strm));
+  if (Z_OK != deflateInit2(strm, get_compression_level(), Z_DEFLATED,
+                           -MAX_WBITS, 8, Z_DEFAULT_STRATEGY)) {
+    log_error("Cannot start the packet stream compression for %s.",
+              conn_description(pconn));
+    free(strm);
+    connection_close(pconn, _("compression error"));
+    return;
+  }
+  pconn->compression.deflate = strm;
+}
+
+/**********************************************************************//**
+  Starts decompressing the data received from the connection as a
+  deflate stream.
+**************************************************************************/
+static void conn_compression_inflate_start(struct connection *pconn)
+{
+  z_stream *strm;
+
+  fc_assert_ret(NULL == pconn->compression.inflate);
+
+  strm = fc_calloc(1, sizeof(*strm));
+  if (Z_OK != inflateInit2(strm, -MAX_WBITS)) {
+    log_error("Cannot start the packet stream decompression.");
+    free(strm);
+    connection_close(pconn, _("decoding error"));
+    return;
+  }
+  pconn->compression.inflate = strm;
+}
+
+/**********************************************************************//**
+  Decompress the next chunk of the deflate stream received from the
+  connection. Returns the newly allocated data, and its size in
+  'decompressed_size', or NULL on error.
+**************************************************************************/
+static void *conn_compression_inflate(struct connection *pconn,
+                                      const void *data, uLong size,
+                                      unsigned long *decompressed_size)
+{
+  z_stream *strm = pconn->compression.inflate;
+  unsigned long alloc = MIN(20 * size + 256, MAX_LEN_BUFFER);
+  unsigned char *decompressed = fc_malloc(alloc);
+  int error;
+
+  strm->next_in = (Bytef *) data;
+  strm->avail_in = size;
+  strm->next_out = decompressed;
+  strm->avail_out = alloc;
+
+  for (;;) {
+    error = inflate(strm, Z_SYNC_FLUSH);
+    if ((Z_OK != error && Z_BUF_ERROR != error)
+        || 0 != strm->avail_out) {
+      break;
+    }
+
+    /* A chunk never holds more than a compression queue. */
+    if (alloc >= MAX_LEN_BUFFER) {
+      error = Z_DATA_ERROR;
+      break;
+    }
+    decompressed = fc_realloc(decompressed, 2 * alloc);
+    strm->next_out = decompressed + alloc;
+    strm->avail_out = alloc;
+    alloc *= 2;
+  }
+
+  if ((Z_OK != error && Z_BUF_ERROR != error) || 0 != strm->avail_in) {
+    free(decompressed);
+    return NULL;
+  }
+
+  *decompressed_size = alloc - strm->avail_out;
+  return decompressed;
+}
+
+/**********************************************************************//**
+  Free the compression streams of the connection.
+**************************************************************************/
+void conn_compression_streams_free(struct connection *pconn)
+{
+  if (NULL != pconn->compression.deflate) {
+    deflateEnd(pconn->compression.deflate);
+    free(pconn->compression.deflate);
+    pconn->compression.deflate = NULL;
+  }
+  if (NULL != pconn->compression.inflate) {
+    inflateEnd(pconn->compression.inflate);
+    free(pconn->compression.inflate);
+    pconn->compression.inflate = NULL;
+  }
+}
+
+/**********************************************************************//**
+  Send all waiting data. Return TRUE on success.
+**************************************************************************/
+static bool conn_compression_flush(struct connection *pconn)
+{
+  const struct compression_frame *pframe;
+
+  /* Compression signalling currently assumes a 2-byte packet length; if that
+   * changes, the protocol should probably be changed */
+  fc_assert_ret_val(data_type_size(pconn->packet_header.length) == 2, FALSE);
+
+  if (0 == pconn->compression.queue.size) {
+    return pconn->used;
+  }
+
+  if (NULL == pconn->compression.deflate) {
+    pframe = compression_frame_get(&pconn->compression.queue, FALSE);
+  } else if (COMPRESSION_SHARE_MIN_SIZE > pconn->compression.queue.size) {
+    /* Small batches gain the most from what was sent before. */
+    return conn_compression_stream_flush(pconn);
+  } else {
+    /* Big batches, like the broadcast ones, are compressed on their own
+     * and the chunk is spliced into the stream. As the other end now has
+     * data our stream doesn't know about, the stream must start over
+     * without referring to anything sent before. */
+    pframe = compression_frame_get(&pconn->compression.queue, TRUE);
+    if (pframe->compressed) {
+      deflateReset(pconn->compression.deflate);
+    }
+  }
+
+  if (pframe->compressed) {
+    stat_size_uncompressed += pconn->compression.queue.size;
+    stat_size_compressed += pframe->frame.size;
+    connection_send_data(pconn, pframe->frame.p, pframe->frame.size);
   } else {
-    log_compress("COMPRESS: would enlarge %lu bytes to %ld; "
-                 "sending uncompressed",
-                 (unsigned long) pconn->compression.queue.size,
-                 compressed_packet_len);
     connection_send_data(pconn, pconn->compression.queue.p,
                          pconn->compression.queue.size);
     stat_size_no_compression += pconn->compression.queue.size;
@@ -201,6 +545,208 @@ bool conn_compression_thaw(struct connection *pconn)
 }
 
 
+/* Header of the packets kept in the 'sent' hashes of the connections for
+ * the delta protocol. It links them by order of use, so the least
+ * recently used can be dropped when the memory limit is reached. */
+struct delta_cache_entry {
+  struct delta_cache *owner;
+  struct delta_cache_entry *prev;       /* More recently used. */
+  struct delta_cache_entry *next;       /* Less recently used. */
+  size_t size;                          /* Memory used, header included. */
+  enum packet_type type;
+};
+
+/* Room taken by the header before the packet, keeping it aligned. */
+#define DELTA_ENTRY_HEADER_SIZE \
+  ((sizeof(struct delta_cache_entry) + 15) & ~(size_t) 15)
+
+#define DELTA_ENTRY(packet) \
+  ((struct delta_cache_entry *) ((char *) (packet) - DELTA_ENTRY_HEADER_SIZE))
+#define DELTA_PACKET(pentry) ((void *) ((char *) (pentry) \
+                                        + DELTA_ENTRY_HEADER_SIZE))
+
+struct delta_cache {
+  struct delta_cache_entry *head;       /* Most recently used. */
+  struct delta_cache_entry *tail;       /* Least recently used. */
+  size_t size;
+  int entries;
+  int evictions;
+  /* Packet types of which some packets were dropped. Their new packets
+   * are sent in full, as the other end may still know an old version. */
+  bool evicted[PACKET_LAST];
+};
+
+/* Memory allowed to the delta cache of every connection. 0: no limit. */
+static size_t delta_cache_limit = 0;
+
+/**********************************************************************//**
+  Returns a new empty delta cache.
+**************************************************************************/
+struct delta_cache *delta_cache_new(void)
+{
+  return fc_calloc(1, sizeof(struct delta_cache));
+}
+
+/**********************************************************************//**
+  Free the delta cache. The hashes holding its packets must have been
+  destroyed before.
+**************************************************************************/
+void delta_cache_destroy(struct delta_cache *pcache)
+{
+  fc_assert(NULL == pcache->head);
+  free(pcache);
+}
+
+/**********************************************************************//**
+  Set the memory allowed to the delta cache of every connection, in
+  bytes. 0 means no limit.
+**************************************************************************/
+void delta_cache_set_limit(size_t limit)
+{
+  delta_cache_limit = limit;
+}
+
+/**********************************************************************//**
+  Remove the packet from the order of use.
+**************************************************************************/
+static void delta_cache_unlink(struct delta_cache_entry *pentry)
+{
+  struct delta_cache *pcache = pentry->owner;
+
+  if (NULL != pentry->prev) {
+    pentry->prev->next = pentry->next;
+  } else {
+    pcache->head = pentry->next;
+  }
+  if (NULL != pentry->next) {
+    pentry->next->prev = pentry->prev;
+  } else {
+    pcache->tail = pentry->prev;
+  }
+}
+
+/**********************************************************************//**
+  Make the packet the most recently used one.
+**************************************************************************/
+static void delta_cache_link(struct delta_cache_entry *pentry)
+{
+  struct delta_cache *pcache = pentry->owner;
+
+  pentry->prev = NULL;
+  pentry->next = pcache->head;
+  if (NULL != pcache->head) {
+    pcache->head->prev = pentry;
+  } else {
+    pcache->tail = pentry;
+  }
+  pcache->head = pentry;
+}
+
+/**********************************************************************//**
+  Drop the least recently used packet sent to the connection.
+**************************************************************************/
+static void delta_cache_evict(struct connection *pc)
+{
+  struct delta_cache_entry *pentry = pc->phs.sent_cache->tail;
+  void *packet = DELTA_PACKET(pentry);
+
+  log_packet("dropping a %s packet kept for %s",
+             packet_name(pentry->type), conn_description(pc));
+  pc->phs.sent_cache->evicted[pentry->type] = TRUE;
+  pc->phs.sent_cache->evictions++;
+
+  /* Frees the entry, see delta_cache_entry_free(). */
+  if (NULL == pc->phs.sent[pentry->type]
+      || !genhash_remove(pc->phs.sent[pentry->type], packet)) {
+    fc_assert_msg(FALSE, "%s packet not found in the delta hash.",
+                  packet_name(pentry->type));
+    delta_cache_entry_free(packet);
+  }
+}
+
+/**********************************************************************//**
+  Allocate 'size' bytes for a packet of the given type to be kept in the
+  delta hash of the packets sent to the connection. Least recently used
+  packets are dropped if needed to stay below the memory limit.
+**************************************************************************/
+void *delta_cache_entry_new(struct connection *pc, enum packet_type type,
+                            size_t size)
+{
+  struct delta_cache *pcache = pc->phs.sent_cache;
+  struct delta_cache_entry *pentry;
+
+  size += DELTA_ENTRY_HEADER_SIZE;
+  if (0 < delta_cache_limit) {
+    while (NULL != pcache->tail && pcache->size + size > delta_cache_limit) {
+      delta_cache_evict(pc);
+    }
+  }
+
+  pentry = fc_malloc(size);
+  pentry->owner = pcache;
+  pentry->size = size;
+  pentry->type = type;
+  delta_cache_link(pentry);
+  pcache->size += size;
+  pcache->entries++;
+
+  return DELTA_PACKET(pentry);
+}
+
+/**********************************************************************//**
+  Mark the packet kept for the delta protocol as just used.
+**************************************************************************/
+void delta_cache_entry_touch(void *packet)
+{
+  struct delta_cache_entry *pentry = DELTA_ENTRY(packet);
+
+  if (pentry->owner->head != pentry) {
+    delta_cache_unlink(pentry);
+    delta_cache_link(pentry);
+  }
+}
+
+/**********************************************************************//**
+  Free a packet allocated by delta_cache_entry_new(). Used as the data
+  free function of the delta hashes.
+**************************************************************************/
+void delta_cache_entry_free(void *packet)
+{
+  struct delta_cache_entry *pentry = DELTA_ENTRY(packet);
+
+  delta_cache_unlink(pentry);
+  pentry->owner->size -= pentry->size;
+  pentry->owner->entries--;
+  free(pentry);
+}
+
+/**********************************************************************//**
+  Returns TRUE if some packets of this type sent to the connection were
+  dropped from its delta cache.
+**************************************************************************/
+bool delta_cache_evicted(const struct connection *pc, enum packet_type type)
+{
+  return pc->phs.sent_cache->evicted[type];
+}
+
+/**********************************************************************//**
+  Get the number of packets kept by the delta cache of the connection,
+  the memory they use and how many were dropped.
+**************************************************************************/
+void delta_cache_stats(const struct connection *pc, int *entries,
+                       size_t *size, int *evictions)
+{
+  if (NULL == pc->phs.sent_cache) {
+    *entries = 0;
+    *size = 0;
+    *evictions = 0;
+  } else {
+    *entries = pc->phs.sent_cache->entries;
+    *size = pc->phs.sent_cache->size;
+    *evictions = pc->phs.sent_cache->evictions;
+  }
+}
+
 /**********************************************************************//**
   It returns the request id of the outgoing packet (or 0 if is_server()).
 **************************************************************************/
@@ -267,9 +813,10 @@ int send_packet_data(struct connection *pc, unsigned char *data, int len,
     }
 
     log_compress2("COMPRESS: STATS: alone=%d compression-expand=%d "
-                  "compression (before/after) = %d/%d",
+                  "compression (before/after) = %d/%d shared=%d",
                   stat_size_alone, stat_size_no_compression,
-                  stat_size_uncompressed, stat_size_compressed);
+                  stat_size_uncompressed, stat_size_compressed,
+                  stat_size_shared);
   }
 #else  /* USE_COMPRESSION */
   connection_send_data(pc, data, len);
@@ -440,30 +987,48 @@ void *get_packet_from_connection_raw(struct connection *pc,
     unsigned long int decompressed_size = decompress_factor * compressed_size;
     int error = Z_DATA_ERROR;
     struct socket_packet_buffer *buffer = pc->buffer;
-    void *decompressed = fc_malloc(decompressed_size);
-
-    do {
-      error =
-        uncompress(decompressed, &decompressed_size,
-                   ADD_TO_POINTER(buffer->data, header_size),
-                   compressed_size);
-
-      if (error == Z_DATA_ERROR) {
-        decompress_factor += 50;
-        decompressed_size = decompress_factor * compressed_size;
-        decompressed = fc_realloc(decompressed, decompressed_size);
+    void *decompressed;
+
+    if (NULL != pc->compression.inflate) {
+      decompressed = conn_compression_inflate(pc,
+                                              ADD_TO_POINTER(buffer->data,
+                                                             header_size),
+                                              compressed_size,
+                                              &decompressed_size);
+      if (NULL == decompressed) {
+        log_verbose("Uncompressing of the packet stream failed. "
+                    "The connection will be closed now.");
+        connection_close(pc, _("decoding error"));
+        return NULL;
       }
+    } else {
+      decompressed = fc_malloc(decompressed_size);
+
+      do {
+        error =
+          uncompress(decompressed, &decompressed_size,
+                     ADD_TO_POINTER(buffer->data, header_size),
+                     compressed_size);
+
+        if (error == Z_DATA_ERROR) {
+          decompress_factor += 50;
+          decompressed_size = decompress_factor * compressed_size;
+          decompressed = fc_realloc(decompressed, decompressed_size);
+        }
 
-      if (error != Z_OK) {
-        if (error != Z_DATA_ERROR || decompress_factor > MAX_DECOMPRESSION ) {
-          log_verbose("Uncompressing of the packet stream failed. "
-                      "The connection will be closed now.");
-          connection_close(pc, _("decoding error"));
-          return NULL;
+        if (error != Z_OK) {
+          if (error != Z_DATA_ERROR
+              || decompress_factor > MAX_DECOMPRESSION) {
+            log_verbose("Uncompressing of the packet stream failed. "
+                        "The connection will be closed now.");
+            free(decompressed);
+            connection_close(pc, _("decoding error"));
+            return NULL;
+          }
         }
-      }
 
-    } while (error != Z_OK);
+      } while (error != Z_OK);
+    }
 
     buffer->ndata -= whole_packet_len;
     /* 
@@ -629,7 +1194,8 @@ static inline void packet_header_set(struct packet_header *packet_header)
 }
 
 /**********************************************************************//**
-  Modify if needed the packet header field lengths.
+  Modify if needed the packet header field lengths, and start streaming
+  compression if both ends support it.
 **************************************************************************/
 void post_send_packet_server_join_reply(struct connection *pconn,
                                         const struct packet_server_join_reply
@@ -637,11 +1203,17 @@ void post_send_packet_server_join_reply(struct connection *pconn,
 {
   if (packet->you_can_join) {
     packet_header_set(&pconn->packet_header);
+#ifdef USE_COMPRESSION
+    if (conn_compression_stream_wanted(pconn->capability)) {
+      conn_compression_deflate_start(pconn);
+    }
+#endif /* USE_COMPRESSION */
   }
 }
 
 /**********************************************************************//**
-  Modify if needed the packet header field lengths.
+  Modify if needed the packet header field lengths, and expect streaming
+  compression if both ends support it.
 **************************************************************************/
 void post_receive_packet_server_join_reply(struct connection *pconn,
                                            const struct
@@ -649,6 +1221,11 @@ void post_receive_packet_server_join_reply(struct connection *pconn,
 {
   if (packet->you_can_join) {
     packet_header_set(&pconn->packet_header);
+#ifdef USE_COMPRESSION
+    if (conn_compression_stream_wanted(packet->capability)) {
+      conn_compression_inflate_start(pconn);
+    }
+#endif /* USE_COMPRESSION */
   }
 }
 
@@ -881,4 +1458,17 @@ const struct packet_handlers *packet_handlers_get(const char *capability)
 void packets_deinit(void)
 {
   packet_handlers_free();
+
+#ifdef USE_COMPRESSION
+  {
+    int i;
+
+    for (i = 0; i < COMPRESSION_FRAME_CACHE_SIZE; i++) {
+      byte_vector_free(&frame_cache[i].queue);
+      byte_vector_free(&frame_cache[i].frame);
+      frame_cache[i].last_use = 0;
+    }
+    byte_vector_free(&stream_frame);
+  }
+#endif /* USE_COMPRESSION */
 }
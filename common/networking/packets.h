@@ -139,6 +139,17 @@ const struct packet_handlers *packet_handlers_get(const char *capability);
 
 void packets_deinit(void);
 
+struct delta_cache *delta_cache_new(void);
+void delta_cache_destroy(struct delta_cache *pcache);
+void delta_cache_set_limit(size_t limit);
+void *delta_cache_entry_new(struct connection *pc, enum packet_type type,
+                            size_t size);
+void delta_cache_entry_touch(void *packet);
+void delta_cache_entry_free(void *packet);
+bool delta_cache_evicted(const struct connection *pc, enum packet_type type);
+void delta_cache_stats(const struct connection *pc, int *entries,
+                       size_t *size, int *evictions);
+
 #ifdef FREECIV_JSON_CONNECTION
 #include "packets_json.h"
 #else
@@ -25,6 +25,7 @@
 /* common */
 #include "ai.h"
 #include "city.h"
+#include "effects.h"
 #include "fc_interface.h"
 #include "featured_text.h"
 #include "game.h"
@@ -713,6 +714,7 @@ void player_destroy(struct player *pplayer)
 
   /* Remove all that is game-dependent in the player structure. */
   player_clear(pplayer, TRUE);
+  effect_cache_player_free(pplayer);
 
   fc_assert(0 == unit_list_size(pplayer->units));
   unit_list_destroy(pplayer->units);
@@ -312,6 +312,15 @@ struct player {
 
       struct player_tile *private_map;
 
+      /* Seen counts of the tiles, one plane per vision layer, indexed by
+       * tile index. They are much more often accessed than the remembered
+       * tile data of 'private_map', so they are kept apart, densely.
+       * If you build a city with an unknown square within city radius
+       * the square stays unknown. However, we still have to keep count
+       * of the seen points, so they are kept in 'tile_own_seen'. */
+      short int *tile_seen[V_COUNT];
+      short int *tile_own_seen[V_COUNT];
+
       /* Player can see inside his borders. */
       bool border_vision;
 
@@ -344,7 +353,7 @@ struct player {
       /* Only used at the client (the server is omniscient; ./client/). */
 
       /* Corresponds to the result of
-         (player:server:private_map[tile_index]:seen_count[vlayer] != 0). */
+         (player:server:tile_seen[vlayer][tile_index] != 0). */
       struct dbv tile_vision[V_COUNT];
 
       enum mood_type mood;
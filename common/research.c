@@ -22,6 +22,7 @@
 #include "support.h"
 
 /* common */
+#include "effects.h"
 #include "fc_types.h"
 #include "game.h"
 #include "player.h"
@@ -616,6 +617,7 @@ void research_update(struct research *presearch)
       }
     } advance_index_iterate_end;
   }
+  effect_cache_invalidate();
 }
 
 /************************************************************************//**
@@ -656,6 +658,7 @@ enum tech_state research_invention_set(struct research *presearch,
     return old;
   }
   presearch->inventions[tech].state = value;
+  effect_cache_invalidate();
 
   if (value == TECH_KNOWN) {
     if (!game.info.global_advances[tech]) {
@@ -24,6 +24,7 @@
 #include "support.h"
 
 /* common */
+#include "effects.h"
 #include "game.h"
 #include "player.h"
 #include "team.h"
@@ -483,6 +484,7 @@ void team_add_player(struct player *pplayer, struct team *pteam)
   /* Put the player on the new team. */
   pplayer->team = pteam;
   player_list_append(pteam->plrlist, pplayer);
+  effect_cache_invalidate();
 }
 
 /************************************************************************//**
@@ -39,6 +39,9 @@
 #include "traderoutes.h"
 #include "unitlist.h"
 
+/* aicore */
+#include "path_finding.h"
+
 #include "unit.h"
 
 static bool is_real_activity(enum unit_activity activity);
@@ -2171,6 +2174,8 @@ bool unit_transport_load(struct unit *pcargo, struct unit *ptrans, bool force)
   if (force || can_unit_load(pcargo, ptrans)) {
     pcargo->transporter = ptrans;
     unit_list_append(ptrans->transporting, pcargo);
+    pf_map_cache_invalidate_tile(unit_tile(ptrans), NULL);
+    action_cache_invalidate();
 
     return TRUE;
   }
@@ -2206,6 +2211,8 @@ bool unit_transport_unload(struct unit *pcargo)
 
   /* For the server (also safe for the client). */
   pcargo->transporter = NULL;
+  pf_map_cache_invalidate_tile(unit_tile(pcargo), NULL);
+  action_cache_invalidate();
 
   return TRUE;
 }
@@ -136,13 +136,14 @@ static bool explorer_goto(struct unit *punit, struct tile *ptile)
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
   parameter.get_TB = explorer_tb;
   adv_avoid_risks(&parameter, &risk_cost, punit, NORMAL_STACKING_FEARFULNESS);
+  parameter.goal_directed = TRUE;
 
   /* Show the destination in the client */
   punit->goto_tile = ptile;
 
   UNIT_LOG(LOG_DEBUG, punit, "explorer_goto to %d,%d", TILE_XY(ptile));
 
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
   path = pf_map_path(pfm, ptile);
 
   if (path != NULL) {
@@ -314,7 +315,7 @@ enum unit_move_result manage_auto_explorer(struct unit *punit)
   /* When exploring, even AI should pretend to not cheat. */
   parameter.omniscience = FALSE;
 
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
   pf_map_move_costs_iterate(pfm, ptile, move_cost, FALSE) {
     int desirable;
     double log_desirable;
@@ -460,7 +460,7 @@ adv_want settler_evaluate_improvements(struct unit *punit,
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
   parameter.get_TB = autosettler_tile_behavior;
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   city_list_iterate(pplayer->cities, pcity) {
     struct tile *pcenter = city_tile(pcity);
@@ -821,7 +821,7 @@ struct city *settler_evaluate_city_requests(struct unit *punit,
   pft_fill_unit_parameter(&parameter, punit);
   parameter.omniscience = !has_handicap(pplayer, H_MAP);
   parameter.get_TB = autosettler_tile_behavior;
-  pfm = pf_map_new(&parameter);
+  pfm = pf_map_new_shared(&parameter);
 
   /* Have nearby cities requests? */
   city_list_iterate(pplayer->cities, pcity) {
@@ -1059,7 +1059,8 @@ bool auto_settler_setup_work(struct player *pplayer, struct unit *punit,
       pft_fill_unit_parameter(&parameter, punit);
       parameter.omniscience = !has_handicap(pplayer, H_MAP);
       parameter.get_TB = autosettler_tile_behavior;
-      pfm = pf_map_new(&parameter);
+      parameter.goal_directed = TRUE;
+      pfm = pf_map_new_shared(&parameter);
       path = pf_map_path(pfm, best_tile);
     }
 
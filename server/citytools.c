@@ -29,11 +29,13 @@
 #include "support.h"
 
 /* common */
+#include "actions.h"
 #include "ai.h"
 #include "base.h"
 #include "citizens.h"
 #include "city.h"
 #include "culture.h"
+#include "effects.h"
 #include "events.h"
 #include "game.h"
 #include "government.h"
@@ -54,6 +56,7 @@
 
 /* common/aicore */
 #include "cm.h"
+#include "path_finding.h"
 
 /* common/scriptcore */
 #include "luascript_types.h"
@@ -98,7 +101,20 @@ static struct city_list *arrange_workers_queue = NULL;
 /* Suppress sending cities during game_load() and end_phase() */
 static bool send_city_suppressed = FALSE;
 
+/* Cities whose info is put off until the end of coalescing, see
+ * city_info_coalesce_begin(). */
+static struct city_list *city_info_queue = NULL;
+static int city_info_coalescing = 0;
+
+static struct {
+  unsigned int queued;          /* Sends put off until a flush. */
+  unsigned int merged;          /* Of those, sends of an already queued city. */
+  unsigned int unseen;          /* Sent early to a player losing sight. */
+} city_info_stats;
+
 static bool city_workers_queue_remove(struct city *pcity);
+static void city_info_queue_remove(struct city *pcity);
+static void send_city_short_info(struct player *pplayer, struct city *pcity);
 
 static void announce_trade_route_removal(struct city *pc1, struct city *pc2,
                                          bool source_gone);
@@ -1168,6 +1184,9 @@ bool transfer_city(struct player *ptaker, struct city *pcity,
   pcity->owner = ptaker;
   map_claim_ownership(pcenter, ptaker, pcenter, TRUE);
   city_list_prepend(ptaker->cities, pcity);
+  pf_map_cache_invalidate();
+  effect_cache_invalidate();
+  action_cache_invalidate();
 
   /* Hide/reveal units. Do it after vision have been given to taker, city
    * owner has been changed, and before any script could be spawned. */
@@ -1309,7 +1328,7 @@ bool transfer_city(struct player *ptaker, struct city *pcity,
      * having shared vision pact with him/her before (s)he may
      * lose vision to it. When we later send info to everybody seeing the city,
      * (s)he may not be included. */
-    send_city_info(NULL, pcity);
+    send_city_info_now(NULL, pcity);
   }
 
   /* Remove the sight points from the giver. */
@@ -1548,6 +1567,7 @@ void create_city(struct player *pplayer, struct tile *ptile,
   vision_reveal_tiles(pcity->server.vision, game.server.vision_reveal_tiles);
   city_refresh_vision(pcity);
   city_list_prepend(pplayer->cities, pcity);
+  pf_map_cache_invalidate_tile(ptile, NULL);
 
   /* This is dependent on the current vision, so must be done after
    * vision is prepared and before arranging workers. */
@@ -1805,6 +1825,7 @@ void remove_city(struct city *pcity)
     } unit_list_iterate_end;
   } players_iterate_end;
 
+  city_info_queue_remove(pcity);
   fc_allocate_mutex(&game.server.mutexes.city_list);
   game_remove_city(&wld, pcity);
   fc_release_mutex(&game.server.mutexes.city_list);
@@ -2062,6 +2083,110 @@ bool send_city_suppression(bool now)
   return formerly;
 }
 
+/************************************************************************//**
+  Start coalescing city info: until the matching city_info_coalesce_end(),
+  send_city_info() to the owner or to everyone only marks the city, and
+  each marked city is sent once at the end.  A player about to lose sight
+  of a marked city gets its info first, see city_info_send_unseen().
+  Coalescing may be nested; only the outermost end sends.
+****************************************************************************/
+void city_info_coalesce_begin(void)
+{
+  city_info_coalescing++;
+}
+
+/************************************************************************//**
+  End coalescing city info, sending the info of the marked cities if this
+  ends the outermost coalescing.
+****************************************************************************/
+void city_info_coalesce_end(void)
+{
+  struct city_list *queue = city_info_queue;
+
+  fc_assert_ret(0 < city_info_coalescing);
+
+  city_info_coalescing--;
+  if (0 < city_info_coalescing || NULL == queue) {
+    return;
+  }
+
+  city_info_queue = NULL;
+  city_list_iterate(queue, pcity) {
+    if (pcity->server.info_queued_all) {
+      send_city_info_now(NULL, pcity);
+    } else if (pcity->server.info_queued) {
+      send_city_info_now(city_owner(pcity), pcity);
+    }
+  } city_list_iterate_end;
+  city_list_destroy(queue);
+}
+
+/************************************************************************//**
+  Mark the city info to be sent at the end of coalescing, to everyone if
+  'to_all' is set, else to the owner.
+****************************************************************************/
+static void city_info_queue_add(struct city *pcity, bool to_all)
+{
+  bool queued = (pcity->server.info_queued
+                 || pcity->server.info_queued_all);
+
+  city_info_stats.queued++;
+
+  if (to_all) {
+    pcity->server.info_queued_all = TRUE;
+  } else {
+    pcity->server.info_queued = TRUE;
+  }
+
+  if (queued) {
+    city_info_stats.merged++;
+    return;
+  }
+
+  if (NULL == city_info_queue) {
+    city_info_queue = city_list_new();
+  }
+  city_list_append(city_info_queue, pcity);
+}
+
+/************************************************************************//**
+  Forget the queued info of a city that is going away.
+****************************************************************************/
+static void city_info_queue_remove(struct city *pcity)
+{
+  if (NULL != city_info_queue) {
+    city_list_remove_all(city_info_queue, pcity);
+  }
+  pcity->server.info_queued = FALSE;
+  pcity->server.info_queued_all = FALSE;
+}
+
+/************************************************************************//**
+  The player is about to lose sight of the city.  If the city info to
+  everyone is queued, send the player its info now, while it still
+  reaches the player.
+****************************************************************************/
+void city_info_send_unseen(struct player *pplayer, struct city *pcity)
+{
+  if (pcity->server.info_queued_all && pplayer != city_owner(pcity)
+      && player_can_see_city_externals(pplayer, pcity)) {
+    city_info_stats.unseen++;
+    send_city_short_info(pplayer, pcity);
+  }
+}
+
+/************************************************************************//**
+  Log how many city info sends coalescing saved, and reset the counts.
+****************************************************************************/
+void city_info_coalesce_stats_log(void)
+{
+  log_normal(_("City info coalescing: %u sends queued, %u merged, "
+               "%u sent early to players losing sight."),
+             city_info_stats.queued, city_info_stats.merged,
+             city_info_stats.unseen);
+  memset(&city_info_stats, 0, sizeof(city_info_stats));
+}
+
 /************************************************************************//**
   This fills out a package from a player's vision_site.
 ****************************************************************************/
@@ -2114,6 +2239,20 @@ void refresh_dumb_city(struct city *pcity)
    * information. */
 }
 
+/************************************************************************//**
+  Update the player's knowledge of the city, which the player can see
+  from outside, and send it.
+****************************************************************************/
+static void send_city_short_info(struct player *pplayer, struct city *pcity)
+{
+  struct packet_city_short_info sc_pack;
+
+  reality_check_city(pplayer, pcity->tile);
+  update_dumb_city(pplayer, pcity);
+  package_dumb_city(pplayer, pcity->tile, &sc_pack);
+  lsend_packet_city_short_info(pplayer->connections, &sc_pack);
+}
+
 /************************************************************************//**
   Broadcast info about a city to all players who observe the tile. 
   If the player can see the city we update the city info first.
@@ -2126,7 +2265,6 @@ static void broadcast_city_info(struct city *pcity)
 {
   struct packet_city_info packet;
   struct packet_web_city_info_addition web_packet;
-  struct packet_city_short_info sc_pack;
   struct player *powner = city_owner(pcity);
   struct traderoute_packet_list *routes = traderoute_packet_list_new();
 
@@ -2144,10 +2282,7 @@ static void broadcast_city_info(struct city *pcity)
       }
     } else {
       if (player_can_see_city_externals(pplayer, pcity)) {
-        reality_check_city(pplayer, pcity->tile);
-	update_dumb_city(pplayer, pcity);
-	package_dumb_city(pplayer, pcity->tile, &sc_pack);
-	lsend_packet_city_short_info(pplayer->connections, &sc_pack);
+        send_city_short_info(pplayer, pcity);
       }
     }
   } players_iterate_end;
@@ -2212,6 +2347,8 @@ void send_player_cities(struct player *pplayer)
   A wrapper, accessing either broadcast_city_info() (dest == NULL),
   or a convenience case of send_city_info_at_tile().
   Must specify non-NULL pcity.
+  While city info is coalesced, the sends to the owner and to everyone
+  are put off; see city_info_coalesce_begin().
 ****************************************************************************/
 void send_city_info(struct player *dest, struct city *pcity)
 {
@@ -2225,6 +2362,40 @@ void send_city_info(struct player *dest, struct city *pcity)
     return;
   }
 
+  if (0 < city_info_coalescing && (!dest || dest == powner)
+      && !send_city_suppressed) {
+    city_info_queue_add(pcity, !dest);
+    return;
+  }
+
+  send_city_info_now(dest, pcity);
+}
+
+/************************************************************************//**
+  Like send_city_info(), but sends right away even while city info is
+  coalesced.  Needed when the viewers may change before the end of
+  coalescing.
+****************************************************************************/
+void send_city_info_now(struct player *dest, struct city *pcity)
+{
+  struct player *powner = city_owner(pcity);
+
+  if (S_S_RUNNING != server_state() && S_S_OVER != server_state()) {
+    return;
+  }
+
+  if (dest == powner && send_city_suppressed) {
+    return;
+  }
+
+  if (!dest || dest == powner) {
+    /* This covers the queued send. */
+    pcity->server.info_queued = FALSE;
+  }
+  if (!dest) {
+    pcity->server.info_queued_all = FALSE;
+  }
+
   if (!dest || dest == powner) {
     pcity->server.synced = TRUE;
   }
@@ -2712,6 +2883,13 @@ struct trade_route *remove_trade_route(struct city *pc1, struct trade_route *pro
 
   fc_assert_ret_val(pc1 && proute, NULL);
 
+  if (pc2 != NULL) {
+    /* The trade route may be all that shows each city to the other's
+     * owner. */
+    city_info_send_unseen(city_owner(pc2), pc1);
+    city_info_send_unseen(city_owner(pc1), pc2);
+  }
+
   trade_route_list_remove(pc1->routes, proute);
 
   if (pc2 != NULL) {
@@ -45,7 +45,12 @@ struct city *find_closest_city(const struct tile *ptile,
 bool unit_conquer_city(struct unit *punit, struct city *pcity);
 
 bool send_city_suppression(bool now);
+void city_info_coalesce_begin(void);
+void city_info_coalesce_end(void);
+void city_info_send_unseen(struct player *pplayer, struct city *pcity);
+void city_info_coalesce_stats_log(void);
 void send_city_info(struct player *dest, struct city *pcity);
+void send_city_info_now(struct player *dest, struct city *pcity);
 void send_city_info_at_tile(struct player *pviewer, struct conn_list *dest,
 			    struct city *pcity, struct tile *ptile);
 void send_all_known_cities(struct conn_list *dest);
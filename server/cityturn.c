@@ -176,14 +176,21 @@ bool city_refresh(struct city *pcity)
 **************************************************************************/
 void city_refresh_for_player(struct player *pplayer)
 {
+  struct city_list *arrange = city_list_new();
+
   conn_list_do_buffer(pplayer->connections);
   city_list_iterate(pplayer->cities, pcity) {
     if (city_refresh(pcity)) {
-      auto_arrange_workers(pcity);
+      city_list_append(arrange, pcity);
     }
+  } city_list_iterate_end;
+  auto_arrange_workers_list(arrange);
+  city_list_iterate(pplayer->cities, pcity) {
     send_city_info(pplayer, pcity);
   } city_list_iterate_end;
   conn_list_do_unbuffer(pplayer->connections);
+
+  city_list_destroy(arrange);
 }
 
 /**********************************************************************//**
@@ -207,19 +214,31 @@ void city_refresh_queue_add(struct city *pcity)
 **************************************************************************/
 void city_refresh_queue_processing(void)
 {
+  struct city_list *refreshed, *arrange;
+
   if (NULL == city_refresh_queue) {
     return;
   }
 
+  refreshed = city_list_new();
+  arrange = city_list_new();
+
   city_list_iterate(city_refresh_queue, pcity) {
     if (pcity->server.needs_refresh) {
       if (city_refresh(pcity)) {
-        auto_arrange_workers(pcity);
+        city_list_append(arrange, pcity);
       }
-      send_city_info(city_owner(pcity), pcity);
+      city_list_append(refreshed, pcity);
     }
   } city_list_iterate_end;
 
+  auto_arrange_workers_list(arrange);
+  city_list_iterate(refreshed, pcity) {
+    send_city_info(city_owner(pcity), pcity);
+  } city_list_iterate_end;
+
+  city_list_destroy(refreshed);
+  city_list_destroy(arrange);
   city_list_destroy(city_refresh_queue);
   city_refresh_queue = NULL;
 }
@@ -350,21 +369,12 @@ static void set_default_city_manager(struct cm_parameter *cmp,
 }
 
 /**********************************************************************//**
-  Call sync_cities() to send the affected cities to the clients.
+  Bring the city up to date before arranging its workers, and set up the
+  parameter of the first CM query.
 **************************************************************************/
-void auto_arrange_workers(struct city *pcity)
+static void arrange_workers_prepare(struct city *pcity,
+                                    struct cm_parameter *cmp)
 {
-  struct cm_parameter cmp;
-  struct cm_result *cmr;
-
-  /* See comment in freeze_workers(): we can't rearrange while
-   * workers are frozen (i.e. multiple updates need to be done). */
-  if (pcity->server.workers_frozen > 0) {
-    pcity->server.needs_arrange = TRUE;
-    return;
-  }
-  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_START);
-
   /* Freeze the workers and make sure all the tiles around the city
    * are up to date.  Then thaw, but hackishly make sure that thaw
    * doesn't call us recursively, which would waste time. */
@@ -380,15 +390,56 @@ void auto_arrange_workers(struct city *pcity)
   city_refresh(pcity);
 
   sanity_check_city(pcity);
-  cm_clear_cache(pcity);
 
-  cm_init_parameter(&cmp);
+  cm_init_parameter(cmp);
 
   if (pcity->cm_parameter) {
-    cm_copy_parameter(&cmp, pcity->cm_parameter);
+    cm_copy_parameter(cmp, pcity->cm_parameter);
   } else {
-    set_default_city_manager(&cmp, pcity);
+    set_default_city_manager(cmp, pcity);
+  }
+}
+
+/**********************************************************************//**
+  Move the workers of the city as the CM result says.
+**************************************************************************/
+static void arrange_workers_apply(struct city *pcity,
+                                  const struct cm_result *cmr)
+{
+  apply_cmresult_to_city(pcity, cmr);
+
+  if (pcity->server.debug) {
+    /* Print debug output if requested. */
+    cm_print_city(pcity);
+    cm_print_result(cmr);
+  }
+
+  if (city_refresh(pcity)) {
+    log_error("%s radius changed when already arranged workers.",
+              city_name_get(pcity));
+    /* Can't do anything - don't want to enter infinite recursive loop
+     * by trying to arrange workers more. */
   }
+  sanity_check_city(pcity);
+}
+
+/**********************************************************************//**
+  Call sync_cities() to send the affected cities to the clients.
+**************************************************************************/
+void auto_arrange_workers(struct city *pcity)
+{
+  struct cm_parameter cmp;
+  struct cm_result *cmr;
+
+  /* See comment in freeze_workers(): we can't rearrange while
+   * workers are frozen (i.e. multiple updates need to be done). */
+  if (pcity->server.workers_frozen > 0) {
+    pcity->server.needs_arrange = TRUE;
+    return;
+  }
+  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_START);
+
+  arrange_workers_prepare(pcity, &cmp);
 
   /* This must be after city_refresh() so that the result gets created for the right
    * city radius */
@@ -432,24 +483,90 @@ void auto_arrange_workers(struct city *pcity)
   }
   fc_assert_ret(cmr->found_a_valid);
 
-  apply_cmresult_to_city(pcity, cmr);
+  arrange_workers_apply(pcity, cmr);
 
-  if (pcity->server.debug) {
-    /* Print debug output if requested. */
-    cm_print_city(pcity);
-    cm_print_result(cmr);
+  cm_result_destroy(cmr);
+  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_STOP);
+}
+
+/**********************************************************************//**
+  Return TRUE iff the city may still work all the tiles of the result.
+  Results of a batch are computed before any of them is applied, so a
+  city arranged earlier may have taken a tile since.
+**************************************************************************/
+static bool cmresult_is_workable(const struct city *pcity,
+                                 const struct cm_result *cmr)
+{
+  int radius_sq = city_map_radius_sq_get(pcity);
+
+  if (cmr->city_radius_sq != radius_sq) {
+    return FALSE;
   }
 
-  if (city_refresh(pcity)) {
-    log_error("%s radius changed when already arranged workers.",
-              city_name_get(pcity));
-    /* Can't do anything - don't want to enter infinite recursive loop
-     * by trying to arrange workers more. */
+  city_tile_iterate_skip_free_worked(radius_sq, city_tile(pcity),
+                                     ptile, idx, x, y) {
+    if (cmr->worker_positions[idx] && !city_can_work_tile(pcity, ptile)) {
+      return FALSE;
+    }
+  } city_tile_iterate_skip_free_worked_end;
+
+  return TRUE;
+}
+
+/**********************************************************************//**
+  Like auto_arrange_workers() for each city of the list.  With the
+  'cmthreads' server setting, the first CM query of all cities is solved
+  at once by several threads, and the results are then applied one city
+  after the other.  Cities whose query fails, or whose result can no
+  longer be applied, go through auto_arrange_workers() afterwards.
+**************************************************************************/
+void auto_arrange_workers_list(struct city_list *pcities)
+{
+  struct cm_query *queries;
+  struct cm_parameter *params;
+  int num_queries = 0, i;
+
+  if (0 == game.server.cm_threads) {
+    city_list_iterate(pcities, pcity) {
+      auto_arrange_workers(pcity);
+    } city_list_iterate_end;
+    return;
   }
-  sanity_check_city(pcity);
 
-  cm_result_destroy(cmr);
+  queries = fc_malloc(city_list_size(pcities) * sizeof(*queries));
+  params = fc_malloc(city_list_size(pcities) * sizeof(*params));
+
+  TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_START);
+  city_list_iterate(pcities, pcity) {
+    if (pcity->server.workers_frozen > 0) {
+      pcity->server.needs_arrange = TRUE;
+      continue;
+    }
+    arrange_workers_prepare(pcity, &params[num_queries]);
+    queries[num_queries].pcity = pcity;
+    queries[num_queries].parameter = &params[num_queries];
+    queries[num_queries].result = cm_result_new(pcity);
+    queries[num_queries].negative_ok = FALSE;
+    num_queries++;
+  } city_list_iterate_end;
+
+  cm_query_result_batch(queries, num_queries, game.server.cm_threads);
   TIMING_LOG(AIT_CITIZEN_ARRANGE, TIMER_STOP);
+
+  for (i = 0; i < num_queries; i++) {
+    struct city *pcity = queries[i].pcity;
+    struct cm_result *cmr = queries[i].result;
+
+    if (cmr->found_a_valid && cmresult_is_workable(pcity, cmr)) {
+      arrange_workers_apply(pcity, cmr);
+    } else {
+      auto_arrange_workers(pcity);
+    }
+    cm_result_destroy(cmr);
+  }
+
+  free(queries);
+  free(params);
 }
 
 /**********************************************************************//**
@@ -90,6 +90,7 @@ static struct command commands[] = {
              "list colors\n"
              "list connections\n"
              "list delegations\n"
+             "list delta caches\n"
              "list ignored users\n"
              "list map image definitions\n"
              "list players\n"
@@ -104,6 +105,7 @@ static struct command commands[] = {
       " - the player colors,\n"
       " - connections to the server,\n"
       " - all player delegations,\n"
+      " - the memory used by the delta protocol for each connection,\n"
       " - your ignore list,\n"
       " - the list of defined map images,\n"
       " - the list of the players in the game,\n"
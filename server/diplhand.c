@@ -35,6 +35,9 @@
 #include "research.h"
 #include "unit.h"
 
+/* common/aicore */
+#include "path_finding.h"
+
 /* common/scriptcore */
 #include "luascript_types.h"
 
@@ -685,6 +688,7 @@ void handle_diplomacy_accept_treaty_req(struct player *pplayer,
       }
 
     } clause_list_iterate_end;
+    pf_map_cache_invalidate();
 
     /* In theory, we would need refresh only receiving party of
      * CLAUSE_MAP, CLAUSE_SEAMAP and CLAUSE_VISION clauses.
@@ -39,6 +39,9 @@
 #include "unitlist.h"
 #include "vision.h"
 
+/* aicore */
+#include "path_finding.h"
+
 /* server */
 #include "citytools.h"
 #include "cityturn.h"
@@ -640,12 +643,18 @@ static void shared_vision_change_seen(struct player *pplayer,
 }
 
 /**********************************************************************//**
-  There doesn't have to be a city.
+  Change the vision at 'ptile' from 'old_radius_sq' to 'new_radius_sq'.
+  If 'other_tile' is not NULL, the tiles (per vision layer) also covered
+  by the vision of the same player at 'other_tile' with 'other_radius_sq'
+  are left untouched, see vision_change_sight_from().
 **************************************************************************/
-void map_vision_update(struct player *pplayer, struct tile *ptile,
-                       const v_radius_t old_radius_sq,
-                       const v_radius_t new_radius_sq,
-                       bool can_reveal_tiles)
+static void map_vision_update_masked(struct player *pplayer,
+                                     struct tile *ptile,
+                                     const v_radius_t old_radius_sq,
+                                     const v_radius_t new_radius_sq,
+                                     bool can_reveal_tiles,
+                                     struct tile *other_tile,
+                                     const v_radius_t other_radius_sq)
 {
   v_radius_t change;
   int max_radius;
@@ -678,20 +687,43 @@ void map_vision_update(struct player *pplayer, struct tile *ptile,
 
   buffer_shared_vision(pplayer);
   circle_dxyr_iterate(&(wld.map), ptile, max_radius, tile1, dx, dy, dr) {
+    bool changed = FALSE;
+    int other_dr = (NULL != other_tile
+                    ? sq_map_distance(other_tile, tile1) : 0);
+
     vision_layer_iterate(v) {
-      if (dr > old_radius_sq[v] && dr <= new_radius_sq[v]) {
+      if (NULL != other_tile && other_dr <= other_radius_sq[v]) {
+        /* Seen from the other vision source anyway. */
+        change[v] = 0;
+      } else if (dr > old_radius_sq[v] && dr <= new_radius_sq[v]) {
         change[v] = 1;
+        changed = TRUE;
       } else if (dr > new_radius_sq[v] && dr <= old_radius_sq[v]) {
         change[v] = -1;
+        changed = TRUE;
       } else {
         change[v] = 0;
       }
     } vision_layer_iterate_end;
-    shared_vision_change_seen(pplayer, tile1, change, can_reveal_tiles);
+    if (changed || NULL == other_tile) {
+      shared_vision_change_seen(pplayer, tile1, change, can_reveal_tiles);
+    }
   } circle_dxyr_iterate_end;
   unbuffer_shared_vision(pplayer);
 }
 
+/**********************************************************************//**
+  There doesn't have to be a city.
+**************************************************************************/
+void map_vision_update(struct player *pplayer, struct tile *ptile,
+                       const v_radius_t old_radius_sq,
+                       const v_radius_t new_radius_sq,
+                       bool can_reveal_tiles)
+{
+  map_vision_update_masked(pplayer, ptile, old_radius_sq, new_radius_sq,
+                           can_reveal_tiles, NULL, NULL);
+}
+
 /**********************************************************************//**
   Turn a players ability to see inside his borders on or off.
 
@@ -879,7 +911,7 @@ static inline int map_get_seen(const struct player *pplayer,
                                const struct tile *ptile,
                                enum vision_layer vlayer)
 {
-  return map_get_player_tile(ptile, pplayer)->seen_count[vlayer];
+  return pplayer->server.tile_seen[vlayer][tile_index(ptile)];
 }
 
 /**********************************************************************//**
@@ -893,16 +925,21 @@ void map_change_seen(struct player *pplayer,
                      const v_radius_t change,
                      bool can_reveal_tiles)
 {
-  struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
+  int tindex = tile_index(ptile);
+  v_radius_t seen_count;
   bool revealing_tile = FALSE;
 
+  vision_layer_iterate(v) {
+    seen_count[v] = pplayer->server.tile_seen[v][tindex];
+  } vision_layer_iterate_end;
+
 #ifdef FREECIV_DEBUG
   log_debug("%s() for player %s (nb %d) at (%d, %d).",
             __FUNCTION__, player_name(pplayer), player_number(pplayer),
             TILE_XY(ptile));
   vision_layer_iterate(v) {
     log_debug("  vision layer %d is changing from %d to %d.",
-              v, plrtile->seen_count[v], plrtile->seen_count[v] + change[v]);
+              v, seen_count[v], seen_count[v] + change[v]);
   } vision_layer_iterate_end;
 #endif /* FREECIV_DEBUG */
 
@@ -910,7 +947,7 @@ void map_change_seen(struct player *pplayer,
    * we must remove all units before fog of war because clients expect
    * the tile is empty when it is fogged. */
   if (0 > change[V_INVIS]
-      && plrtile->seen_count[V_INVIS] == -change[V_INVIS]) {
+      && seen_count[V_INVIS] == -change[V_INVIS]) {
     log_debug("(%d, %d): hiding invisible units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -922,7 +959,7 @@ void map_change_seen(struct player *pplayer,
     } unit_list_iterate_end;
   }
   if (0 > change[V_SUBSURFACE]
-      && plrtile->seen_count[V_SUBSURFACE] == -change[V_SUBSURFACE]) {
+      && seen_count[V_SUBSURFACE] == -change[V_SUBSURFACE]) {
     log_debug("(%d, %d): hiding subsurface units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -935,7 +972,7 @@ void map_change_seen(struct player *pplayer,
   }
 
   if (0 > change[V_MAIN]
-      && plrtile->seen_count[V_MAIN] == -change[V_MAIN]) {
+      && seen_count[V_MAIN] == -change[V_MAIN]) {
     log_debug("(%d, %d): hiding visible units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -947,10 +984,23 @@ void map_change_seen(struct player *pplayer,
     } unit_list_iterate_end;
   }
 
+  if (0 > change[V_MAIN]
+      && seen_count[V_MAIN] == -change[V_MAIN]
+      && NULL != tile_city(ptile)) {
+    /* Last chance to get the coalesced city info. */
+    city_info_send_unseen(pplayer, tile_city(ptile));
+  }
+
+  if ((0 == seen_count[V_MAIN])
+      != (0 == seen_count[V_MAIN] + change[V_MAIN])) {
+    /* The tile becomes seen or fogged for the player's path-finding. */
+    pf_map_cache_invalidate_tile(ptile, pplayer);
+  }
   vision_layer_iterate(v) {
     /* Avoid underflow. */
-    fc_assert(0 <= change[v] || -change[v] <= plrtile->seen_count[v]);
-    plrtile->seen_count[v] += change[v];
+    fc_assert(0 <= change[v] || -change[v] <= seen_count[v]);
+    seen_count[v] += change[v];
+    pplayer->server.tile_seen[v][tindex] = seen_count[v];
   } vision_layer_iterate_end;
 
   /* V_MAIN vision ranges must always be more than invisible ranges
@@ -958,13 +1008,13 @@ void map_change_seen(struct player *pplayer,
    * seen count cannot be inferior to V_INVIS or V_SUBSURFACE seen count.
    * Moreover, when the fog of war is disabled, V_MAIN has an extra
    * seen count point. */
-  fc_assert(plrtile->seen_count[V_INVIS] + !game.info.fogofwar
-            <= plrtile->seen_count[V_MAIN]);
-  fc_assert(plrtile->seen_count[V_SUBSURFACE] + !game.info.fogofwar
-            <= plrtile->seen_count[V_MAIN]);
+  fc_assert(seen_count[V_INVIS] + !game.info.fogofwar
+            <= seen_count[V_MAIN]);
+  fc_assert(seen_count[V_SUBSURFACE] + !game.info.fogofwar
+            <= seen_count[V_MAIN]);
 
   if (!map_is_known(ptile, pplayer)) {
-    if (0 < plrtile->seen_count[V_MAIN] && can_reveal_tiles) {
+    if (0 < seen_count[V_MAIN] && can_reveal_tiles) {
       log_debug("(%d, %d): revealing tile to player %s (nb %d).",
                 TILE_XY(ptile), player_name(pplayer),
                 player_number(pplayer));
@@ -977,7 +1027,9 @@ void map_change_seen(struct player *pplayer,
   }
 
   /* Fog the tile. */
-  if (0 > change[V_MAIN] && 0 == plrtile->seen_count[V_MAIN]) {
+  if (0 > change[V_MAIN] && 0 == seen_count[V_MAIN]) {
+    struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
+
     log_debug("(%d, %d): fogging tile for player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer), player_number(pplayer));
 
@@ -989,12 +1041,12 @@ void map_change_seen(struct player *pplayer,
     send_tile_info(pplayer->connections, ptile, FALSE);
   }
 
-  if ((revealing_tile && 0 < plrtile->seen_count[V_MAIN])
+  if ((revealing_tile && 0 < seen_count[V_MAIN])
       || (0 < change[V_MAIN]
-          /* plrtile->seen_count[V_MAIN] Always set to 1
+          /* seen_count[V_MAIN] Always set to 1
             * when the fog of war is disabled. */
           && (change[V_MAIN] + !game.info.fogofwar
-              == (plrtile->seen_count[V_MAIN])))) {
+              == (seen_count[V_MAIN])))) {
     struct city *pcity;
 
     log_debug("(%d, %d): unfogging tile for player %s (nb %d).",
@@ -1022,9 +1074,9 @@ void map_change_seen(struct player *pplayer,
     }
   }
 
-  if ((revealing_tile && 0 < plrtile->seen_count[V_INVIS])
+  if ((revealing_tile && 0 < seen_count[V_INVIS])
       || (0 < change[V_INVIS]
-          && change[V_INVIS] == plrtile->seen_count[V_INVIS])) {
+          && change[V_INVIS] == seen_count[V_INVIS])) {
     log_debug("(%d, %d): revealing invisible units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer),
               player_number(pplayer));
@@ -1035,9 +1087,9 @@ void map_change_seen(struct player *pplayer,
       }
     } unit_list_iterate_end;
   }
-  if ((revealing_tile && 0 < plrtile->seen_count[V_SUBSURFACE])
+  if ((revealing_tile && 0 < seen_count[V_SUBSURFACE])
       || (0 < change[V_SUBSURFACE]
-          && change[V_SUBSURFACE] == plrtile->seen_count[V_SUBSURFACE])) {
+          && change[V_SUBSURFACE] == seen_count[V_SUBSURFACE])) {
     log_debug("(%d, %d): revealing subsurface units to player %s (nb %d).",
               TILE_XY(ptile), player_name(pplayer),
               player_number(pplayer));
@@ -1060,7 +1112,7 @@ static inline int map_get_own_seen(const struct player *pplayer,
                                    const struct tile *ptile,
                                    enum vision_layer vlayer)
 {
-  return map_get_player_tile(ptile, pplayer)->own_seen[vlayer];
+  return pplayer->server.tile_own_seen[vlayer][tile_index(ptile)];
 }
 
 /**********************************************************************//**
@@ -1070,10 +1122,10 @@ static void map_change_own_seen(struct player *pplayer,
                                 struct tile *ptile,
                                 const v_radius_t change)
 {
-  struct player_tile *plrtile = map_get_player_tile(ptile, pplayer);
+  int tindex = tile_index(ptile);
 
   vision_layer_iterate(v) {
-    plrtile->own_seen[v] += change[v];
+    pplayer->server.tile_own_seen[v][tindex] += change[v];
   } vision_layer_iterate_end;
 }
 
@@ -1102,6 +1154,7 @@ void change_playertile_site(struct player_tile *ptile,
 void map_set_known(struct tile *ptile, struct player *pplayer)
 {
   dbv_set(&pplayer->tile_known, tile_index(ptile));
+  pf_map_cache_invalidate_tile(ptile, pplayer);
 }
 
 /**********************************************************************//**
@@ -1110,6 +1163,7 @@ void map_set_known(struct tile *ptile, struct player *pplayer)
 void map_clear_known(struct tile *ptile, struct player *pplayer)
 {
   dbv_clr(&pplayer->tile_known, tile_index(ptile));
+  pf_map_cache_invalidate_tile(ptile, pplayer);
 }
 
 /**********************************************************************//**
@@ -1152,6 +1206,25 @@ void player_map_init(struct player *pplayer)
     player_tile_init(ptile, pplayer);
   } whole_map_iterate_end;
 
+  /* We need to use fogofwar_old here, so the player's tiles get
+   * in the same state as the other players' tiles. */
+  vision_layer_iterate(v) {
+    short int initial = (V_MAIN == v ? !game.server.fogofwar_old : 0);
+    int i;
+
+    pplayer->server.tile_seen[v]
+      = fc_realloc(pplayer->server.tile_seen[v],
+                   MAP_INDEX_SIZE * sizeof(*pplayer->server.tile_seen[v]));
+    pplayer->server.tile_own_seen[v]
+      = fc_realloc(pplayer->server.tile_own_seen[v],
+                   MAP_INDEX_SIZE
+                   * sizeof(*pplayer->server.tile_own_seen[v]));
+    for (i = 0; i < MAP_INDEX_SIZE; i++) {
+      pplayer->server.tile_seen[v][i] = initial;
+      pplayer->server.tile_own_seen[v][i] = initial;
+    }
+  } vision_layer_iterate_end;
+
   dbv_init(&pplayer->tile_known, MAP_INDEX_SIZE);
 }
 
@@ -1171,6 +1244,13 @@ void player_map_free(struct player *pplayer)
   free(pplayer->server.private_map);
   pplayer->server.private_map = NULL;
 
+  vision_layer_iterate(v) {
+    free(pplayer->server.tile_seen[v]);
+    pplayer->server.tile_seen[v] = NULL;
+    free(pplayer->server.tile_own_seen[v]);
+    pplayer->server.tile_own_seen[v] = NULL;
+  } vision_layer_iterate_end;
+
   dbv_free(&pplayer->tile_known);
 }
 
@@ -1246,8 +1326,8 @@ void remove_player_from_maps(struct player *pplayer)
 }
 
 /**********************************************************************//**
-  We need to use fogofwar_old here, so the player's tiles get
-  in the same state as the other players' tiles.
+  Initialise what the player remembers about the tile. The seen counts are
+  initialised by player_map_init().
 **************************************************************************/
 static void player_tile_init(struct tile *ptile, struct player *pplayer)
 {
@@ -1265,10 +1345,6 @@ static void player_tile_init(struct tile *ptile, struct player *pplayer)
     plrtile->last_updated = game.info.year;
   }
 
-  plrtile->seen_count[V_MAIN] = !game.server.fogofwar_old;
-  plrtile->seen_count[V_INVIS] = 0;
-  plrtile->seen_count[V_SUBSURFACE] = 0;
-  memcpy(plrtile->own_seen, plrtile->seen_count, sizeof(v_radius_t));
 }
 
 /**********************************************************************//**
@@ -1364,6 +1440,9 @@ bool update_player_tile_knowledge(struct player *pplayer, struct tile *ptile)
 **************************************************************************/
 void update_tile_knowledge(struct tile *ptile)
 {
+  /* The tile changed, so may do the paths through it. */
+  pf_map_cache_invalidate_tile(ptile, NULL);
+
   if (server_state() == S_S_INITIAL) {
     return;
   }
@@ -2360,6 +2439,87 @@ void vision_clear_sight(struct vision *vision)
   vision_change_sight(vision, vision_radius_sq);
 }
 
+/**********************************************************************//**
+  Returns whether the sight of 'vision', which doesn't hold any sight
+  point yet, may skip the tiles seen by 'other'. Both must belong to the
+  same player with the same reveal rules, and the two vision circles must
+  be small enough compared to the map that they cannot wrap onto
+  themselves, else the distance between the tiles may not match the one
+  used while iterating the circles.
+**************************************************************************/
+static bool vision_can_overlap(const struct vision *vision,
+                               const v_radius_t radius_sq,
+                               const struct vision *other)
+{
+  int max_radius_sq = 0;
+  int cr_radius;
+
+  if (NULL == other
+      || vision->radius_sq[V_MAIN] >= 0
+      || vision->player != other->player
+      || vision->can_reveal_tiles != other->can_reveal_tiles) {
+    return FALSE;
+  }
+
+  vision_layer_iterate(v) {
+    max_radius_sq = MAX(max_radius_sq, radius_sq[v]);
+    max_radius_sq = MAX(max_radius_sq, vision->radius_sq[v]);
+    max_radius_sq = MAX(max_radius_sq, other->radius_sq[v]);
+  } vision_layer_iterate_end;
+
+  /* Conservative for every topology (natural vs native sizes). */
+  cr_radius = (int) sqrt((double) max_radius_sq);
+
+  return 4 * cr_radius + 2 < MIN(wld.map.xsize, wld.map.ysize);
+}
+
+/**********************************************************************//**
+  Like vision_change_sight(), but 'vision' is a new vision source
+  replacing 'old_vision' (same owner, usually on a neighbouring tile),
+  which still holds its sight points. Returns TRUE if the tiles already
+  seen by 'old_vision' have been skipped; then the sight of 'old_vision'
+  must later be removed with vision_clear_sight_to(), passing the tile of
+  'vision' and the 'radius_sq' given here, whatever happened to 'vision'
+  meanwhile.
+
+  This way the tiles seen from both the old and the new places don't go
+  through a useless increment and decrement of their seen counts.
+**************************************************************************/
+bool vision_change_sight_from(struct vision *vision,
+                              const v_radius_t radius_sq,
+                              const struct vision *old_vision)
+{
+  if (!vision_can_overlap(vision, radius_sq, old_vision)) {
+    vision_change_sight(vision, radius_sq);
+    return FALSE;
+  }
+
+  map_vision_update_masked(vision->player, vision->tile, vision->radius_sq,
+                           radius_sq, vision->can_reveal_tiles,
+                           old_vision->tile, old_vision->radius_sq);
+  memcpy(vision->radius_sq, radius_sq, sizeof(v_radius_t));
+
+  return TRUE;
+}
+
+/**********************************************************************//**
+  Clear all sight points from 'old_vision', which has been replaced by a
+  vision source at 'new_tile' with 'new_radius_sq' using
+  vision_change_sight_from(). The tiles seen from there are not touched.
+**************************************************************************/
+void vision_clear_sight_to(struct vision *old_vision,
+                           struct tile *new_tile,
+                           const v_radius_t new_radius_sq)
+{
+  const v_radius_t vision_radius_sq = V_RADIUS(-1, -1, -1);
+
+  map_vision_update_masked(old_vision->player, old_vision->tile,
+                           old_vision->radius_sq, vision_radius_sq,
+                           old_vision->can_reveal_tiles,
+                           new_tile, new_radius_sq);
+  memcpy(old_vision->radius_sq, vision_radius_sq, sizeof(v_radius_t));
+}
+
 /**********************************************************************//**
   Create extra to tile.
 **************************************************************************/
@@ -33,14 +33,10 @@ struct player_tile {
   struct player *owner; 		/* NULL for unowned */
   struct player *extras_owner;
   bv_extras extras;
-
-  /* If you build a city with an unknown square within city radius
-     the square stays unknown. However, we still have to keep count
-     of the seen points, so they are kept in here. When the tile
-     then becomes known they are moved to seen. */
-  v_radius_t own_seen;
-  v_radius_t seen_count;
   short last_updated;
+
+  /* The seen counts are not stored here but in the tile_seen and
+   * tile_own_seen planes of the player, see player_map_init(). */
 };
 
 void global_warming(int effect);
@@ -130,6 +126,12 @@ void bounce_units_on_terrain_change(struct tile *ptile);
 void vision_change_sight(struct vision *vision,
                          const v_radius_t radius_sq);
 void vision_clear_sight(struct vision *vision);
+bool vision_change_sight_from(struct vision *vision,
+                              const v_radius_t radius_sq,
+                              const struct vision *old_vision);
+void vision_clear_sight_to(struct vision *old_vision,
+                           struct tile *new_tile,
+                           const v_radius_t new_radius_sq);
 
 void change_playertile_site(struct player_tile *ptile,
                             struct vision_site *new_site);
@@ -42,6 +42,9 @@
 #include "tech.h"
 #include "unitlist.h"
 
+/* common/aicore */
+#include "path_finding.h"
+
 /* common/scriptcore */
 #include "luascript_types.h"
 
@@ -767,6 +770,7 @@ void handle_diplomacy_cancel_pact(struct player *pplayer,
   /* do the change */
   ds_plrplr2->type = ds_plr2plr->type = new_type;
   ds_plrplr2->turns_left = ds_plr2plr->turns_left = 16;
+  pf_map_cache_invalidate();
 
   if (new_type == DS_WAR) {
     player_update_last_war_action(pplayer);
@@ -2074,6 +2078,7 @@ void make_contact(struct player *pplayer1, struct player *pplayer2,
 
     ds_plr1plr2->type = new_state;
     ds_plr2plr1->type = new_state;
+    pf_map_cache_invalidate();
     ds_plr1plr2->first_contact_turn = game.info.turn;
     ds_plr2plr1->first_contact_turn = game.info.turn;
     notify_player(pplayer1, ptile, E_FIRST_CONTACT, ftc_server,
@@ -8619,6 +8619,7 @@ static bool load_rulesetdir(const char *rsdir, bool compat_mode,
 
   if (ok) {
     rscompat_postprocess(&compat_info);
+    actions_utype_tables_build();
   }
 
   if (ok) {
@@ -117,21 +117,24 @@ static void check_fow(const char *file, const char *function, int line)
   }
 
   whole_map_iterate(&(wld.map), ptile) {
+    int tindex = tile_index(ptile);
+
     players_iterate(pplayer) {
-      struct player_tile *plr_tile = map_get_player_tile(ptile, pplayer);
+      short int **seen_count = pplayer->server.tile_seen;
+      short int **own_seen = pplayer->server.tile_own_seen;
 
       vision_layer_iterate(v) {
         /* underflow of unsigned int */
-        SANITY_TILE(ptile, plr_tile->seen_count[v] < 30000);
-        SANITY_TILE(ptile, plr_tile->own_seen[v] < 30000);
-        SANITY_TILE(ptile, plr_tile->own_seen[v] <= plr_tile->seen_count[v]);
+        SANITY_TILE(ptile, seen_count[v][tindex] < 30000);
+        SANITY_TILE(ptile, own_seen[v][tindex] < 30000);
+        SANITY_TILE(ptile, own_seen[v][tindex] <= seen_count[v][tindex]);
       } vision_layer_iterate_end;
 
       /* Lots of server bits depend on this. */
-      SANITY_TILE(ptile, plr_tile->seen_count[V_INVIS]
-		   <= plr_tile->seen_count[V_MAIN]);
-      SANITY_TILE(ptile, plr_tile->own_seen[V_INVIS]
-		   <= plr_tile->own_seen[V_MAIN]);
+      SANITY_TILE(ptile, seen_count[V_INVIS][tindex]
+		   <= seen_count[V_MAIN][tindex]);
+      SANITY_TILE(ptile, own_seen[V_INVIS][tindex]
+		   <= own_seen[V_MAIN][tindex]);
     } players_iterate_end;
   } whole_map_iterate_end;
 
@@ -534,6 +534,9 @@ static void savegame3_save_real(struct section_file *file,
   sg_save_ruledata(saving);
   /* [map] */
   sg_save_map(saving);
+  /* The sections above are complete, write them out if the file is
+   * streamed. */
+  secfile_stream_flush(saving->file);
   /* [player<i>] */
   sg_save_players(saving);
   /* [research] */
@@ -3819,6 +3822,7 @@ static void sg_save_players(struct savedata *saving)
     sg_save_player_units(saving, pplayer);
     sg_save_player_attributes(saving, pplayer);
     sg_save_player_vision(saving, pplayer);
+    secfile_stream_flush(saving->file);
   } players_iterate_end;
 }
 
@@ -15,10 +15,27 @@
 #include <fc_config.h>
 #endif
 
+#include <errno.h>
+#ifdef HAVE_SIGNAL_H
+#include <signal.h>
+#endif
+#include <stdlib.h>
+
+#ifdef FREECIV_HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+#ifdef FREECIV_HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
 /* utility */
 #include "log.h"
 #include "mem.h"
 #include "registry.h"
+#include "support.h"
 
 /* common */
 #include "ai.h"
@@ -35,8 +52,22 @@
 
 #include "savemain.h"
 
+#if defined(HAVE_WORKING_FORK) && defined(HAVE_SYS_WAIT_H) \
+  && !defined(FREECIV_MSWINDOWS)
+#define HAVE_USABLE_FORK
+#endif
+
 static fc_thread *save_thread = NULL;
 
+#ifdef HAVE_USABLE_FORK
+/* The process doing a background save, and the file it writes. */
+static pid_t save_pid = -1;
+static char save_pid_filepath[600];
+
+/* Seconds save_system_close() waits for the background save. */
+#define SAVE_FORKED_CLOSE_WAIT 30
+#endif /* HAVE_USABLE_FORK */
+
 /************************************************************************//**
   Main entry point for loading a game.
 ****************************************************************************/
@@ -105,17 +136,29 @@ struct save_thread_data
   char filepath[600];
   int save_compress_level;
   enum fz_method save_compress_type;
+  bool binary;
 };
 
 /************************************************************************//**
-  Run game saving thread.
+  Write the savegame file. Returns TRUE on success.
 ****************************************************************************/
-static void save_thread_run(void *arg)
+static bool save_thread_write(const struct save_thread_data *stdata)
 {
-  struct save_thread_data *stdata = (struct save_thread_data *)arg;
-  
-  if (!secfile_save(stdata->sfile, stdata->filepath, stdata->save_compress_level,
-                    stdata->save_compress_type)) {
+  if (stdata->binary) {
+    return secfile_save_binary(stdata->sfile, stdata->filepath);
+  } else {
+    return secfile_save(stdata->sfile, stdata->filepath,
+                        stdata->save_compress_level,
+                        stdata->save_compress_type);
+  }
+}
+
+/************************************************************************//**
+  Report the result of the save, and free its data.
+****************************************************************************/
+static void save_thread_done(struct save_thread_data *stdata, bool saved)
+{
+  if (!saved) {
     con_write(C_FAIL, _("Failed saving game as %s"), stdata->filepath);
     log_error("Game saving failed: %s", secfile_error());
     notify_conn(NULL, NULL, E_LOG_ERROR, ftc_warning, _("Failed saving game."));
@@ -124,15 +167,217 @@ static void save_thread_run(void *arg)
   }
 
   secfile_destroy(stdata->sfile);
-  free(arg);
+  free(stdata);
 }
 
 /************************************************************************//**
-  Unconditionally save the game, with specified filename.
-  Always prints a message: either save ok, or failed.
+  Run game saving thread.
 ****************************************************************************/
-void save_game(const char *orig_filename, const char *save_reason,
-               bool scenario)
+static void save_thread_run(void *arg)
+{
+  struct save_thread_data *stdata = (struct save_thread_data *)arg;
+
+  save_thread_done(stdata, save_thread_write(stdata));
+}
+
+/************************************************************************//**
+  Build the savegame and write it out at the same time, so that only the
+  part not yet written is kept in memory. Returns TRUE on success.
+****************************************************************************/
+static bool save_game_streamed(struct save_thread_data *stdata,
+                               const char *save_reason, bool scenario)
+{
+  bool saved;
+
+  stdata->sfile = secfile_new(TRUE);
+  if (stdata->binary) {
+    saved = secfile_stream_open_binary(stdata->sfile, stdata->filepath);
+  } else {
+    saved = secfile_stream_open(stdata->sfile, stdata->filepath,
+                                stdata->save_compress_level,
+                                stdata->save_compress_type);
+  }
+  if (saved) {
+    savegame_save(stdata->sfile, save_reason, scenario);
+    saved = secfile_stream_close(stdata->sfile);
+  }
+
+  return saved;
+}
+
+/************************************************************************//**
+  Build the savegame and write it, in the saving thread if there is one.
+****************************************************************************/
+static void save_game_write(struct save_thread_data *stdata,
+                            const char *save_reason, bool scenario)
+{
+  /* Without a thread to hand the complete savegame to, the savegame
+   * can be written while it is built. */
+  bool streamed = !game.server.threaded_save;
+
+  if (!streamed) {
+    /* Allowing duplicates shouldn't be allowed. However, it takes very too
+     * long time for huge game saving... */
+    stdata->sfile = secfile_new(TRUE);
+    savegame_save(stdata->sfile, save_reason, scenario);
+  }
+
+  if (save_thread != NULL) {
+    /* Previously started thread */
+    fc_thread_wait(save_thread);
+    if (!game.server.threaded_save) {
+      /* Setting has changed since the last save */
+      free(save_thread);
+      save_thread = NULL;
+    }
+  } else if (game.server.threaded_save) {
+    save_thread = fc_malloc(sizeof(save_thread));
+  }
+
+  if (save_thread != NULL) {
+    fc_thread_start(save_thread, &save_thread_run, stdata);
+  } else if (streamed) {
+    save_thread_done(stdata,
+                     save_game_streamed(stdata, save_reason, scenario));
+  } else {
+    save_thread_run(stdata);
+  }
+}
+
+#ifdef HAVE_USABLE_FORK
+/************************************************************************//**
+  Report the end of the background save, given its exit status.
+****************************************************************************/
+static void save_forked_done(int status)
+{
+  if (WIFEXITED(status) && EXIT_SUCCESS == WEXITSTATUS(status)) {
+    con_write(C_OK, _("Game saved as %s"), save_pid_filepath);
+  } else {
+    con_write(C_FAIL, _("Failed saving game as %s"), save_pid_filepath);
+    notify_conn(NULL, NULL, E_LOG_ERROR, ftc_warning, _("Failed saving game."));
+  }
+
+  save_pid = -1;
+}
+
+/************************************************************************//**
+  Report the result of the background save if it has finished. Returns
+  TRUE iff no background save is running anymore.
+****************************************************************************/
+static bool save_forked_reap(void)
+{
+  int status;
+  pid_t ret;
+
+  if (0 >= save_pid) {
+    return TRUE;
+  }
+
+  ret = waitpid(save_pid, &status, WNOHANG);
+  if (0 == ret || (0 > ret && EINTR == errno)) {
+    return FALSE;
+  }
+  if (0 > ret) {
+    log_error("Lost the background save process: %s",
+              fc_strerror(fc_get_errno()));
+    save_pid = -1;
+    return TRUE;
+  }
+
+  save_forked_done(status);
+  return TRUE;
+}
+
+/************************************************************************//**
+  Wait at most 'seconds' for the background save, if any, to finish.
+  Returns TRUE iff no background save is running anymore.
+****************************************************************************/
+static bool save_forked_wait(int seconds)
+{
+  int waited;
+
+  for (waited = 0; !save_forked_reap(); waited++) {
+    if (waited >= 10 * seconds) {
+      return FALSE;
+    }
+    fc_usleep(100000);
+  }
+
+  return TRUE;
+}
+
+/************************************************************************//**
+  Build and write the savegame in a forked copy of the server, which sees
+  the game as it is now while this process goes on. Returns FALSE if the
+  copy could not be made, in which case nothing has been done.
+****************************************************************************/
+static bool save_forked_start(struct save_thread_data *stdata,
+                              const char *save_reason)
+{
+  pid_t pid;
+
+  /* Only one background save at a time. Rather than waiting for the
+   * previous one, which may take long, save in this process. */
+  if (!save_forked_reap()) {
+    log_normal(_("The previous background save is still running, "
+                 "saving in the foreground."));
+    return FALSE;
+  }
+
+  /* The child only gets this thread. A lock held by the saving thread
+   * at fork time, e.g. in the log or in the allocator, would stay taken
+   * there forever. */
+  if (save_thread != NULL) {
+    fc_thread_wait(save_thread);
+    free(save_thread);
+    save_thread = NULL;
+  }
+
+  pid = fork();
+  if (0 > pid) {
+    log_error("Cannot save the game in the background: %s",
+              fc_strerror(fc_get_errno()));
+    return FALSE;
+  }
+
+  if (0 == pid) {
+    bool saved;
+
+    /* The copy must neither talk to the clients, nor react to the
+     * signals meant to save and stop the server. Other threads of the
+     * server, e.g. the metaserver one, may have held the log lock at
+     * fork time, so it doesn't log either; the exit status tells the
+     * result. */
+    log_set_callback(NULL);
+    log_set_level(LOG_FATAL);
+#ifdef HAVE_SIGNAL_H
+    signal(SIGINT, SIG_IGN);
+    signal(SIGTERM, SIG_DFL);
+#ifdef SIGHUP
+    signal(SIGHUP, SIG_DFL);
+#endif
+#endif /* HAVE_SIGNAL_H */
+
+    saved = save_game_streamed(stdata, save_reason, FALSE);
+
+    /* Skip the exit handlers and the buffers of the parent. */
+    _exit(saved ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  save_pid = pid;
+  sz_strlcpy(save_pid_filepath, stdata->filepath);
+  free(stdata);
+
+  return TRUE;
+}
+#endif /* HAVE_USABLE_FORK */
+
+/************************************************************************//**
+  Unconditionally save the game, with specified filename, in a forked
+  copy of the server if 'forked' is set and the system allows it.
+****************************************************************************/
+static void save_game_full(const char *orig_filename, const char *save_reason,
+                           bool scenario, bool forked)
 {
   char *dot, *filename;
   struct timer *timer_cpu, *timer_user;
@@ -142,6 +387,7 @@ void save_game(const char *orig_filename, const char *save_reason,
 
   stdata->save_compress_type = game.server.save_compress_type;
   stdata->save_compress_level = game.server.save_compress_level;
+  stdata->binary = game.server.binary_save;
 
   if (!orig_filename) {
     stdata->filepath[0] = '\0';
@@ -163,7 +409,7 @@ void save_game(const char *orig_filename, const char *save_reason,
       filename[0] = '\0';
     } else {
       char *end_dot;
-      char *strip_extensions[] = { ".sav", ".gz", ".bz2", ".xz", NULL };
+      char *strip_extensions[] = { ".sav", ".gz", ".bz2", ".xz", ".bin", NULL };
       bool stripped = TRUE;
 
       while ((end_dot = strrchr(dot, '.')) && stripped) {
@@ -193,20 +439,13 @@ void save_game(const char *orig_filename, const char *save_reason,
   timer_user = timer_new(TIMER_USER, TIMER_ACTIVE);
   timer_start(timer_user);
 
-  /* Allowing duplicates shouldn't be allowed. However, it takes very too
-   * long time for huge game saving... */
-  stdata->sfile = secfile_new(TRUE);
-  savegame_save(stdata->sfile, save_reason, scenario);
-
-  /* We have consistent game state in stdata->sfile now, so
-   * we could pass it to the saving thread already. We want to
-   * handle below notify_conn() and directory creation in
-   * main thread, though. */
-
   /* Append ".sav" to filename. */
   sz_strlcat(stdata->filepath, ".sav");
 
-  if (stdata->save_compress_level > 0) {
+  if (stdata->binary) {
+    /* Binary saves are never compressed, so that they can be mapped. */
+    sz_strlcat(stdata->filepath, ".bin");
+  } else if (stdata->save_compress_level > 0) {
     switch (stdata->save_compress_type) {
 #ifdef FREECIV_HAVE_LIBZ
     case FZ_ZLIB:
@@ -222,6 +461,7 @@ void save_game(const char *orig_filename, const char *save_reason,
 #endif
 #ifdef FREECIV_HAVE_LIBLZMA
    case FZ_XZ:
+   case FZ_XZ_MT:
       /* Append ".xz" to filename. */
       sz_strlcat(stdata->filepath, ".xz");
       break;
@@ -260,22 +500,13 @@ void save_game(const char *orig_filename, const char *save_reason,
     sz_strlcpy(stdata->filepath, tmpname);
   }
 
-  if (save_thread != NULL) {
-    /* Previously started thread */
-    fc_thread_wait(save_thread);
-    if (!game.server.threaded_save) {
-      /* Setting has changed since the last save */
-      free(save_thread);
-      save_thread = NULL;
-    }
-  } else if (game.server.threaded_save) {
-    save_thread = fc_malloc(sizeof(save_thread));
-  }
-
-  if (save_thread != NULL) {
-    fc_thread_start(save_thread, &save_thread_run, stdata);
-  } else {
-    save_thread_run(stdata);
+#ifdef HAVE_USABLE_FORK
+  if (forked && save_forked_start(stdata, save_reason)) {
+    /* The forked copy of the server does the rest. */
+  } else
+#endif /* HAVE_USABLE_FORK */
+  {
+    save_game_write(stdata, save_reason, scenario);
   }
 
 #ifdef LOG_TIMERS
@@ -287,11 +518,50 @@ void save_game(const char *orig_filename, const char *save_reason,
   timer_destroy(timer_user);
 }
 
+/************************************************************************//**
+  Unconditionally save the game, with specified filename.
+  Always prints a message: either save ok, or failed.
+****************************************************************************/
+void save_game(const char *orig_filename, const char *save_reason,
+               bool scenario)
+{
+  save_game_full(orig_filename, save_reason, scenario, FALSE);
+}
+
+/************************************************************************//**
+  Like save_game(), but build and write the savegame in the background
+  where the system allows it, without stopping the game meanwhile. The
+  message about the result is printed by save_system_poll() later.
+****************************************************************************/
+void save_game_background(const char *orig_filename, const char *save_reason)
+{
+  save_game_full(orig_filename, save_reason, FALSE, TRUE);
+}
+
+/************************************************************************//**
+  Report the result of the background save if it has finished.
+****************************************************************************/
+void save_system_poll(void)
+{
+#ifdef HAVE_USABLE_FORK
+  save_forked_reap();
+#endif /* HAVE_USABLE_FORK */
+}
+
 /************************************************************************//**
   Close saving system.
 ****************************************************************************/
 void save_system_close(void)
 {
+#ifdef HAVE_USABLE_FORK
+  if (!save_forked_wait(SAVE_FORKED_CLOSE_WAIT)) {
+    /* It goes on without us; only its result is lost. */
+    log_error("Not waiting any longer for the background save as %s.",
+              save_pid_filepath);
+    save_pid = -1;
+  }
+#endif /* HAVE_USABLE_FORK */
+
   if (save_thread != NULL) {
     fc_thread_wait(save_thread);
     free(save_thread);
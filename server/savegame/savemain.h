@@ -24,7 +24,9 @@ void savegame_save(struct section_file *sfile, const char *save_reason,
 
 void save_game(const char *orig_filename, const char *save_reason,
                bool scenario);
+void save_game_background(const char *orig_filename, const char *save_reason);
 
+void save_system_poll(void);
 void save_system_close(void);
 
 #endif /* FC__SAVEMAIN_H */
@@ -45,6 +45,9 @@
 #include <readline/history.h>
 #include <readline/readline.h>
 #endif
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
 #ifdef HAVE_SYS_SELECT_H
 #include <sys/select.h>
 #endif
@@ -75,6 +78,9 @@
 #include "game.h"
 #include "packets.h"
 
+/* server/savegame */
+#include "savemain.h"
+
 /* server/scripting */
 #include "script_server.h"
 
@@ -134,6 +140,43 @@ static void send_lanserver_response(void);
 
 static bool no_input = FALSE;
 
+/* What server_sniff_all_input() found out about a socket. */
+struct sniff_state {
+  bool readable;        /* There may be input to read. */
+  bool writable;        /* Output wouldn't block. */
+  bool excepting;       /* Exceptional condition (out-of-band data). */
+  bool want_write;      /* Watched for output (epoll only). */
+};
+
+static struct sniff_state sniff_conns[MAX_NUM_CONNECTIONS];
+static struct sniff_state *sniff_listens = NULL;
+static struct sniff_state sniff_stdin;
+
+#if defined(HAVE_SYS_EPOLL_H) && !defined(FREECIV_SOCKET_ZERO_NOT_STDIN)
+#define SNIFF_EPOLL
+#endif
+
+#ifdef SNIFF_EPOLL
+/* With epoll, the connections are registered once and watched
+ * edge-triggered for input, so they are read until they would block.
+ * They are watched for output only while they have data waiting to be
+ * sent. -1 when select() is used instead. */
+static int sniff_epoll = -1;
+
+/* Whether stdin is watched, and whether it is a file epoll can't watch,
+ * that is always readable. */
+static bool sniff_stdin_watched = FALSE;
+static bool sniff_stdin_always = FALSE;
+
+/* epoll_event.data.u32 of stdin and of the listening sockets. Those of
+ * the connections are their index in connections[]. */
+#define SNIFF_ID_STDIN MAX_NUM_CONNECTIONS
+#define SNIFF_ID_LISTEN (MAX_NUM_CONNECTIONS + 1)
+
+/* Maximum number of events handled by one epoll_wait() call. */
+#define SNIFF_MAX_EVENTS 64
+#endif /* SNIFF_EPOLL */
+
 /* Avoid compiler warning about defined, but unused function
  * by defining it only when needed */
 #if defined(FREECIV_HAVE_LIBREADLINE) || \
@@ -220,6 +263,11 @@ static void close_connection(struct connection *pconn)
   pconn->playing = NULL;
   pconn->client_gui = GUI_STUB;
   pconn->access_level = ALLOW_NONE;
+#ifdef SNIFF_EPOLL
+  if (0 <= sniff_epoll && pconn->used) {
+    epoll_ctl(sniff_epoll, EPOLL_CTL_DEL, pconn->sock, NULL);
+  }
+#endif /* SNIFF_EPOLL */
   connection_common_close(pconn);
 
   send_updated_vote_totals(NULL);
@@ -247,10 +295,18 @@ void close_connections_and_socket(void)
   conn_list_destroy(game.all_connections);
   conn_list_destroy(game.est_connections);
 
+#ifdef SNIFF_EPOLL
+  if (0 <= sniff_epoll) {
+    close(sniff_epoll);
+    sniff_epoll = -1;
+  }
+#endif /* SNIFF_EPOLL */
+
   for (i = 0; i < listen_count; i++) {
     fc_closesocket(listen_socks[i]);
   }
   FC_FREE(listen_socks);
+  FC_FREE(sniff_listens);
 
   if (srvarg.announce != ANNOUNCE_NONE) {
     fc_closesocket(socklan);
@@ -482,6 +538,245 @@ static void incoming_client_packets(struct connection *pconn)
 #endif /* PROCESSING_TIME_STATISTICS */
 }
 
+/*************************************************************************//**
+  Wait up to 'tv' for stdin, the listening sockets and the connections
+  with select(), and update their sniff_state. Returns the value of
+  select().
+*****************************************************************************/
+static int sniff_select(fc_timeval *tv)
+{
+  fd_set readfs, writefs, exceptfs;
+  int i, max_desc, ret;
+
+  FC_FD_ZERO(&readfs);
+  FC_FD_ZERO(&writefs);
+  FC_FD_ZERO(&exceptfs);
+
+  if (!no_input) {
+#ifdef FREECIV_SOCKET_ZERO_NOT_STDIN
+    fc_init_console();
+#else /* FREECIV_SOCKET_ZERO_NOT_STDIN */
+#   if !defined(__VMS)
+    FD_SET(0, &readfs);
+#   endif /* VMS */
+#endif /* FREECIV_SOCKET_ZERO_NOT_STDIN */
+  }
+
+  max_desc = 0;
+  for (i = 0; i < listen_count; i++) {
+    FD_SET(listen_socks[i], &readfs);
+    FD_SET(listen_socks[i], &exceptfs);
+    max_desc = MAX(max_desc, listen_socks[i]);
+  }
+
+  for (i = 0; i < MAX_NUM_CONNECTIONS; i++) {
+    struct connection *pconn = connections + i;
+
+    if (pconn->used && !pconn->server.is_closing) {
+      FD_SET(pconn->sock, &readfs);
+      if (0 < pconn->send_buffer->ndata) {
+        FD_SET(pconn->sock, &writefs);
+      }
+      FD_SET(pconn->sock, &exceptfs);
+      max_desc = MAX(pconn->sock, max_desc);
+    }
+  }
+  con_prompt_off();		/* output doesn't generate a new prompt */
+
+  ret = fc_select(max_desc + 1, &readfs, &writefs, &exceptfs, tv);
+
+#ifndef FREECIV_SOCKET_ZERO_NOT_STDIN
+  sniff_stdin.readable = FD_ISSET(0, &readfs);
+#endif
+  for (i = 0; i < listen_count; i++) {
+    sniff_listens[i].readable = FD_ISSET(listen_socks[i], &readfs);
+    sniff_listens[i].excepting = FD_ISSET(listen_socks[i], &exceptfs);
+  }
+  for (i = 0; i < MAX_NUM_CONNECTIONS; i++) {
+    struct connection *pconn = connections + i;
+
+    if (pconn->used && !pconn->server.is_closing) {
+      sniff_conns[i].readable = FD_ISSET(pconn->sock, &readfs);
+      sniff_conns[i].writable = FD_ISSET(pconn->sock, &writefs);
+      sniff_conns[i].excepting = FD_ISSET(pconn->sock, &exceptfs);
+    }
+  }
+
+  return ret;
+}
+
+#ifdef SNIFF_EPOLL
+/*************************************************************************//**
+  Start watching the listening sockets with epoll. Falls back to
+  select() on failure.
+*****************************************************************************/
+static void sniff_epoll_init(void)
+{
+  struct epoll_event ev;
+  int i;
+
+  sniff_epoll = epoll_create1(EPOLL_CLOEXEC);
+  if (0 > sniff_epoll) {
+    log_error("epoll_create1() failed, using select(): %s",
+              fc_strerror(fc_get_errno()));
+    return;
+  }
+
+  for (i = 0; i < listen_count; i++) {
+    ev.events = EPOLLIN | EPOLLPRI;
+    ev.data.u32 = SNIFF_ID_LISTEN + i;
+    if (0 != epoll_ctl(sniff_epoll, EPOLL_CTL_ADD, listen_socks[i], &ev)) {
+      log_error("epoll_ctl() failed, using select(): %s",
+                fc_strerror(fc_get_errno()));
+      close(sniff_epoll);
+      sniff_epoll = -1;
+      return;
+    }
+  }
+
+  sniff_stdin_watched = FALSE;
+  sniff_stdin_always = FALSE;
+}
+
+/*************************************************************************//**
+  Watch stdin while input is expected from it.
+*****************************************************************************/
+static void sniff_epoll_watch_stdin(void)
+{
+  struct epoll_event ev;
+
+  if (!no_input && !sniff_stdin_watched) {
+    ev.events = EPOLLIN;
+    ev.data.u32 = SNIFF_ID_STDIN;
+    if (0 == epoll_ctl(sniff_epoll, EPOLL_CTL_ADD, 0, &ev)) {
+      sniff_stdin_always = FALSE;
+    } else if (EPERM == fc_get_errno()) {
+      /* A regular file, never blocks. */
+      sniff_stdin_always = TRUE;
+    } else {
+      log_error("epoll_ctl() failed for stdin: %s",
+                fc_strerror(fc_get_errno()));
+      return;
+    }
+    sniff_stdin_watched = TRUE;
+  } else if (no_input && sniff_stdin_watched) {
+    if (!sniff_stdin_always) {
+      epoll_ctl(sniff_epoll, EPOLL_CTL_DEL, 0, NULL);
+    }
+    sniff_stdin_watched = FALSE;
+  }
+}
+
+/*************************************************************************//**
+  Wait up to 'tv' for stdin, the listening sockets and the connections
+  with epoll, and update their sniff_state. Returns the number of ready
+  sockets, 0 on timeout and -1 on error, like select().
+*****************************************************************************/
+static int sniff_epoll_wait(fc_timeval *tv)
+{
+  struct epoll_event events[SNIFF_MAX_EVENTS];
+  int timeout = tv->tv_sec * 1000 + tv->tv_usec / 1000;
+  int i, num_events, ready = 0;
+
+  sniff_epoll_watch_stdin();
+  sniff_stdin.readable = sniff_stdin_watched && sniff_stdin_always;
+  if (sniff_stdin.readable) {
+    ready++;
+  }
+
+  for (i = 0; i < listen_count; i++) {
+    sniff_listens[i].readable = FALSE;
+    sniff_listens[i].excepting = FALSE;
+  }
+
+  for (i = 0; i < MAX_NUM_CONNECTIONS; i++) {
+    struct connection *pconn = connections + i;
+    struct sniff_state *state = sniff_conns + i;
+    bool want_write;
+
+    state->excepting = FALSE;
+    if (!pconn->used || pconn->server.is_closing) {
+      continue;
+    }
+
+    /* Only watch for output while there is something to send. Changing
+     * the events reports the current state again. */
+    want_write = (0 < pconn->send_buffer->ndata);
+    if (want_write != state->want_write) {
+      struct epoll_event ev;
+
+      ev.events = EPOLLIN | EPOLLPRI | EPOLLET | (want_write ? EPOLLOUT : 0);
+      ev.data.u32 = i;
+      if (0 == epoll_ctl(sniff_epoll, EPOLL_CTL_MOD, pconn->sock, &ev)) {
+        state->want_write = want_write;
+        state->writable = FALSE;
+      } else {
+        log_error("epoll_ctl() failed for connection (%s): %s",
+                  conn_description(pconn), fc_strerror(fc_get_errno()));
+      }
+    }
+
+    if (state->readable || (state->want_write && state->writable)) {
+      ready++;
+    }
+  }
+
+  if (0 < ready) {
+    /* Handle what is known to be ready first. */
+    timeout = 0;
+  }
+
+  con_prompt_off();		/* output doesn't generate a new prompt */
+
+  num_events = epoll_wait(sniff_epoll, events, ARRAY_SIZE(events), timeout);
+  if (0 > num_events) {
+    return (0 < ready ? ready : -1);
+  }
+
+  for (i = 0; i < num_events; i++) {
+    const struct epoll_event *ev = events + i;
+    struct sniff_state *state;
+
+    if (SNIFF_ID_STDIN > ev->data.u32) {
+      state = sniff_conns + ev->data.u32;
+    } else if (SNIFF_ID_STDIN == ev->data.u32) {
+      state = &sniff_stdin;
+    } else {
+      state = sniff_listens + (ev->data.u32 - SNIFF_ID_LISTEN);
+    }
+
+    if (ev->events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+      /* Errors and hangups are found out by reading. */
+      state->readable = TRUE;
+    }
+    if (ev->events & EPOLLOUT) {
+      state->writable = TRUE;
+    }
+    if (ev->events & EPOLLPRI) {
+      state->excepting = TRUE;
+    }
+  }
+
+  return ready + num_events;
+}
+#endif /* SNIFF_EPOLL */
+
+/*************************************************************************//**
+  Wait up to 'tv' for stdin, the listening sockets and the connections,
+  and update their sniff_state. Returns the number of ready sockets,
+  0 on timeout and -1 on error.
+*****************************************************************************/
+static int sniff_wait(fc_timeval *tv)
+{
+#ifdef SNIFF_EPOLL
+  if (0 <= sniff_epoll) {
+    return sniff_epoll_wait(tv);
+  }
+#endif /* SNIFF_EPOLL */
+
+  return sniff_select(tv);
+}
+
 /*************************************************************************//**
   Get and handle:
   - new connections,
@@ -494,9 +789,7 @@ static void incoming_client_packets(struct connection *pconn)
 enum server_events server_sniff_all_input(void)
 {
   int i, s;
-  int max_desc;
   bool excepting;
-  fd_set readfs, writefs, exceptfs;
   fc_timeval tv;
 #ifdef FREECIV_SOCKET_ZERO_NOT_STDIN
   char *bufptr;
@@ -553,6 +846,9 @@ enum server_events server_sniff_all_input(void)
 
     get_lanserver_announcement();
 
+    /* Report the autosave made in the background, if it is done. */
+    save_system_poll();
+
     /* end server if no players for 'srvarg.quitidle' seconds,
      * but only if at least one player has previously connected. */
     if (srvarg.quitidle != 0) {
@@ -659,42 +955,7 @@ enum server_events server_sniff_all_input(void)
     tv.tv_sec = 1;
     tv.tv_usec = 0;
 
-    FC_FD_ZERO(&readfs);
-    FC_FD_ZERO(&writefs);
-    FC_FD_ZERO(&exceptfs);
-
-    if (!no_input) {
-#ifdef FREECIV_SOCKET_ZERO_NOT_STDIN
-      fc_init_console();
-#else /* FREECIV_SOCKET_ZERO_NOT_STDIN */
-#   if !defined(__VMS)
-      FD_SET(0, &readfs);
-#   endif /* VMS */
-#endif /* FREECIV_SOCKET_ZERO_NOT_STDIN */
-    }
-
-    max_desc = 0;
-    for (i = 0; i < listen_count; i++) {
-      FD_SET(listen_socks[i], &readfs);
-      FD_SET(listen_socks[i], &exceptfs);
-      max_desc = MAX(max_desc, listen_socks[i]);
-    }
-
-    for (i = 0; i < MAX_NUM_CONNECTIONS; i++) {
-      struct connection *pconn = connections + i;
-
-      if (pconn->used && !pconn->server.is_closing) {
-        FD_SET(pconn->sock, &readfs);
-        if (0 < pconn->send_buffer->ndata) {
-          FD_SET(pconn->sock, &writefs);
-        }
-        FD_SET(pconn->sock, &exceptfs);
-        max_desc = MAX(pconn->sock, max_desc);
-      }
-    }
-    con_prompt_off();		/* output doesn't generate a new prompt */
-
-    if (fc_select(max_desc + 1, &readfs, &writefs, &exceptfs, &tv) == 0) {
+    if (sniff_wait(&tv) == 0) {
       /* timeout */
       call_ai_refresh();
       script_server_signal_emit("pulse");
@@ -736,7 +997,7 @@ enum server_events server_sniff_all_input(void)
 	    lib$stop(status);
 	  }
 	  if (ttchar.numchars) {
-	    FD_SET(0, &readfs);
+	    sniff_stdin.readable = TRUE;
 	  } else {
 	    continue;
 	  }
@@ -752,7 +1013,7 @@ enum server_events server_sniff_all_input(void)
 
     excepting = FALSE;
     for (i = 0; i < listen_count; i++) {
-      if (FD_ISSET(listen_socks[i], &exceptfs)) {
+      if (sniff_listens[i].excepting) {
         excepting = TRUE;
         break;
       }
@@ -762,7 +1023,7 @@ enum server_events server_sniff_all_input(void)
     }
     for (i = 0; i < listen_count; i++) {
       s = listen_socks[i];
-      if (FD_ISSET(s, &readfs)) {     /* new players connects */
+      if (sniff_listens[i].readable) {  /* new players connects */
         log_verbose("got new connection");
         if (-1 == server_accept_connection(s)) {
           /* There will be a log_error() message from
@@ -779,7 +1040,7 @@ enum server_events server_sniff_all_input(void)
 
       if (pconn->used
           && !pconn->server.is_closing
-          && FD_ISSET(pconn->sock, &exceptfs)) {
+          && sniff_conns[i].excepting) {
         log_verbose("connection (%s) cut due to exception data",
                     conn_description(pconn));
         connection_close_server(pconn, _("network exception"));
@@ -794,7 +1055,7 @@ enum server_events server_sniff_all_input(void)
       free(bufptr_internal);
     }
 #else  /* !FREECIV_SOCKET_ZERO_NOT_STDIN */
-    if (!no_input && FD_ISSET(0, &readfs)) {    /* input from server operator */
+    if (!no_input && sniff_stdin.readable) {    /* input from server operator */
 #ifdef FREECIV_HAVE_LIBREADLINE
       rl_callback_read_char();
       if (readline_handled_input) {
@@ -850,11 +1111,15 @@ enum server_events server_sniff_all_input(void)
 
         if (!pconn->used
             || pconn->server.is_closing
-            || !FD_ISSET(pconn->sock, &readfs)) {
+            || !sniff_conns[i].readable) {
           continue;
         }
 
         nb = read_socket_data(pconn->sock, pconn->buffer);
+        if (0 == nb) {
+          /* Read all there was. */
+          sniff_conns[i].readable = FALSE;
+        }
         if (0 <= nb) {
           /* We read packets; now handle them. */
           incoming_client_packets(pconn);
@@ -873,8 +1138,12 @@ enum server_events server_sniff_all_input(void)
             && !pconn->server.is_closing
             && pconn->send_buffer
             && pconn->send_buffer->ndata > 0) {
-          if (FD_ISSET(pconn->sock, &writefs)) {
+          if (sniff_conns[i].writable) {
             flush_connection_send_buffer_all(pconn);
+            if (pconn->send_buffer && 0 < pconn->send_buffer->ndata) {
+              /* Would block. */
+              sniff_conns[i].writable = FALSE;
+            }
           } else {
             cut_lagging_connection(pconn);
           }
@@ -1042,6 +1311,21 @@ int server_make_connection(int new_sock, const char *client_addr,
     struct connection *pconn = &connections[i];
 
     if (!pconn->used) {
+#ifdef SNIFF_EPOLL
+      if (0 <= sniff_epoll) {
+        struct epoll_event ev;
+
+        ev.events = EPOLLIN | EPOLLPRI | EPOLLET;
+        ev.data.u32 = i;
+        if (0 != epoll_ctl(sniff_epoll, EPOLL_CTL_ADD, new_sock, &ev)) {
+          log_error("epoll_ctl() failed for new connection: %s",
+                    fc_strerror(fc_get_errno()));
+          fc_closesocket(new_sock);
+          return -1;
+        }
+      }
+#endif /* SNIFF_EPOLL */
+      memset(sniff_conns + i, 0, sizeof(sniff_conns[i]));
       connection_common_init(pconn);
       pconn->sock = new_sock;
       pconn->observer = FALSE;
@@ -1226,6 +1510,11 @@ int server_open_socket(void)
 
   connections_set_close_callback(server_conn_close_callback);
 
+  sniff_listens = fc_calloc(listen_count, sizeof(*sniff_listens));
+#ifdef SNIFF_EPOLL
+  sniff_epoll_init();
+#endif /* SNIFF_EPOLL */
+
   if (srvarg.announce == ANNOUNCE_NONE) {
     return 0;
   }
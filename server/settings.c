@@ -27,6 +27,7 @@
 
 /* common */
 #include "map.h"
+#include "packets.h"
 
 /* server */
 #include "gamehand.h"
@@ -557,6 +558,7 @@ compresstype_name(enum fz_method compresstype)
 #endif
 #ifdef FREECIV_HAVE_LIBLZMA
   NAME_CASE(FZ_XZ, "XZ", N_("Using xz"));
+  NAME_CASE(FZ_XZ_MT, "XZ_MT", N_("Using xz, multi-threaded"));
 #endif
   }
   return NULL;
@@ -791,6 +793,14 @@ static void metamessage_action(const struct setting *pset)
   }
 }
 
+/************************************************************************//**
+  Apply the new memory limit of the delta protocol caches.
+****************************************************************************/
+static void deltacachesize_action(const struct setting *pset)
+{
+  delta_cache_set_limit((size_t) *pset->integer.pvalue * 1024);
+}
+
 /****************************************************************************
   Validation callback functions.
 ****************************************************************************/
@@ -2961,6 +2971,30 @@ static struct setting settings[] = {
               "users are not required to wait for the save to finish."),
            NULL, NULL, GAME_DEFAULT_THREADED_SAVE)
 
+  GEN_BOOL("binary_save", game.server.binary_save,
+           SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+           N_("Whether to save games in binary format"),
+           /* TRANS: The strings between single quotes are setting names
+            * and should not be translated. */
+           N_("If this is turned on, games are saved in an uncompressed "
+              "binary format which is much faster to write and to load "
+              "than the text format, but takes more disk space. The "
+              "'compress' and 'compresstype' settings do not apply to "
+              "such saves. Both formats are recognized when loading, so "
+              "a game can be converted by loading it and saving it again "
+              "with this setting changed."),
+           NULL, NULL, GAME_DEFAULT_BINARY_SAVE)
+
+  GEN_BOOL("forked_autosave", game.server.forked_autosave,
+           SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+           N_("Whether to make autosaves in a separate process"),
+           N_("If this is turned on, the turn and timer autosaves are "
+              "built and written by a copy of the server process, so "
+              "the game goes on without waiting for them. The result is "
+              "reported on the console once the save is done. This is "
+              "ignored on systems where the server cannot copy itself."),
+           NULL, NULL, GAME_DEFAULT_FORKED_AUTOSAVE)
+
   GEN_INT("compress", game.server.save_compress_level,
           SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
           N_("Savegame compression level"),
@@ -3034,6 +3068,32 @@ static struct setting settings[] = {
              scorefile_validate, NULL, GAME_DEFAULT_SCOREFILE)
 #endif /* !FREECIV_WEB */
 
+  GEN_INT("aithreads", game.server.ai_threads,
+          SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+          N_("Number of threads planning the AI players' phase"),
+          N_("If non-zero, the planning of all AI players is done at the "
+             "beginning of the phase, before any of them moves, using up "
+             "to this number of threads. Only the parts not changing the "
+             "game state, like the assessment of the dangers to the "
+             "cities, are done this way. If zero, every AI player plans "
+             "just before moving its units.\n"
+             "So the AI players don't play the same with 0 as with any "
+             "other value, even 1: when planning up front, they don't "
+             "take into account what the AI players moving before them "
+             "did in the same phase. All non-zero values give the same "
+             "game."), NULL, NULL, NULL,
+          GAME_MIN_AI_THREADS, GAME_MAX_AI_THREADS, GAME_DEFAULT_AI_THREADS)
+
+  GEN_INT("cmthreads", game.server.cm_threads,
+          SSET_META, SSET_INTERNAL, SSET_RARE, ALLOW_HACK, ALLOW_HACK,
+          N_("Number of threads arranging city workers"),
+          N_("If non-zero, when many cities of a player need their "
+             "workers arranged at once, like after a change of "
+             "government, the citizen governor works on them using up "
+             "to this number of threads. If zero, the cities are "
+             "arranged one after the other."), NULL, NULL, NULL,
+          GAME_MIN_CM_THREADS, GAME_MAX_CM_THREADS, GAME_DEFAULT_CM_THREADS)
+
   GEN_INT("maxconnectionsperhost", game.server.maxconnectionsperhost,
           SSET_RULES_FLEXIBLE, SSET_NETWORK, SSET_RARE,
           ALLOW_NONE, ALLOW_BASIC,
@@ -3046,6 +3106,23 @@ static struct setting settings[] = {
           GAME_MIN_MAXCONNECTIONSPERHOST, GAME_MAX_MAXCONNECTIONSPERHOST,
           GAME_DEFAULT_MAXCONNECTIONSPERHOST)
 
+  GEN_INT("deltacachesize", game.server.delta_cache_size,
+          SSET_META, SSET_NETWORK, SSET_RARE,
+          ALLOW_HACK, ALLOW_HACK,
+          N_("Memory for the delta protocol of each connection (KiB)"),
+          /* TRANS: the string in double quotes is a server command and
+           * should not be translated */
+          N_("The server keeps a copy of the last packets sent to a "
+             "connection, like the information about every tile, to only "
+             "send what changed the next time. This limits the memory "
+             "used by these copies: above it, the least recently used "
+             "ones are dropped, and packets of their kind are then sent "
+             "in full. A value of 0 means that there is no limit. The "
+             "memory used can be seen with the \"list delta caches\" "
+             "command."), NULL, NULL, deltacachesize_action,
+          GAME_MIN_DELTA_CACHE_SIZE, GAME_MAX_DELTA_CACHE_SIZE,
+          GAME_DEFAULT_DELTA_CACHE_SIZE)
+
   GEN_INT("kicktime", game.server.kick_time,
           SSET_RULES_FLEXIBLE, SSET_NETWORK, SSET_RARE,
           ALLOW_HACK, ALLOW_HACK,
@@ -42,6 +42,7 @@
 
 static struct timer *aitimer[AIT_LAST][2];
 static int recursion[AIT_LAST];
+static bool timing_paused = FALSE;
 
 /* General AI logging functions */
 
@@ -129,6 +130,10 @@ void timing_log_real(enum ai_timer timer, enum ai_timer_activity activity)
 {
   static int turn = -1;
 
+  if (timing_paused) {
+    return;
+  }
+
   if (game.info.turn != turn) {
     int i;
 
@@ -150,6 +155,15 @@ void timing_log_real(enum ai_timer timer, enum ai_timer_activity activity)
   }
 }
 
+/**********************************************************************//**
+  Pause or resume the timers. They are not thread safe, so they must be
+  paused while AI code runs in several threads.
+**************************************************************************/
+void timing_log_pause(bool pause)
+{
+  timing_paused = pause;
+}
+
 /**********************************************************************//**
   Print results
 **************************************************************************/
@@ -209,6 +223,7 @@ void timing_results_real(void)
   AILOG_OUT(" - Settler want", AIT_CITY_SETTLERS);
   AILOG_OUT("Citizen arrange", AIT_CITIZEN_ARRANGE);
   AILOG_OUT("Tech", AIT_TECH);
+  AILOG_OUT("Unit moves", AIT_UNIT_MOVE);
 }
 
 /**********************************************************************//**
@@ -69,6 +69,7 @@ enum ai_timer {
   AIT_BODYGUARD,
   AIT_FERRY,
   AIT_RAMPAGE,
+  AIT_UNIT_MOVE,
   AIT_LAST
 };
 
@@ -116,6 +117,7 @@ void timing_log_init(void);
 void timing_log_free(void);
 
 void timing_log_real(enum ai_timer timer, enum ai_timer_activity activity);
+void timing_log_pause(bool pause);
 void timing_results_real(void);
 
 #ifdef FREECIV_DEBUG
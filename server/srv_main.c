@@ -50,6 +50,7 @@
 #include "fc_cmdline.h"
 #include "fciconv.h"
 #include "fcintl.h"
+#include "fcthread.h"
 #include "log.h"
 #include "mem.h"
 #include "netintf.h"
@@ -60,6 +61,7 @@
 
 /* common/aicore */
 #include "citymap.h"
+#include "path_finding.h"
 
 /* common */
 #include "achievements.h"
@@ -1053,11 +1055,96 @@ static void kill_dying_players(void)
   }
 }
 
+/* The AI players left to plan, shared by the planning threads. */
+struct ai_plan_queue {
+  fc_mutex mutex;
+  struct player *players[MAX_NUM_PLAYER_SLOTS];
+  int num_players;
+  int next;
+};
+
+/**********************************************************************//**
+  Planning thread: plan the phase of AI players from the queue until it
+  is empty.
+**************************************************************************/
+static void ai_plan_thread(void *arg)
+{
+  struct ai_plan_queue *queue = (struct ai_plan_queue *) arg;
+  struct player *pplayer;
+
+  do {
+    fc_allocate_mutex(&queue->mutex);
+    if (queue->next < queue->num_players) {
+      pplayer = queue->players[queue->next++];
+    } else {
+      pplayer = NULL;
+    }
+    fc_release_mutex(&queue->mutex);
+
+    if (NULL != pplayer) {
+      CALL_PLR_AI_FUNC(first_activities_plan, pplayer, pplayer);
+    }
+  } while (NULL != pplayer);
+}
+
+/**********************************************************************//**
+  Plan the phase of all AI players at once, using up to 'aithreads'
+  threads. As the planning doesn't change the game state, the result
+  doesn't depend on the number of threads nor on the order of players.
+**************************************************************************/
+static void ai_plan_phase(void)
+{
+  struct ai_plan_queue queue;
+  fc_thread threads[GAME_MAX_AI_THREADS];
+  int num_threads, i;
+
+  queue.num_players = 0;
+  queue.next = 0;
+  phase_players_iterate(pplayer) {
+    if (is_ai(pplayer) && NULL != pplayer->ai->funcs.first_activities_plan) {
+      queue.players[queue.num_players++] = pplayer;
+    }
+  } phase_players_iterate_end;
+
+  if (0 == queue.num_players) {
+    return;
+  }
+
+  TIMING_LOG(AIT_DANGER, TIMER_START);
+  timing_log_pause(TRUE);
+  /* The threads may only read the effect value cache. */
+  effect_cache_freeze(TRUE);
+  fc_init_mutex(&queue.mutex);
+
+  /* The main thread plans too. */
+  num_threads = MIN(game.server.ai_threads, queue.num_players) - 1;
+  for (i = 0; i < num_threads; i++) {
+    if (0 != fc_thread_start(&threads[i], ai_plan_thread, &queue)) {
+      log_error("Failed to start AI planning thread.");
+      num_threads = i;
+      break;
+    }
+  }
+  ai_plan_thread(&queue);
+  for (i = 0; i < num_threads; i++) {
+    fc_thread_wait(&threads[i]);
+  }
+
+  fc_destroy_mutex(&queue.mutex);
+  effect_cache_freeze(FALSE);
+  timing_log_pause(FALSE);
+  TIMING_LOG(AIT_DANGER, TIMER_STOP);
+}
+
 /**********************************************************************//**
   Called at the start of each (new) phase to do AI activities.
 **************************************************************************/
 static void ai_start_phase(void)
 {
+  if (0 < game.server.ai_threads) {
+    ai_plan_phase();
+  }
+
   phase_players_iterate(pplayer) {
     if (is_ai(pplayer)) {
       CALL_PLR_AI_FUNC(first_activities, pplayer, pplayer);
@@ -1178,6 +1265,9 @@ static void begin_phase(bool is_new_phase)
 {
   log_debug("Begin phase");
 
+  /* Paths found during the previous phase are obsolete. */
+  pf_map_cache_invalidate();
+
   conn_list_do_buffer(game.est_connections);
 
   phase_players_iterate(pplayer) {
@@ -1321,6 +1411,9 @@ static void end_phase(void)
 {
   log_debug("Endphase");
 
+  /* Turn change processing doesn't follow the paths of this phase. */
+  pf_map_cache_invalidate();
+
   /* 
    * This empties the client Messages window; put this before
    * everything else below, since otherwise any messages from the
@@ -1706,7 +1799,13 @@ void save_game_auto(const char *save_reason, enum autosave_type type)
   } else {
     fc_snprintf(filename, sizeof(filename), "%s-timer", game.server.save_name);
   }
-  save_game(filename, save_reason, FALSE);
+  if (game.server.forked_autosave
+      && (AS_TURN == type || AS_TIMER == type)) {
+    /* The game goes on after these, no need to wait for them. */
+    save_game_background(filename, save_reason);
+  } else {
+    save_game(filename, save_reason, FALSE);
+  }
 }
 
 /**********************************************************************//**
@@ -2012,10 +2111,12 @@ bool server_packet_input(struct connection *pconn, void *packet, int type)
       return TRUE;
     }
 
+    city_info_coalesce_begin();
     if (!server_handle_packet(type, packet, NULL, pconn)) {
       log_error("Received unknown packet %d from %s.",
                 type, conn_description(pconn));
     }
+    city_info_coalesce_end();
     return TRUE;
   }
 
@@ -2059,6 +2160,9 @@ bool server_packet_input(struct connection *pconn, void *packet, int type)
   /* Make sure to set this back to NULL before leaving this function: */
   pplayer->current_conn = pconn;
 
+  /* Send the info of the cities the packet changed once, after it is
+   * fully handled. */
+  city_info_coalesce_begin();
   if (!server_handle_packet(type, packet, pplayer, pconn)) {
     log_error("Received unknown packet %d from %s.",
               type, conn_description(pconn));
@@ -2072,6 +2176,7 @@ bool server_packet_input(struct connection *pconn, void *packet, int type)
      * game state (now S_S_GENERATING_WAITING). */
     kill_dying_players();
   }
+  city_info_coalesce_end();
 
   pplayer->current_conn = NULL;
   return TRUE;
@@ -2750,7 +2855,9 @@ static void srv_running(void)
      * We have to initialize data as well as do some actions.  However when
      * loading a game we don't want to do these actions (like AI unit
      * movement and AI diplomacy). */
+    city_info_coalesce_begin();
     begin_turn(is_new_turn);
+    city_info_coalesce_end();
 
     if (game.server.num_phases != 1) {
       /* We allow everyone to begin adjusting cities and such
@@ -2763,7 +2870,9 @@ static void srv_running(void)
     for (; game.info.phase < game.server.num_phases; game.info.phase++) {
       log_debug("Starting phase %d/%d.", game.info.phase,
                 game.server.num_phases);
+      city_info_coalesce_begin();
       begin_phase(is_new_turn);
+      city_info_coalesce_end();
       if (need_send_pending_events) {
         /* When loading a savegame, we need to send loaded events, after
          * the clients switched to the game page (after the first
@@ -2846,7 +2955,9 @@ static void srv_running(void)
        */
       lsend_packet_freeze_client(game.est_connections);
 
+      city_info_coalesce_begin();
       end_phase();
+      city_info_coalesce_end();
 
       conn_list_do_unbuffer(game.est_connections);
 
@@ -2855,7 +2966,9 @@ static void srv_running(void)
       }
       game.server.additional_phase_seconds = 0;
     }
+    city_info_coalesce_begin();
     end_turn();
+    city_info_coalesce_end();
     log_debug("Sendinfotometaserver");
     (void) send_server_info_to_metaserver(META_REFRESH);
 
@@ -3327,8 +3440,14 @@ void server_game_init(bool keep_ruleset_value)
 **************************************************************************/
 void server_game_free(void)
 {
+  unsigned int hits, misses;
+
   CALL_FUNC_EACH_AI(game_free);
 
+  effect_cache_stats(&hits, &misses);
+  log_verbose("Effect value cache: %u hits, %u misses.", hits, misses);
+  city_info_coalesce_stats_log();
+
   /* Free all the treaties that were left open when game finished. */
   free_treaties();
 
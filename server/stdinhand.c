@@ -3692,7 +3692,8 @@ bool load_command(struct connection *caller, const char *filename, bool check,
       get_save_dirs(), get_scenario_dirs(), NULL
     };
     const char *exts[] = {
-      "sav", "gz", "bz2", "xz", "sav.gz", "sav.bz2", "sav.xz", NULL
+      "sav", "gz", "bz2", "xz", "sav.gz", "sav.bz2", "sav.xz", "sav.bin",
+      NULL
     };
     const char **ext, *found = NULL;
     const struct strvec **path;
@@ -6522,6 +6523,45 @@ static void show_connections(struct connection *caller)
   cmd_reply(CMD_LIST, caller, C_COMMENT, horiz_line);
 }
 
+/**********************************************************************//**
+  Show the memory used by the copies of the packets the delta protocol
+  keeps for every connection.
+**************************************************************************/
+static void show_delta_caches(struct connection *caller)
+{
+  size_t total_size = 0;
+  int total_entries = 0;
+
+  cmd_reply(CMD_LIST, caller, C_COMMENT,
+            _("Delta protocol caches of the connections:"));
+  cmd_reply(CMD_LIST, caller, C_COMMENT, horiz_line);
+
+  conn_list_iterate(game.all_connections, pconn) {
+    size_t size;
+    int entries, evictions;
+
+    delta_cache_stats(pconn, &entries, &size, &evictions);
+    cmd_reply(CMD_LIST, caller, C_COMMENT,
+              _("%s: %d packets, %lu KiB, %d dropped"),
+              conn_description(pconn), entries,
+              (unsigned long) (size / 1024), evictions);
+    total_size += size;
+    total_entries += entries;
+  } conn_list_iterate_end;
+
+  cmd_reply(CMD_LIST, caller, C_COMMENT,
+            _("Total: %d packets, %lu KiB"), total_entries,
+            (unsigned long) (total_size / 1024));
+  if (0 < game.server.delta_cache_size) {
+    cmd_reply(CMD_LIST, caller, C_COMMENT,
+              _("Limit: %d KiB per connection"),
+              game.server.delta_cache_size);
+  } else {
+    cmd_reply(CMD_LIST, caller, C_COMMENT, _("Limit: none"));
+  }
+  cmd_reply(CMD_LIST, caller, C_COMMENT, horiz_line);
+}
+
 /**********************************************************************//**
   List all delegations of the current game.
 **************************************************************************/
@@ -6864,6 +6904,8 @@ static void show_colors(struct connection *caller)
 #define SPECENUM_VALUE9NAME  "teams"
 #define SPECENUM_VALUE10     LIST_VOTES
 #define SPECENUM_VALUE10NAME "votes"
+#define SPECENUM_VALUE11     LIST_DELTA_CACHES
+#define SPECENUM_VALUE11NAME "delta caches"
 #include "specenum_gen.h"
 
 /**********************************************************************//**
@@ -6933,6 +6975,9 @@ static bool show_list(struct connection *caller, char *arg)
   case LIST_VOTES:
     show_votes(caller);
     return TRUE;
+  case LIST_DELTA_CACHES:
+    show_delta_caches(caller);
+    return TRUE;
   }
 
   cmd_reply(CMD_LIST, caller, C_FAIL,
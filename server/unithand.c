@@ -1805,6 +1805,11 @@ void handle_unit_get_actions(struct connection *pc,
     return;
   }
 
+  /* The same actions are evaluated against the same targets while the
+   * targets are selected, while the probabilities are calculated and
+   * while explaining why no action is possible. */
+  action_cache_scope_begin();
+
   /* Select the targets. */
 
   if (target_unit_id_client == IDENTITY_NUMBER_ZERO) {
@@ -1828,6 +1833,7 @@ void handle_unit_get_actions(struct connection *pc,
                               target_tile_id, target_extra_id,
                               disturb_player,
                               probabilities);
+    action_cache_scope_end();
     return;
   }
 
@@ -2001,6 +2007,8 @@ void handle_unit_get_actions(struct connection *pc,
     explain_why_no_action_enabled(actor_unit,
                                   target_tile, target_city, target_unit);
   }
+
+  action_cache_scope_end();
 }
 
 /**********************************************************************//**
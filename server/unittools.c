@@ -29,6 +29,7 @@
 #include "support.h"
 
 /* common */
+#include "actions.h"
 #include "base.h"
 #include "city.h"
 #include "combat.h"
@@ -70,6 +71,7 @@
 #include "plrhand.h"
 #include "sanitycheck.h"
 #include "sernet.h"
+#include "srv_log.h"
 #include "srv_main.h"
 #include "techtools.h"
 #include "unithand.h"
@@ -95,6 +97,10 @@ struct unit_move_data {
   bv_player can_see_unit;
   bv_player can_see_move;
   struct vision *old_vision;
+  /* Where and how far the unit started to see when it moved, if the
+   * tiles also seen by 'old_vision' were skipped. */
+  struct tile *new_tile;
+  v_radius_t new_radius_sq;
 };
 
 #define SPECLIST_TAG unit_move_data
@@ -137,6 +143,10 @@ static bool try_to_save_unit(struct unit *punit, const struct unit_type *pttype,
                              bool helpless, bool teleporting,
                              const struct city *pexclcity);
 static void wakeup_neighbor_sentries(struct unit *punit);
+static bool unit_move_real(struct unit *punit, struct tile *pdesttile,
+                           int move_cost, struct unit *embark_to,
+                           bool find_embark_target,
+                           bool conquer_city_allowed);
 static void do_upgrade_effects(struct player *pplayer);
 
 static bool maybe_cancel_patrol_due_to_enemy(struct unit *punit);
@@ -1663,6 +1673,8 @@ struct unit *create_unit_full(struct player *pplayer, struct tile *ptile,
 
   unit_list_prepend(pplayer->units, punit);
   unit_list_prepend(ptile->units, punit);
+  pf_map_cache_invalidate_tile(ptile, NULL);
+  action_cache_invalidate();
   if (pcity && !utype_has_flag(type, UTYF_NOHOME)) {
     fc_assert(city_owner(pcity) == pplayer);
     unit_list_prepend(pcity->units_supported, punit);
@@ -3175,26 +3187,43 @@ static bool unit_survive_autoattack(struct unit *punit)
   adjc_iterate(&(wld.map), unit_tile(punit), ptile) {
     /* First add all eligible units to a autoattack list */
     unit_list_iterate(ptile->units, penemy) {
-      struct autoattack_prob *probability = fc_malloc(sizeof(*probability));
+      struct autoattack_prob *probability;
       struct tile *tgt_tile = unit_tile(punit);
+      struct act_prob prob;
 
       fc_assert_action(tgt_tile, continue);
 
-      probability->prob =
-          action_auto_perf_unit_prob(AAPC_UNIT_MOVED_ADJ,
-                                     penemy, unit_owner(punit), NULL,
-                                     tgt_tile, tile_city(tgt_tile),
-                                     punit, NULL);
+      if (!utype_may_auto_perform(unit_type_get(penemy),
+                                  AAPC_UNIT_MOVED_ADJ)) {
+        /* Fast path: the ruleset never forces units of this type to act
+         * when a unit moves next to them. */
+        continue;
+      }
 
-      if (action_prob_possible(probability->prob)) {
+      prob = action_auto_perf_unit_prob(AAPC_UNIT_MOVED_ADJ,
+                                        penemy, unit_owner(punit), NULL,
+                                        tgt_tile, tile_city(tgt_tile),
+                                        punit, NULL);
+
+      if (action_prob_possible(prob)) {
+        probability = fc_malloc(sizeof(*probability));
+        probability->prob = prob;
         probability->unit_id = penemy->id;
         autoattack_prob_list_prepend(autoattack, probability);
-      } else {
-        FC_FREE(probability);
       }
     } unit_list_iterate_end;
   } adjc_iterate_end;
 
+  if (autoattack_prob_list_size(autoattack) == 0) {
+    /* Fast path: nobody around can attack. The "unit_moved" script
+     * signal may have changed the unit, so it is still sent. */
+    autoattack_prob_list_destroy(autoattack);
+    punit->moves_left = moves;
+    send_unit_info(NULL, punit);
+
+    return TRUE;
+  }
+
   /* Sort the potential attackers from highest to lowest success
    * probability. */
   if (autoattack_prob_list_size(autoattack) >= 2) {
@@ -3322,12 +3351,19 @@ static void wakeup_neighbor_sentries(struct unit *punit)
      wake them up if the punit is farther away than 3. */
   square_iterate(&(wld.map), unit_tile(punit), 3, ptile) {
     unit_list_iterate(ptile->units, penemy) {
-      int distance_sq = sq_map_distance(unit_tile(punit), ptile);
-      int radius_sq = get_unit_vision_at(penemy, unit_tile(penemy), V_MAIN);
+      int distance_sq, radius_sq;
+
+      /* Fast path: most units around are not enemy sentries, don't
+       * evaluate their vision range. */
+      if (penemy->activity != ACTIVITY_SENTRY
+          || pplayers_allied(unit_owner(punit), unit_owner(penemy))) {
+        continue;
+      }
+
+      distance_sq = sq_map_distance(unit_tile(punit), ptile);
+      radius_sq = get_unit_vision_at(penemy, unit_tile(penemy), V_MAIN);
 
-      if (!pplayers_allied(unit_owner(punit), unit_owner(penemy))
-          && penemy->activity == ACTIVITY_SENTRY
-          && radius_sq >= distance_sq
+      if (radius_sq >= distance_sq
           /* If the unit moved on a city, and the unit is alone, consider
            * it is visible. */
           && (alone_in_city
@@ -3566,6 +3602,9 @@ static struct unit_move_data *unit_move_data(struct unit *punit,
   /* Set new tile. */
   unit_tile_set(punit, pdesttile);
   unit_list_prepend(pdesttile->units, punit);
+  pf_map_cache_invalidate_tile(psrctile, NULL);
+  pf_map_cache_invalidate_tile(pdesttile, NULL);
+  action_cache_invalidate();
 
   if (unit_transported(punit)) {
     /* Silently free orders since they won't be applicable anymore. */
@@ -3586,7 +3625,12 @@ static struct unit_move_data *unit_move_data(struct unit *punit,
   /* Enhance vision if unit steps into a fortress */
   new_vision = vision_new(powner, pdesttile);
   punit->server.vision = new_vision;
-  vision_change_sight(new_vision, radius_sq);
+  if (vision_change_sight_from(new_vision, radius_sq, pdata->old_vision)) {
+    pdata->new_tile = pdesttile;
+    memcpy(pdata->new_radius_sq, radius_sq, sizeof(v_radius_t));
+  } else {
+    pdata->new_tile = NULL;
+  }
   ASSERT_VISION(new_vision);
 
   return pdata;
@@ -3627,6 +3671,26 @@ static void unit_move_data_unref(struct unit_move_data *pdata)
 bool unit_move(struct unit *punit, struct tile *pdesttile, int move_cost,
                struct unit *embark_to, bool find_embark_target,
                bool conquer_city_allowed)
+{
+  bool unit_lives;
+
+  /* Unit moves are the most frequent server operation when executing
+   * orders; measure them with "debug timing". */
+  TIMING_LOG(AIT_UNIT_MOVE, TIMER_START);
+  unit_lives = unit_move_real(punit, pdesttile, move_cost, embark_to,
+                              find_embark_target, conquer_city_allowed);
+  TIMING_LOG(AIT_UNIT_MOVE, TIMER_STOP);
+
+  return unit_lives;
+}
+
+/**********************************************************************//**
+  Does the real work of unit_move().
+**************************************************************************/
+static bool unit_move_real(struct unit *punit, struct tile *pdesttile,
+                           int move_cost, struct unit *embark_to,
+                           bool find_embark_target,
+                           bool conquer_city_allowed)
 {
   struct player *pplayer;
   struct tile *psrctile;
@@ -3851,7 +3915,12 @@ bool unit_move(struct unit *punit, struct tile *pdesttile, int move_cost,
 
   /* Clear old vision. */
   unit_move_data_list_iterate(plist, pmove_data) {
-    vision_clear_sight(pmove_data->old_vision);
+    if (NULL != pmove_data->new_tile) {
+      vision_clear_sight_to(pmove_data->old_vision, pmove_data->new_tile,
+                            pmove_data->new_radius_sq);
+    } else {
+      vision_clear_sight(pmove_data->old_vision);
+    }
     vision_free(pmove_data->old_vision);
     pmove_data->old_vision = NULL;
   } unit_move_data_list_iterate_end;
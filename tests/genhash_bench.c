@@ -0,0 +1,221 @@
+/***********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+
+/****************************************************************************
+  Measures the throughput of the genhash tables, in ns per operation, on
+  the kinds of keys Freeciv uses:
+  - int: sequential ids, as in the city and unit indices.
+  - pointer: addresses of allocated objects.
+  - string: secfile entry paths, as in the entry hash of a savegame.
+
+  For each kind and table size, it times inserts into a table that grows
+  from its default size, lookups of present and missing keys, removals,
+  and inserts into a table created for the final number of entries. Each
+  figure is the best of several trials, to leave out disturbances.
+
+  Build it with "make genhash_bench" in the tests directory. It is not
+  built by default.
+****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <fc_config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* utility */
+#include "genhash.h"
+#include "mem.h"
+#include "shared.h"
+#include "support.h"
+#include "timing.h"
+
+#define BENCH_TRIALS 7
+#define BENCH_OPS 500000        /* Per trial and measure. */
+
+enum bench_measure {
+  BM_INSERT,
+  BM_HIT,
+  BM_MISS,
+  BM_REMOVE,
+  BM_PRESIZED,
+  BM_COUNT
+};
+
+/* Keeps the lookups from being optimized away. */
+static volatile int bench_found = 0;
+
+/************************************************************************//**
+  Stop the timer and return the seconds since it was started. Then start
+  it again.
+****************************************************************************/
+static double bench_lap(struct timer *timer)
+{
+  double seconds;
+
+  timer_stop(timer);
+  seconds = timer_read_seconds(timer);
+  timer_clear(timer);
+  timer_start(timer);
+
+  return seconds;
+}
+
+/************************************************************************//**
+  Time the genhash operations on the keys, which are all different from
+  the missing keys. Each trial fills several tables, so that each timed
+  loop is long enough for the timer resolution.
+****************************************************************************/
+static void bench_keys(const char *kind, void **keys, void **missing,
+                       int num, genhash_val_fn_t val_func,
+                       genhash_comp_fn_t comp_func)
+{
+  struct timer *timer = timer_new(TIMER_USER, TIMER_ACTIVE);
+  int reps = MAX(1, BENCH_OPS / num);
+  struct genhash **tables = fc_malloc(reps * sizeof(*tables));
+  double best[BM_COUNT];
+  int trial, rep, i, m;
+
+  for (m = 0; m < BM_COUNT; m++) {
+    best[m] = -1.0;
+  }
+
+  for (trial = 0; trial < BENCH_TRIALS; trial++) {
+    double spent[BM_COUNT];
+    void *data;
+
+    for (rep = 0; rep < reps; rep++) {
+      tables[rep] = genhash_new(val_func, comp_func);
+    }
+
+    timer_clear(timer);
+    timer_start(timer);
+    for (rep = 0; rep < reps; rep++) {
+      for (i = 0; i < num; i++) {
+        genhash_insert(tables[rep], keys[i], keys[i]);
+      }
+    }
+    spent[BM_INSERT] = bench_lap(timer);
+
+    for (rep = 0; rep < reps; rep++) {
+      for (i = 0; i < num; i++) {
+        bench_found += genhash_lookup(tables[rep], keys[i], &data);
+      }
+    }
+    spent[BM_HIT] = bench_lap(timer);
+
+    for (rep = 0; rep < reps; rep++) {
+      for (i = 0; i < num; i++) {
+        bench_found += genhash_lookup(tables[rep], missing[i], &data);
+      }
+    }
+    spent[BM_MISS] = bench_lap(timer);
+
+    for (rep = 0; rep < reps; rep++) {
+      for (i = 0; i < num; i++) {
+        genhash_remove(tables[rep], keys[i]);
+      }
+    }
+    spent[BM_REMOVE] = bench_lap(timer);
+
+    for (rep = 0; rep < reps; rep++) {
+      genhash_destroy(tables[rep]);
+      tables[rep] = genhash_new_nentries(val_func, comp_func, num);
+    }
+
+    (void) bench_lap(timer);
+    for (rep = 0; rep < reps; rep++) {
+      for (i = 0; i < num; i++) {
+        genhash_insert(tables[rep], keys[i], keys[i]);
+      }
+    }
+    spent[BM_PRESIZED] = bench_lap(timer);
+    timer_stop(timer);
+
+    for (rep = 0; rep < reps; rep++) {
+      genhash_destroy(tables[rep]);
+    }
+
+    for (m = 0; m < BM_COUNT; m++) {
+      if (0.0 > best[m] || spent[m] < best[m]) {
+        best[m] = spent[m];
+      }
+    }
+  }
+
+  free(tables);
+  timer_destroy(timer);
+
+  for (m = 0; m < BM_COUNT; m++) {
+    best[m] *= 1e9 / ((double) num * reps);
+  }
+  printf("%-8s %7d %8.1f %8.1f %8.1f %8.1f %8.1f\n", kind, num,
+         best[BM_INSERT], best[BM_HIT], best[BM_MISS], best[BM_REMOVE],
+         best[BM_PRESIZED]);
+}
+
+/************************************************************************//**
+  Entry point of the benchmark.
+****************************************************************************/
+int main(int argc, char **argv)
+{
+  const int sizes[] = { 1000, 100000 };
+  size_t s;
+
+  printf("%-8s %7s %8s %8s %8s %8s %8s\n", "keys", "entries",
+         "insert", "hit", "miss", "remove", "presized");
+
+  for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+    int num = sizes[s], i;
+    void **keys = fc_malloc(num * sizeof(*keys));
+    void **missing = fc_malloc(num * sizeof(*missing));
+
+    for (i = 0; i < num; i++) {
+      keys[i] = FC_INT_TO_PTR(101 + i);
+      missing[i] = FC_INT_TO_PTR(101 + num + i);
+    }
+    bench_keys("int", keys, missing, num, NULL, NULL);
+
+    for (i = 0; i < num; i++) {
+      keys[i] = fc_malloc(48);
+      missing[i] = fc_malloc(48);
+    }
+    bench_keys("pointer", keys, missing, num, NULL, NULL);
+    for (i = 0; i < num; i++) {
+      free(keys[i]);
+      free(missing[i]);
+    }
+
+    for (i = 0; i < num; i++) {
+      char buf[64];
+
+      fc_snprintf(buf, sizeof(buf), "player%d.u%d.activity", i % 8, i);
+      keys[i] = fc_strdup(buf);
+      fc_snprintf(buf, sizeof(buf), "player%d.c%d.name", i % 8, i);
+      missing[i] = fc_strdup(buf);
+    }
+    bench_keys("string", keys, missing, num,
+               (genhash_val_fn_t) genhash_str_val_func,
+               (genhash_comp_fn_t) genhash_str_comp_func);
+    for (i = 0; i < num; i++) {
+      free(keys[i]);
+      free(missing[i]);
+    }
+
+    free(keys);
+    free(missing);
+  }
+
+  return EXIT_SUCCESS;
+}
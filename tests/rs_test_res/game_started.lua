@@ -0,0 +1,15 @@
+-- game_started.lua
+-- Makes Freeciv exit with error if no started game is loaded, as is the
+-- case when loading a savegame has failed. Exits normally if one is.
+-- Example of what can be done in an unsafe Freeciv Lua environment.
+--     /lua unsafe-file tests/rs_test_res/game_started.lua
+
+turn = game.current_turn()
+
+if (turn > 0) then
+  log.normal("Game loaded at turn %d.", turn)
+  os.exit(true)
+else
+  log.fatal("No started game loaded.")
+  os.exit(false)
+end
@@ -0,0 +1,64 @@
+-- unit_moves.lua
+-- Replays scripted unit moves on the loaded game and logs what a move
+-- cost on average. Each unit steps to the first adjacent tile that it can
+-- exist at and that holds no unit or city, then back to where it was.
+-- This is repeated UNIT_MOVES_ROUNDS times (100 if not set). Makes
+-- Freeciv exit with error if no unit could be moved.
+-- Example of what can be done in an unsafe Freeciv Lua environment.
+--     /lua unsafe-file tests/rs_test_res/unit_moves.lua
+
+rounds = tonumber(os.getenv("UNIT_MOVES_ROUNDS") or "100")
+steps = {}
+
+-- Script the moves before making any of them, so that the same game
+-- always gives the same moves.
+for pplayer in players_iterate() do
+  for punit in pplayer:units_iterate() do
+    local home = punit.tile
+
+    if punit:transporter() == nil then
+      for ptile in home:square_iterate(1) do
+        if ptile.id ~= home.id
+           and ptile:num_units() == 0
+           and ptile:city() == nil
+           and punit.utype:can_exist_at_tile(ptile) then
+          steps[#steps + 1] = { owner = pplayer, id = punit.id,
+                                there = ptile, back = home }
+          break
+        end
+      end
+    end
+  end
+end
+
+if (#steps == 0) then
+  log.fatal("No unit of the game can be moved.")
+  os.exit(false)
+end
+
+moves = 0
+start = os.clock()
+
+for round = 1, rounds do
+  for _, step in ipairs(steps) do
+    local punit = find.unit(step.owner, step.id)
+
+    if punit ~= nil and punit.tile.id == step.back.id
+       and step.there:num_units() == 0 then
+      punit:move(step.there, 0)
+      moves = moves + 1
+
+      punit = find.unit(step.owner, step.id)
+      if punit ~= nil then
+        punit:move(step.back, 0)
+        moves = moves + 1
+      end
+    end
+  end
+end
+
+seconds = os.clock() - start
+
+log.normal("%d unit moves in %.3f seconds, %.1f microseconds per move.",
+           moves, seconds, seconds * 1000000 / math.max(moves, 1))
+os.exit(true)
@@ -73,6 +73,22 @@ void fc_thread_wait(fc_thread *thread)
   thrd_join(*thread, return_value);
 }
 
+/*******************************************************************//**
+  Return the id of the calling thread
+***********************************************************************/
+fc_thread_id fc_thread_self(void)
+{
+  return thrd_current();
+}
+
+/*******************************************************************//**
+  Return whether both ids are of the same thread
+***********************************************************************/
+bool fc_thread_id_equal(fc_thread_id id1, fc_thread_id id2)
+{
+  return 0 != thrd_equal(id1, id2);
+}
+
 /*******************************************************************//**
   Initialize mutex
 ***********************************************************************/
@@ -196,6 +212,22 @@ void fc_thread_wait(fc_thread *thread)
   pthread_join(*thread, return_value);
 }
 
+/*******************************************************************//**
+  Return the id of the calling thread
+***********************************************************************/
+fc_thread_id fc_thread_self(void)
+{
+  return pthread_self();
+}
+
+/*******************************************************************//**
+  Return whether both ids are of the same thread
+***********************************************************************/
+bool fc_thread_id_equal(fc_thread_id id1, fc_thread_id id2)
+{
+  return 0 != pthread_equal(id1, id2);
+}
+
 /*******************************************************************//**
   Initialize mutex
 ***********************************************************************/
@@ -326,6 +358,22 @@ void fc_thread_wait(fc_thread *thread)
   CloseHandle(*thread);
 }
 
+/*******************************************************************//**
+  Return the id of the calling thread
+***********************************************************************/
+fc_thread_id fc_thread_self(void)
+{
+  return GetCurrentThreadId();
+}
+
+/*******************************************************************//**
+  Return whether both ids are of the same thread
+***********************************************************************/
+bool fc_thread_id_equal(fc_thread_id id1, fc_thread_id id2)
+{
+  return id1 == id2;
+}
+
 /*******************************************************************//**
   Initialize mutex
 ***********************************************************************/
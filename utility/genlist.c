@@ -25,6 +25,9 @@
 
 #include "genlist.h"
 
+/* Maximum number of unused links kept by a list for later insertions. */
+#define GENLIST_SPARE_LINKS 16
+
 /************************************************************************//**
   Create a new empty genlist.
 ****************************************************************************/
@@ -42,10 +45,12 @@ struct genlist *genlist_new_full(genlist_free_fn_t free_data_func)
 
 #ifdef ZERO_VARIABLES_FOR_SEARCHING
   pgenlist->nelements = 0;
+  pgenlist->nspare = 0;
   pgenlist->head_link = NULL;
   pgenlist->tail_link = NULL;
+  pgenlist->spare = NULL;
+  pgenlist->mutex = NULL;
 #endif /* ZERO_VARIABLES_FOR_SEARCHING */
-  fc_init_mutex(&pgenlist->mutex);
   pgenlist->free_data_func = free_data_func;
 
   return pgenlist;
@@ -61,10 +66,35 @@ void genlist_destroy(struct genlist *pgenlist)
   }
 
   genlist_clear(pgenlist);
-  fc_destroy_mutex(&pgenlist->mutex);
+  while (NULL != pgenlist->spare) {
+    struct genlist_link *plink = pgenlist->spare;
+
+    pgenlist->spare = plink->next;
+    free(plink);
+  }
+  if (NULL != pgenlist->mutex) {
+    fc_destroy_mutex(pgenlist->mutex);
+    free(pgenlist->mutex);
+  }
   free(pgenlist);
 }
 
+/************************************************************************//**
+  Release the memory of a link no longer in the list, or keep it for
+  reuse.
+****************************************************************************/
+static inline void genlist_link_free(struct genlist *pgenlist,
+                                     struct genlist_link *plink)
+{
+  if (GENLIST_SPARE_LINKS > pgenlist->nspare) {
+    plink->next = pgenlist->spare;
+    pgenlist->spare = plink;
+    pgenlist->nspare++;
+  } else {
+    free(plink);
+  }
+}
+
 /************************************************************************//**
   Create a new link.
 ****************************************************************************/
@@ -72,7 +102,15 @@ static void genlist_link_new(struct genlist *pgenlist, void *dataptr,
                              struct genlist_link *prev,
                              struct genlist_link *next)
 {
-  struct genlist_link *plink = fc_malloc(sizeof(*plink));
+  struct genlist_link *plink;
+
+  if (NULL != pgenlist->spare) {
+    plink = pgenlist->spare;
+    pgenlist->spare = plink->next;
+    pgenlist->nspare--;
+  } else {
+    plink = fc_malloc(sizeof(*plink));
+  }
 
   plink->dataptr = dataptr;
   plink->prev = prev;
@@ -115,7 +153,7 @@ static void genlist_link_destroy(struct genlist *pgenlist,
   if (NULL != pgenlist->free_data_func) {
     pgenlist->free_data_func(plink->dataptr);
   }
-  free(plink);
+  genlist_link_free(pgenlist, plink);
 }
 
 /************************************************************************//**
@@ -264,12 +302,12 @@ void genlist_clear(struct genlist *pgenlist)
       do {
         plink2 = plink->next;
         free_data_func(plink->dataptr);
-        free(plink);
+        genlist_link_free(pgenlist, plink);
       } while (NULL != (plink = plink2));
     } else {
       do {
         plink2 = plink->next;
-        free(plink);
+        genlist_link_free(pgenlist, plink);
       } while (NULL != (plink = plink2));
     }
   }
@@ -677,12 +715,26 @@ void genlist_reverse(struct genlist *pgenlist)
   }
 }
 
+/************************************************************************//**
+  Give a mutex to the list, so it can be shared between threads. Must be
+  called before the list is used by several threads.
+****************************************************************************/
+void genlist_init_mutex(struct genlist *pgenlist)
+{
+  fc_assert_ret(NULL == pgenlist->mutex);
+
+  pgenlist->mutex = fc_malloc(sizeof(*pgenlist->mutex));
+  fc_init_mutex(pgenlist->mutex);
+}
+
 /************************************************************************//**
   Allocates list mutex
 ****************************************************************************/
 void genlist_allocate_mutex(struct genlist *pgenlist)
 {
-  fc_allocate_mutex(&pgenlist->mutex);
+  fc_assert_ret(NULL != pgenlist->mutex);
+
+  fc_allocate_mutex(pgenlist->mutex);
 }
 
 /************************************************************************//**
@@ -690,5 +742,7 @@ void genlist_allocate_mutex(struct genlist *pgenlist)
 ****************************************************************************/
 void genlist_release_mutex(struct genlist *pgenlist)
 {
-  fc_release_mutex(&pgenlist->mutex);
+  fc_assert_ret(NULL != pgenlist->mutex);
+
+  fc_release_mutex(pgenlist->mutex);
 }
@@ -37,6 +37,15 @@ extern "C" {
   iterator is active, in particular removing the next element pointed
   to by the iterator (see further comments below).
 
+  Lists are meant to be used by one thread at a time. Only the lists
+  for which genlist_init_mutex() was called (see SPECLIST_MUTEX in
+  speclist.h) carry a mutex to be shared between threads. The links of
+  the removed elements are kept for reuse by the same list, up to
+  GENLIST_SPARE_LINKS, so a list which is emptied and filled again
+  doesn't allocate memory each time. The spare links are not shared
+  between lists: a unit moving to another tile still gets a new link in
+  the unit list of that tile, and leaves a spare one in the old list.
+
   See also the speclist module.
 ****************************************************************************/
 
@@ -58,9 +67,11 @@ typedef bool (*genlist_comp_fn_t) (const void *, const void *);
  * of the list. */
 struct genlist {
   int nelements;
-  fc_mutex mutex;
+  int nspare;                           /* Number of links in 'spare'. */
   struct genlist_link *head_link;
   struct genlist_link *tail_link;
+  struct genlist_link *spare;           /* Unused links, chained by 'next'. */
+  fc_mutex *mutex;                      /* NULL if not shared by threads. */
   genlist_free_fn_t free_data_func;
 };
   
@@ -121,6 +132,7 @@ void genlist_sort(struct genlist *pgenlist,
 void genlist_shuffle(struct genlist *pgenlist);
 void genlist_reverse(struct genlist *pgenlist);
 
+void genlist_init_mutex(struct genlist *pgenlist);
 void genlist_allocate_mutex(struct genlist *pgenlist);
 void genlist_release_mutex(struct genlist *pgenlist);
 
@@ -26,6 +26,11 @@
   The data pointed to should not be modified.  The retuned pointer
   is valid _only_ until another inputfile is performed.  (So should
   be used immediately, or fc_strdup-ed etc.)
+
+  Uncompressed files are read in one go and split into lines in place.
+  Most tokens are not copied either: they are terminated in the current
+  line, and the character replaced by the terminator is put back when
+  the next token is read.
   
   The tokens recognised are as follows:
   (Single quotes are delimiters used here, but are not part of the
@@ -70,6 +75,7 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/stat.h>
 
 /* utility */
 #include "astring.h"
@@ -90,12 +96,22 @@
 struct inputfile {
   unsigned int magic;		/* memory check */
   char *filename;		/* filename as passed to fopen */
-  fz_FILE *fp;			/* read from this */
+  fz_FILE *fp;			/* read from this, if not from mem */
+  char *mem;                    /* whole contents of uncompressed file */
+  size_t mem_size;
+  size_t mem_pos;               /* start of the next line in mem */
   bool at_eof;			/* flag for end-of-file */
-  struct astring cur_line;	/* data from current line */
+  struct astring line_buf;      /* storage for lines read from fp */
+  char *cur_line;		/* data from current line, in line_buf
+                                   or in mem; NULL if none */
+  size_t cur_line_len;
   unsigned int cur_line_pos;    /* position in current line */
   unsigned int line_num;        /* line number from file in cur_line */
-  struct astring token;		/* data returned to user */
+  char *token_end;              /* where the last token returned without
+                                   copying was terminated, or NULL */
+  char token_end_char;          /* character replaced at token_end */
+  struct astring token;		/* data returned to user, when it could
+                                   not be returned from cur_line */
   struct astring partial;	/* used in accumulating multi-line strings;
 				   used only in get_token_value, but put
 				   here so it gets freed when file closed */
@@ -166,12 +182,18 @@ static void init_zeros(struct inputfile *inf)
   inf->magic = INF_MAGIC;
   inf->filename = NULL;
   inf->fp = NULL;
+  inf->mem = NULL;
+  inf->mem_size = inf->mem_pos = 0;
   inf->datafn = NULL;
   inf->included_from = NULL;
+  inf->cur_line = NULL;
+  inf->cur_line_len = 0;
   inf->line_num = inf->cur_line_pos = 0;
+  inf->token_end = NULL;
+  inf->token_end_char = '\0';
   inf->at_eof = inf->in_string = FALSE;
   inf->string_start_line = 0;
-  astr_init(&inf->cur_line);
+  astr_init(&inf->line_buf);
   astr_init(&inf->token);
   astr_init(&inf->partial);
 }
@@ -183,7 +205,7 @@ static bool inf_sanity_check(struct inputfile *inf)
 {
   fc_assert_ret_val(NULL != inf, FALSE);
   fc_assert_ret_val(INF_MAGIC == inf->magic, FALSE);
-  fc_assert_ret_val(NULL != inf->fp, FALSE);
+  fc_assert_ret_val(NULL != inf->fp || NULL != inf->mem, FALSE);
   fc_assert_ret_val(FALSE == inf->at_eof
                     || TRUE == inf->at_eof, FALSE);
   fc_assert_ret_val(FALSE == inf->in_string
@@ -212,6 +234,87 @@ static const char *inf_filename(struct inputfile *inf)
   }
 }
 
+/*******************************************************************//**
+  Return TRUE if the data starts like a file compressed with one of
+  the methods ioz supports.
+***********************************************************************/
+static bool is_compressed_data(const char *data, size_t size)
+{
+  static const char *const magics[] = {
+    "\x1f\x8b",                   /* gzip */
+    "BZh",                        /* bzip2 */
+    "\xfd" "7zXZ",                 /* xz */
+  };
+  size_t i;
+
+  for (i = 0; i < ARRAY_SIZE(magics); i++) {
+    size_t len = strlen(magics[i]);
+
+    if (size >= len && 0 == memcmp(data, magics[i], len)) {
+      return TRUE;
+    }
+  }
+
+  return FALSE;
+}
+
+/*******************************************************************//**
+  Read the whole of an uncompressed file to memory, so that lines can
+  be terminated in place.  Returns NULL if the file is compressed, or not suitable
+  for reading this way for other reasons; then it has to be read
+  through ioz.
+***********************************************************************/
+static struct inputfile *inf_from_memory_file(const char *filename,
+                                              datafilename_fn_t datafn)
+{
+  struct inputfile *inf;
+  struct stat buf;
+  FILE *fs;
+  char *mem;
+  size_t size;
+
+  if (0 != fc_stat(filename, &buf) || 0 >= buf.st_size
+      || !S_ISREG(buf.st_mode)) {
+    return NULL;
+  }
+
+  fs = fc_fopen(filename, "rb");
+  if (NULL == fs) {
+    return NULL;
+  }
+  size = buf.st_size;
+
+  mem = fc_malloc(size);
+  if (1 != fread(mem, size, 1, fs)) {
+    free(mem);
+    mem = NULL;
+  }
+  fclose(fs);
+
+  /* Lines are terminated in place of the newline, so the last line
+   * must have one too. Leave anything else to the ioz reader. */
+  if (NULL != mem
+      && ('\n' != mem[size - 1] || is_compressed_data(mem, size))) {
+    free(mem);
+    mem = NULL;
+  }
+
+  if (NULL == mem) {
+    return NULL;
+  }
+
+  inf = fc_malloc(sizeof(*inf));
+  init_zeros(inf);
+
+  inf->filename = fc_strdup(filename);
+  inf->mem = mem;
+  inf->mem_size = size;
+  inf->datafn = datafn;
+
+  log_debug("inputfile: read \"%s\" to memory", filename);
+  return inf;
+}
+
 /*******************************************************************//**
   Open the file, and return an allocated, initialized structure.
   Returns NULL if the file could not be opened.
@@ -224,6 +327,12 @@ struct inputfile *inf_from_file(const char *filename,
 
   fc_assert_ret_val(NULL != filename, NULL);
   fc_assert_ret_val(0 < strlen(filename), NULL);
+
+  inf = inf_from_memory_file(filename, datafn);
+  if (NULL != inf) {
+    return inf;
+  }
+
   fp = fz_from_file(filename, "r", -1, 0);
   if (!fp) {
     return NULL;
@@ -267,7 +376,10 @@ static void inf_close_partial(struct inputfile *inf)
 
   log_debug("inputfile: sub-closing \"%s\"", inf_filename(inf));
 
-  if (fz_ferror(inf->fp) != 0) {
+  if (NULL != inf->mem) {
+    free(inf->mem);
+    inf->mem = NULL;
+  } else if (fz_ferror(inf->fp) != 0) {
     log_error("Error before closing %s: %s", inf_filename(inf),
               fz_strerror(inf->fp));
     fz_fclose(inf->fp);
@@ -280,7 +392,7 @@ static void inf_close_partial(struct inputfile *inf)
     free(inf->filename);
   }
   inf->filename = NULL;
-  astr_free(&inf->cur_line);
+  astr_free(&inf->line_buf);
   astr_free(&inf->token);
   astr_free(&inf->partial);
 
@@ -317,7 +429,7 @@ static bool have_line(struct inputfile *inf)
 {
   fc_assert_ret_val(inf_sanity_check(inf), FALSE);
 
-  return !astr_empty(&inf->cur_line);
+  return 0 < inf->cur_line_len;
 }
 
 /*******************************************************************//**
@@ -326,9 +438,9 @@ static bool have_line(struct inputfile *inf)
 static bool at_eol(struct inputfile *inf)
 {
   fc_assert_ret_val(inf_sanity_check(inf), TRUE);
-  fc_assert_ret_val(inf->cur_line_pos <= astr_len(&inf->cur_line), TRUE);
+  fc_assert_ret_val(inf->cur_line_pos <= inf->cur_line_len, TRUE);
 
-  return (inf->cur_line_pos >= astr_len(&inf->cur_line));
+  return (inf->cur_line_pos >= inf->cur_line_len);
 }
 
 /*******************************************************************//**
@@ -361,11 +473,11 @@ static bool check_include(struct inputfile *inf)
     len = strlen(include_prefix);
   }
   fc_assert_ret_val(inf_sanity_check(inf), FALSE);
-  if (inf->in_string || astr_len(&inf->cur_line) <= len
+  if (inf->in_string || inf->cur_line_len <= len
       || inf->cur_line_pos > 0) {
     return FALSE;
   }
-  if (strncmp(astr_str(&inf->cur_line), include_prefix, len) != 0) {
+  if (strncmp(inf->cur_line, include_prefix, len) != 0) {
     return FALSE;
   }
   /* from here, the include-line must be well formed */
@@ -373,7 +485,7 @@ static bool check_include(struct inputfile *inf)
 
   /* skip any whitespace: */
   inf->cur_line_pos = len;
-  c = astr_str(&inf->cur_line) + len;
+  c = inf->cur_line + len;
   while (*c != '\0' && fc_isspace(*c)) {
     c++;
   }
@@ -384,7 +496,7 @@ static bool check_include(struct inputfile *inf)
     return FALSE;
   }
   c++;
-  inf->cur_line_pos = c - astr_str(&inf->cur_line);
+  inf->cur_line_pos = c - inf->cur_line;
 
   bare_name_start = c;
   while (*c != '\0' && *c != '\"') c++;
@@ -398,7 +510,7 @@ static bool check_include(struct inputfile *inf)
   bare_name = fc_malloc(bare_name_len);
   strncpy(bare_name, bare_name_start, bare_name_len - 1);
   bare_name[bare_name_len - 1] = '\0';
-  inf->cur_line_pos = c - astr_str(&inf->cur_line);
+  inf->cur_line_pos = c - inf->cur_line;
 
   /* check rest of line is well-formed: */
   while (*c != '\0' && fc_isspace(*c) && !is_comment(*c)) {
@@ -408,7 +520,7 @@ static bool check_include(struct inputfile *inf)
     inf_log(inf, LOG_ERROR, "Junk after filename for '*include' line");
     return FALSE;
   }
-  inf->cur_line_pos = astr_len(&inf->cur_line) - 1;
+  inf->cur_line_pos = inf->cur_line_len - 1;
 
   full_name = inf->datafn(bare_name);
   if (!full_name) {
@@ -445,25 +557,49 @@ static bool check_include(struct inputfile *inf)
 }
 
 /*******************************************************************//**
-  Read a new line into cur_line.
-  Increments line_num and cur_line_pos.
-  Returns 0 if didn't read or other problem: treat as EOF.
-  Strips newline from input.
+  Read a new line from the memory buffer into cur_line, terminating
+  it in place.  Returns FALSE at end of file.
 ***********************************************************************/
-static bool read_a_line(struct inputfile *inf)
+static bool read_a_line_mem(struct inputfile *inf)
 {
-  struct astring *line;
-  char *ret;
-  int pos;
-
-  fc_assert_ret_val(inf_sanity_check(inf), FALSE);
+  char *start, *end;
 
-  if (inf->at_eof) {
+  if (inf->mem_pos >= inf->mem_size) {
     return FALSE;
   }
 
+  /* The buffer always ends with a newline, see inf_from_memory_file(). */
+  start = inf->mem + inf->mem_pos;
+  end = memchr(start, '\n', inf->mem_size - inf->mem_pos);
+  inf->mem_pos = end + 1 - inf->mem;
+
+  /* Cope with \n\r and \r\n line endings: strip off any leading or
+   * trailing \r */
+  if (start < end && *start == '\r') {
+    start++;
+  }
+  if (start < end && *(end - 1) == '\r') {
+    end--;
+  }
+  *end = '\0';
+
+  inf->cur_line = start;
+  inf->cur_line_len = end - start;
+  return TRUE;
+}
+
+/*******************************************************************//**
+  Read a new line from the ioz stream into cur_line.  Returns FALSE
+  at end of file.
+***********************************************************************/
+static bool read_a_line_fz(struct inputfile *inf)
+{
+  struct astring *line;
+  char *ret;
+  int pos;
+
   /* abbreviation: */
-  line = &inf->cur_line;
+  line = &inf->line_buf;
 
   /* minimum initial line length: */
   astr_reserve(line, 80);
@@ -483,14 +619,7 @@ static bool read_a_line(struct inputfile *inf)
       if (pos > 0) {
         inf_log(inf, LOG_ERROR, _("End-of-file not in line of its own"));
       }
-      inf->at_eof = TRUE;
-      if (inf->in_string) {
-        /* Note: Don't allow multi-line strings to cross "include"
-         * boundaries */
-        inf_log(inf, LOG_ERROR, "Multi-line string went to end-of-file");
-        return FALSE;
-      }
-      break;
+      return FALSE;
     }
 
     /* Cope with \n\r line endings if not caught by library:
@@ -511,12 +640,37 @@ static bool read_a_line(struct inputfile *inf)
         end = pos - 1;
       }
       *((char *) astr_str(line) + end) = '\0';
-      break;
+      inf->cur_line = (char *) astr_str(line);
+      inf->cur_line_len = end;
+      return TRUE;
     }
     astr_reserve(line, pos * 2);
   }
+}
 
-  if (!inf->at_eof) {
+/*******************************************************************//**
+  Read a new line into cur_line.
+  Increments line_num and cur_line_pos.
+  Returns 0 if didn't read or other problem: treat as EOF.
+  Strips newline from input.
+***********************************************************************/
+static bool read_a_line(struct inputfile *inf)
+{
+  bool read;
+
+  fc_assert_ret_val(inf_sanity_check(inf), FALSE);
+
+  if (inf->at_eof) {
+    return FALSE;
+  }
+
+  if (NULL != inf->mem) {
+    read = read_a_line_mem(inf);
+  } else {
+    read = read_a_line_fz(inf);
+  }
+
+  if (read) {
     inf->line_num++;
     inf->cur_line_pos = 0;
 
@@ -524,19 +678,57 @@ static bool read_a_line(struct inputfile *inf)
       return read_a_line(inf);
     }
     return TRUE;
-  } else {
-    astr_clear(line);
-    if (inf->included_from) {
-      /* Pop the include, and get next line from file above instead. */
-      struct inputfile *inc = inf->included_from;
-      inf_close_partial(inf);
-      *inf = *inc;    /* so the user pointer in still valid
-                       * (and inf pointers in calling functions) */
-      free(inc);
-      return read_a_line(inf);
-    }
+  }
+
+  inf->at_eof = TRUE;
+  if (inf->in_string) {
+    /* Note: Don't allow multi-line strings to cross "include"
+     * boundaries */
+    inf_log(inf, LOG_ERROR, "Multi-line string went to end-of-file");
     return FALSE;
   }
+
+  inf->cur_line = NULL;
+  inf->cur_line_len = 0;
+  if (inf->included_from) {
+    /* Pop the include, and get next line from file above instead. */
+    struct inputfile *inc = inf->included_from;
+    inf_close_partial(inf);
+    *inf = *inc;    /* so the user pointer in still valid
+                     * (and inf pointers in calling functions) */
+    free(inc);
+    return read_a_line(inf);
+  }
+  return FALSE;
+}
+
+/*******************************************************************//**
+  Return the token from start to end, terminating it in the current
+  line instead of copying it.  The character at end is put back by
+  token_restore().
+***********************************************************************/
+static const char *token_in_line(struct inputfile *inf, const char *start,
+                                 const char *end)
+{
+  fc_assert_ret_val(NULL == inf->token_end, NULL);
+
+  inf->token_end = (char *) end;
+  inf->token_end_char = *end;
+  *inf->token_end = '\0';
+
+  return start;
+}
+
+/*******************************************************************//**
+  Put back the character replaced by the terminator of the last token
+  returned by token_in_line().
+***********************************************************************/
+static void token_restore(struct inputfile *inf)
+{
+  if (NULL != inf->token_end) {
+    *inf->token_end = inf->token_end_char;
+    inf->token_end = NULL;
+  }
 }
 
 /*******************************************************************//**
@@ -560,13 +752,17 @@ char *inf_log_str(struct inputfile *inf, const char *message, ...)
     str[0] = '\0';
   }
 
+  /* The message may include the last token, so only now show the rest
+   * of the line as it was read. */
+  token_restore(inf);
+
   cat_snprintf(str, sizeof(str), "  file \"%s\", line %d, pos %d%s",
                inf_filename(inf), inf->line_num, inf->cur_line_pos,
                (inf->at_eof ? ", EOF" : ""));
 
-  if (!astr_empty(&inf->cur_line)) {
+  if (0 < inf->cur_line_len) {
     cat_snprintf(str, sizeof(str), "\n  looking at: '%s'",
-                 astr_str(&inf->cur_line) + inf->cur_line_pos);
+                 inf->cur_line + inf->cur_line_pos);
   }
   if (inf->in_string) {
     cat_snprintf(str, sizeof(str),
@@ -596,6 +792,8 @@ const char *inf_token(struct inputfile *inf, enum inf_token_type type)
   name = tok_tab[type].name ? tok_tab[type].name : "(unnamed)";
   func = tok_tab[type].func;
 
+  token_restore(inf);
+
   if (!func) {
     log_error("token type %d (%s) not supported yet", type, name);
     c = NULL;
@@ -610,7 +808,7 @@ const char *inf_token(struct inputfile *inf, enum inf_token_type type)
     }
   }
   if (c && INF_DEBUG_FOUND) {
-    log_debug("inputfile: found %s '%s'", name, astr_str(&inf->token));
+    log_debug("inputfile: found %s '%s'", name, c);
   }
   return c;
 }
@@ -641,7 +839,7 @@ static const char *get_token_section_name(struct inputfile *inf)
 
   fc_assert_ret_val(have_line(inf), NULL);
 
-  c = astr_str(&inf->cur_line) + inf->cur_line_pos;
+  c = inf->cur_line + inf->cur_line_pos;
   if (*c++ != '[') {
     return NULL;
   }
@@ -652,11 +850,8 @@ static const char *get_token_section_name(struct inputfile *inf)
   if (*c != ']') {
     return NULL;
   }
-  *((char *) c) = '\0'; /* Tricky. */
-  astr_set(&inf->token, "%s", start);
-  *((char *) c) = ']';  /* Revert. */
-  inf->cur_line_pos = c + 1 - astr_str(&inf->cur_line);
-  return astr_str(&inf->token);
+  inf->cur_line_pos = c + 1 - inf->cur_line;
+  return token_in_line(inf, start, c);
 }
 
 /*******************************************************************//**
@@ -666,11 +861,10 @@ static const char *get_token_section_name(struct inputfile *inf)
 static const char *get_token_entry_name(struct inputfile *inf)
 {
   const char *c, *start, *end;
-  char trailing;
 
   fc_assert_ret_val(have_line(inf), NULL);
 
-  c = astr_str(&inf->cur_line) + inf->cur_line_pos;
+  c = inf->cur_line + inf->cur_line_pos;
   while (*c != '\0' && fc_isspace(*c)) {
     c++;
   }
@@ -691,12 +885,8 @@ static const char *get_token_entry_name(struct inputfile *inf)
   if (*c != '=') {
     return NULL;
   }
-  trailing = *end;
-  *((char *) end) = '\0';       /* Tricky. */
-  astr_set(&inf->token, "%s", start);
-  *((char *) end) = trailing;   /* Revert. */
-  inf->cur_line_pos = c + 1 - astr_str(&inf->cur_line);
-  return astr_str(&inf->token);
+  inf->cur_line_pos = c + 1 - inf->cur_line;
+  return token_in_line(inf, start, end);
 }
 
 /*******************************************************************//**
@@ -710,7 +900,7 @@ static const char *get_token_eol(struct inputfile *inf)
   fc_assert_ret_val(have_line(inf), NULL);
 
   if (!at_eol(inf)) {
-    c = astr_str(&inf->cur_line) + inf->cur_line_pos;
+    c = inf->cur_line + inf->cur_line_pos;
     while (*c != '\0' && fc_isspace(*c)) {
       c++;
     }
@@ -720,11 +910,11 @@ static const char *get_token_eol(struct inputfile *inf)
   }
 
   /* finished with this line: say that we don't have it any more: */
-  astr_clear(&inf->cur_line);
+  inf->cur_line = NULL;
+  inf->cur_line_len = 0;
   inf->cur_line_pos = 0;
 
-  astr_set(&inf->token, " ");
-  return astr_str(&inf->token);
+  return " ";
 }
 
 /*******************************************************************//**
@@ -738,16 +928,15 @@ static const char *get_token_white_char(struct inputfile *inf,
 
   fc_assert_ret_val(have_line(inf), NULL);
 
-  c = astr_str(&inf->cur_line) + inf->cur_line_pos;
+  c = inf->cur_line + inf->cur_line_pos;
   while (*c != '\0' && fc_isspace(*c)) {
     c++;
   }
   if (*c != target) {
     return NULL;
   }
-  inf->cur_line_pos = c + 1 - astr_str(&inf->cur_line);
-  astr_set(&inf->token, "%c", target);
-  return astr_str(&inf->token);
+  inf->cur_line_pos = c + 1 - inf->cur_line;
+  return token_in_line(inf, c, c + 1);
 }
 
 /*******************************************************************//**
@@ -787,7 +976,7 @@ static const char *get_token_value(struct inputfile *inf)
 
   fc_assert_ret_val(have_line(inf), NULL);
 
-  c = astr_str(&inf->cur_line) + inf->cur_line_pos;
+  c = inf->cur_line + inf->cur_line_pos;
   while (*c != '\0' && fc_isspace(*c)) {
     c++;
   }
@@ -812,16 +1001,9 @@ static const char *get_token_value(struct inputfile *inf)
     if (!(*c == '\0' || *c == ',' || fc_isspace(*c) || is_comment(*c))) {
       return NULL;
     }
-    /* If its a comma, we don't want to obliterate it permanently,
-     * so remember it: */
-    trailing = *c;
-    *((char *) c) = '\0';       /* Tricky. */
 
-    inf->cur_line_pos = c - astr_str(&inf->cur_line);
-    astr_set(&inf->token, "%s", start);
-
-    *((char *) c) = trailing;   /* Revert. */
-    return astr_str(&inf->token);
+    inf->cur_line_pos = c - inf->cur_line;
+    return token_in_line(inf, start, c);
   }
 
   /* allow gettext marker: */
@@ -867,18 +1049,17 @@ static const char *get_token_value(struct inputfile *inf)
     if (rfname == NULL) {
       inf_log(inf, LOG_ERROR, 
               _("Cannot find stringfile \"%s\"."), start);
-      *((char *) c) = trailing; /* Revert. */
+      *((char *) (c - 1)) = trailing; /* Revert. */
       return NULL;
     }
-    *((char *) c) = trailing; /* Revert. */
+    *((char *) (c - 1)) = trailing; /* Revert. */
     fp = fz_from_file(rfname, "r", -1, 0);
     if (!fp) {
       inf_log(inf, LOG_ERROR,
               _("Cannot open stringfile \"%s\"."), rfname);
       return NULL;
     }
-    log_debug("Stringfile \"%s\" opened ok", start);
-    *((char *) (c - 1)) = trailing; /* Revert. */
+    log_debug("Stringfile \"%s\" opened ok", rfname);
     astr_set(&inf->token, "*"); /* Mark as a string read from a file */
 
     eof = FALSE;
@@ -898,7 +1079,7 @@ static const char *get_token_value(struct inputfile *inf)
 
     fz_fclose(fp);
 
-    inf->cur_line_pos = c + 1 - astr_str(&inf->cur_line);
+    inf->cur_line_pos = c - inf->cur_line;
 
     return astr_str(&inf->token);
   } else if (border_character != '\"'
@@ -913,16 +1094,9 @@ static const char *get_token_value(struct inputfile *inf)
     if (!(*c == '\0' || *c == ',' || fc_isspace(*c) || is_comment(*c))) {
       return NULL;
     }
-    /* If its a comma, we don't want to obliterate it permanently,
-     * so remember it: */
-    trailing = *c;
-    *((char *) c) = '\0';       /* Tricky. */
-
-    inf->cur_line_pos = c - astr_str(&inf->cur_line);
-    astr_set(&inf->token, "%s", start);
 
-    *((char *) c) = trailing;   /* Revert. */
-    return astr_str(&inf->token);
+    inf->cur_line_pos = c - inf->cur_line;
+    return token_in_line(inf, start, c);
   }
 
   /* From here, we know we have a string, we just have to find the
@@ -970,26 +1144,31 @@ static const char *get_token_value(struct inputfile *inf)
               "Bad return for multi-line string from read_a_line");
       return NULL;
     }
-    c = start = astr_str(&inf->cur_line);
+    c = start = inf->cur_line;
   }
 
   /* found end of string */
-  trailing = *c;
-  *((char *) c) = '\0';         /* Tricky. */
-
-  inf->cur_line_pos = c + 1 - astr_str(&inf->cur_line);
-  astr_set(&inf->token, "%s%s", astr_str(partial), start);
-
-  *((char *) c) = trailing;     /* Revert. */
+  inf->cur_line_pos = c + 1 - inf->cur_line;
 
   /* check gettext tag at end: */
   if (has_i18n_marking) {
-    if (*++c == ')') {
+    if (*(c + 1) == ')') {
       inf->cur_line_pos++;
     } else {
       inf_warn(inf, "Missing end of i18n string marking");
     }
   }
   inf->in_string = FALSE;
+
+  if (astr_empty(partial)) {
+    /* Single line string. */
+    return token_in_line(inf, start, c);
+  }
+
+  trailing = *c;
+  *((char *) c) = '\0';         /* Tricky. */
+  astr_set(&inf->token, "%s%s", astr_str(partial), start);
+  *((char *) c) = trailing;     /* Revert. */
+
   return astr_str(&inf->token);
 }
@@ -81,6 +81,12 @@ struct bzip2_struct {
 #define XZ_DECODER_MEMLIMIT_STEP (25*1024*1024)   /* Increase 25Mb at a time */
 #define XZ_DECODER_MEMLIMIT_FINAL (100*1024*1024) /* 100Mb */
 
+/* FZ_XZ_MT splits the stream to blocks of this size, and compresses
+   them in parallel. Blocks also carry their sizes in headers, so
+   the decoder can decompress them in parallel too. */
+#define XZ_MT_BLOCK_SIZE (1024*1024)               /* 1Mb */
+#define XZ_MT_MAX_THREADS 8
+
 struct xz_struct {
   lzma_stream stream;
   int out_index;
@@ -108,8 +114,12 @@ struct xz_struct {
   bool hack_byte_used;
 };
 
+static lzma_ret xz_encoder_init(lzma_stream *stream, enum fz_method method,
+                                int compress_level);
+static lzma_ret xz_decoder_init(lzma_stream *stream, uint64_t memlimit);
 static bool xz_outbuffer_to_file(fz_FILE *fp, lzma_action action);
 static void xz_action(fz_FILE *fp, lzma_action action);
+static void xz_refill(fz_FILE *fp);
 
 #endif /* FREECIV_HAVE_LIBLZMA */
 
@@ -154,6 +164,7 @@ static inline bool fz_method_is_valid(enum fz_method method)
 #endif
 #ifdef FREECIV_HAVE_LIBLZMA
   case FZ_XZ:
+  case FZ_XZ_MT:
 #endif
     return TRUE;
   }
@@ -290,9 +301,7 @@ fz_FILE *fz_from_file(const char *filename, const char *in_mode,
     /* Try to open as xz file */
     fp->u.xz.memlimit = XZ_DECODER_MEMLIMIT;
     memset(&fp->u.xz.stream, 0, sizeof(lzma_stream));
-    fp->u.xz.error = lzma_stream_decoder(&fp->u.xz.stream,
-                                         fp->u.xz.memlimit,
-                                         LZMA_CONCATENATED);
+    fp->u.xz.error = xz_decoder_init(&fp->u.xz.stream, fp->u.xz.memlimit);
     if (fp->u.xz.error != LZMA_OK) {
       free(fp);
       return NULL;
@@ -353,18 +362,21 @@ fz_FILE *fz_from_file(const char *filename, const char *in_mode,
   switch (fp->method) {
 #ifdef FREECIV_HAVE_LIBLZMA
   case FZ_XZ:
+  case FZ_XZ_MT:
     {
       lzma_ret ret;
 
       /*  xz files are binary files, so we should add "b" to mode! */
       sz_strlcat(mode,"b");
       memset(&fp->u.xz.stream, 0, sizeof(lzma_stream));
-      ret = lzma_easy_encoder(&fp->u.xz.stream, compress_level, LZMA_CHECK_CRC32);
+      ret = xz_encoder_init(&fp->u.xz.stream, fp->method, compress_level);
       fp->u.xz.error = ret;
       if (ret != LZMA_OK) {
         free(fp);
         return NULL;
       }
+      /* The output is a regular xz stream either way. */
+      fp->method = FZ_XZ;
       fp->u.xz.in_buf = fc_malloc(PLAIN_FILE_BUF_SIZE);
       fp->u.xz.stream.next_in = fp->u.xz.in_buf;
       fp->u.xz.out_buf = fc_malloc(PLAIN_FILE_BUF_SIZE);
@@ -483,6 +495,7 @@ int fz_fclose(fz_FILE *fp)
   switch (fz_method_validate(fp->method)) {
 #ifdef FREECIV_HAVE_LIBLZMA
   case FZ_XZ:
+  case FZ_XZ_MT:
     if (fp->mode == 'w' && !xz_outbuffer_to_file(fp, LZMA_FINISH)) {
       error = 1;
     }
@@ -572,11 +585,11 @@ char *fz_fgets(char *buffer, int size, fz_FILE *fp)
   switch (fz_method_validate(fp->method)) {
 #ifdef FREECIV_HAVE_LIBLZMA
   case FZ_XZ:
+  case FZ_XZ_MT:
     {
       int i, j;
 
       for (i = 0; i < size - 1; i += j) {
-        size_t len = 0;
         bool line_end;
 
         for (j = 0, line_end = FALSE; fp->u.xz.out_avail > 0
@@ -595,61 +608,19 @@ char *fz_fgets(char *buffer, int size, fz_FILE *fp)
           return buffer;
         }
 
-        if (fp->u.xz.hack_byte_used) {
-          size_t hblen = 0;
-
-          fp->u.xz.in_buf[0] = fp->u.xz.hack_byte;
-          len = fread(fp->u.xz.in_buf + 1, 1, PLAIN_FILE_BUF_SIZE - 1,
-                      fp->u.xz.plain);
-          len++;
-
-          if (len <= 1) {
-            hblen = fread(&fp->u.xz.hack_byte, 1, 1, fp->u.xz.plain);
-          }
-          if (hblen == 0) {
-            fp->u.xz.hack_byte_used = FALSE;
-          }
-        }
-        if (len == 0) {
-          if (fp->u.xz.error == LZMA_STREAM_END) {
-            if (i + j == 0) {
-              /* Plain file read complete, and there was nothing in xz buffers
-                 -> end-of-file. */
-              return NULL;
-            }
-            buffer[i + j] = '\0';
-            return buffer;
-          } else {
-            fp->u.xz.stream.next_out = fp->u.xz.out_buf;
-            fp->u.xz.stream.avail_out = PLAIN_FILE_BUF_SIZE;
-            xz_action(fp, LZMA_FINISH);
-            fp->u.xz.out_index = 0;
-            fp->u.xz.out_avail =
-              fp->u.xz.stream.total_out - fp->u.xz.total_read;
-            if (fp->u.xz.error != LZMA_OK
-                && fp->u.xz.error != LZMA_STREAM_END) {
-              return NULL;
-            }
-          }
-        } else {
-          lzma_action action;
-
-          fp->u.xz.stream.next_in = fp->u.xz.in_buf;
-          fp->u.xz.stream.avail_in = len;
-          fp->u.xz.stream.next_out = fp->u.xz.out_buf;
-          fp->u.xz.stream.avail_out = PLAIN_FILE_BUF_SIZE;
-          if (fp->u.xz.hack_byte_used) {
-            action = LZMA_RUN;
-          } else {
-            action = LZMA_FINISH;
-          }
-          xz_action(fp, action);
-          fp->u.xz.out_avail =
-            fp->u.xz.stream.total_out - fp->u.xz.total_read;
-          fp->u.xz.out_index = 0;
-          if (fp->u.xz.error != LZMA_OK && fp->u.xz.error != LZMA_STREAM_END) {
+        if (fp->u.xz.error == LZMA_STREAM_END) {
+          if (i + j == 0) {
+            /* Decoder has finished, and there was nothing in xz buffers
+               -> end-of-file. */
             return NULL;
           }
+          buffer[i + j] = '\0';
+          return buffer;
+        }
+
+        xz_refill(fp);
+        if (fp->u.xz.error != LZMA_OK && fp->u.xz.error != LZMA_STREAM_END) {
+          return NULL;
         }
       }
 
@@ -716,6 +687,78 @@ char *fz_fgets(char *buffer, int size, fz_FILE *fp)
 
 #ifdef FREECIV_HAVE_LIBLZMA
 
+#if defined(HAVE_LZMA_STREAM_ENCODER_MT) || defined(HAVE_LZMA_STREAM_DECODER_MT)
+/************************************************************************//**
+  Number of threads to use for multi-threaded xz coding.
+****************************************************************************/
+static uint32_t xz_threads(void)
+{
+  uint32_t threads = lzma_cputhreads();
+
+  return CLIP(1, threads, XZ_MT_MAX_THREADS);
+}
+#endif /* HAVE_LZMA_STREAM_ENCODER_MT || HAVE_LZMA_STREAM_DECODER_MT */
+
+/************************************************************************//**
+  Set up xz encoder. FZ_XZ_MT compresses blocks in parallel if liblzma
+  supports it, and falls back to the single-threaded encoder if not.
+****************************************************************************/
+static lzma_ret xz_encoder_init(lzma_stream *stream, enum fz_method method,
+                                int compress_level)
+{
+#ifdef HAVE_LZMA_STREAM_ENCODER_MT
+  if (method == FZ_XZ_MT) {
+    lzma_options_lzma opt_lzma;
+    lzma_filter filters[2];
+    lzma_mt mt;
+
+    if (lzma_lzma_preset(&opt_lzma, compress_level)) {
+      return LZMA_OPTIONS_ERROR;
+    }
+
+    /* Dictionary larger than a block would never be used, but each
+       thread would still allocate it. */
+    if (opt_lzma.dict_size > XZ_MT_BLOCK_SIZE) {
+      opt_lzma.dict_size = XZ_MT_BLOCK_SIZE;
+    }
+    filters[0].id = LZMA_FILTER_LZMA2;
+    filters[0].options = &opt_lzma;
+    filters[1].id = LZMA_VLI_UNKNOWN;
+
+    memset(&mt, 0, sizeof(mt));
+    mt.threads = xz_threads();
+    mt.block_size = XZ_MT_BLOCK_SIZE;
+    mt.filters = filters;
+    mt.check = LZMA_CHECK_CRC32;
+
+    return lzma_stream_encoder_mt(stream, &mt);
+  }
+#endif /* HAVE_LZMA_STREAM_ENCODER_MT */
+
+  return lzma_easy_encoder(stream, compress_level, LZMA_CHECK_CRC32);
+}
+
+/************************************************************************//**
+  Set up xz decoder. Files written with FZ_XZ_MT get decompressed
+  in parallel if liblzma supports it.
+****************************************************************************/
+static lzma_ret xz_decoder_init(lzma_stream *stream, uint64_t memlimit)
+{
+#ifdef HAVE_LZMA_STREAM_DECODER_MT
+  lzma_mt mt;
+
+  memset(&mt, 0, sizeof(mt));
+  mt.threads = xz_threads();
+  mt.flags = LZMA_CONCATENATED;
+  mt.memlimit_threading = memlimit;
+  mt.memlimit_stop = memlimit;
+
+  return lzma_stream_decoder_mt(stream, &mt);
+#else  /* HAVE_LZMA_STREAM_DECODER_MT */
+  return lzma_stream_decoder(stream, memlimit, LZMA_CONCATENATED);
+#endif /* HAVE_LZMA_STREAM_DECODER_MT */
+}
+
 /************************************************************************//**
   Helper function to do given compression action and writing
   results from output buffer to file.
@@ -743,7 +786,8 @@ static bool xz_outbuffer_to_file(fz_FILE *fp, lzma_action action)
     }
     fp->u.xz.stream.avail_out = PLAIN_FILE_BUF_SIZE;
     fp->u.xz.stream.next_out = fp->u.xz.out_buf;
-  } while (fp->u.xz.stream.avail_in > 0);
+  } while (fp->u.xz.stream.avail_in > 0
+           || (action == LZMA_FINISH && fp->u.xz.error != LZMA_STREAM_END));
 
   return TRUE;
 }
@@ -769,6 +813,34 @@ static void xz_action(fz_FILE *fp, lzma_action action)
 
   fp->u.xz.error = lzma_code(&fp->u.xz.stream, action);
 }
+
+/************************************************************************//**
+  Helper function to decompress more data to the empty output buffer.
+  More input is read from the file only when the decoder has consumed
+  all of the previous input.
+****************************************************************************/
+static void xz_refill(fz_FILE *fp)
+{
+  if (fp->u.xz.stream.avail_in == 0 && fp->u.xz.hack_byte_used) {
+    size_t len;
+
+    fp->u.xz.in_buf[0] = fp->u.xz.hack_byte;
+    len = fread(fp->u.xz.in_buf + 1, 1, PLAIN_FILE_BUF_SIZE - 1,
+                fp->u.xz.plain);
+    fp->u.xz.stream.next_in = fp->u.xz.in_buf;
+    fp->u.xz.stream.avail_in = len + 1;
+
+    if (fread(&fp->u.xz.hack_byte, 1, 1, fp->u.xz.plain) == 0) {
+      fp->u.xz.hack_byte_used = FALSE;
+    }
+  }
+
+  fp->u.xz.stream.next_out = fp->u.xz.out_buf;
+  fp->u.xz.stream.avail_out = PLAIN_FILE_BUF_SIZE;
+  xz_action(fp, fp->u.xz.hack_byte_used ? LZMA_RUN : LZMA_FINISH);
+  fp->u.xz.out_index = 0;
+  fp->u.xz.out_avail = fp->u.xz.stream.total_out - fp->u.xz.total_read;
+}
 #endif /* FREECIV_HAVE_LIBLZMA */
 
 /************************************************************************//**
@@ -793,6 +865,7 @@ int fz_fprintf(fz_FILE *fp, const char *format, ...)
   switch (fz_method_validate(fp->method)) {
 #ifdef FREECIV_HAVE_LIBLZMA
   case FZ_XZ:
+  case FZ_XZ_MT:
     {
       va_start(ap, format);
       num = fc_vsnprintf((char *)fp->u.xz.in_buf, PLAIN_FILE_BUF_SIZE, format, ap);
@@ -877,6 +950,7 @@ int fz_ferror(fz_FILE *fp)
   switch (fz_method_validate(fp->method)) {
 #ifdef FREECIV_HAVE_LIBLZMA
   case FZ_XZ:
+  case FZ_XZ_MT:
     if (fp->u.xz.error != LZMA_OK
         && fp->u.xz.error != LZMA_STREAM_END) {
       return 1;
@@ -926,6 +1000,7 @@ const char *fz_strerror(fz_FILE *fp)
   switch (fz_method_validate(fp->method)) {
 #ifdef FREECIV_HAVE_LIBLZMA
   case FZ_XZ:
+  case FZ_XZ_MT:
     {
       static char xzerror[50];
       char *cleartext = NULL;
@@ -43,6 +43,7 @@ enum fz_method {
 #endif
 #ifdef FREECIV_HAVE_LIBLZMA
   FZ_XZ,
+  FZ_XZ_MT,     /* Writes FZ_XZ files, compressing blocks in parallel */
 #endif
 };
 
@@ -20,6 +20,7 @@
 #include <libxml/parser.h>
 #endif /* FREECIV_HAVE_XML_REGISTRY */
 
+#include "registry_bin.h"
 #include "registry_xml.h"
 
 #include "registry.h"
@@ -50,6 +51,13 @@ void registry_module_close(void)
 struct section_file *secfile_load(const char *filename,
                                   bool allow_duplicates)
 {
+  char real_filename[1024];
+
+  interpret_tilde(real_filename, sizeof(real_filename), filename);
+  if (is_binfile(real_filename)) {
+    return binfile_load(filename, allow_duplicates);
+  }
+
 #ifdef FREECIV_HAVE_XML_REGISTRY
   struct stat buf;
 
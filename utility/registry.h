@@ -35,6 +35,7 @@ void secfile_allow_digital_boolean(struct section_file *secfile,
 const char *secfile_error(void);
 const char *section_name(const struct section *psection);
 
+#include "registry_bin.h"
 #include "registry_ini.h"
 
 #ifdef __cplusplus
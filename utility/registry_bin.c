@@ -0,0 +1,674 @@
+/***********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+
+/**************************************************************************
+  Binary backend for the registry.
+
+  This stores a section_file as fixed size records instead of text, so
+  that large files (mostly savegames) can be written without formatting
+  every value and read back without tokenizing anything. The file can
+  be mapped in memory as is; all integers are 32 bit little endian.
+
+    header    magic "FCSECBIN", version, number of sections, number of
+              entries, offset and size of the string pool, flags
+    sections  for each section: name, number of entries, special type,
+              directly followed by the records of its entries
+    entries   name, type, string flags, value, comment
+    pool      all the NUL terminated strings, each stored once
+
+  Names, string values and comments are offsets in the string pool.
+  Sections and entries are written as they are visited, only the pool
+  is kept in memory until the end, and the header is updated last. This
+  lets secfile_stream_open_binary() write the sections of a savegame
+  while the rest is still being built, like secfile_stream_open() does
+  for text files.
+
+  When loading, the file stays in memory as long as the section file,
+  and the string values of the entries point in its pool instead of
+  being copied.
+**************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include <fc_config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+
+/* utility */
+#include "fcintl.h"
+#include "log.h"
+#include "mem.h"
+#include "registry.h"
+#include "section_file.h"
+#include "shared.h"
+#include "support.h"
+
+#include "registry_bin.h"
+
+#define FCBIN_HEADER_SIZE 32
+#define FCBIN_SECTION_SIZE 12
+#define FCBIN_ENTRY_SIZE 16
+#define FCBIN_NO_STRING 0xFFFFFFFF
+
+/* String entry flags. */
+#define FCBIN_STR_ESCAPED       (1 << 0)
+#define FCBIN_STR_GT_MARKING    (1 << 1)
+
+FC_STATIC_ASSERT(sizeof(float) == sizeof(uint32_t), float_not_32bit);
+
+#define SPECHASH_TAG strpool
+#define SPECHASH_CSTR_KEY_TYPE
+#define SPECHASH_INT_DATA_TYPE
+#include "spechash.h"
+
+/* The pool is built in chunks which are never moved, so that the index
+ * can point in them. */
+#define FCBIN_POOL_CHUNK (64 * 1024)
+
+struct binfile_chunk {
+  char *data;
+  size_t used;
+  size_t alloc;
+};
+
+#define SPECLIST_TAG binfile_chunk
+#define SPECLIST_TYPE struct binfile_chunk
+#include "speclist.h"
+
+#define binfile_chunk_list_iterate(chunklist, pchunk) \
+  TYPED_LIST_ITERATE(struct binfile_chunk, chunklist, pchunk)
+#define binfile_chunk_list_iterate_end LIST_ITERATE_END
+
+struct binfile_writer {
+  FILE *fs;
+  char *filename;
+  struct strpool_hash *index;   /* String -> offset in pool. */
+  struct binfile_chunk_list *pool;
+  size_t pool_size;
+  uint32_t num_sections;
+  uint32_t num_entries;
+  bool ok;                      /* FALSE after the first error. */
+};
+
+struct binfile_data {
+  const unsigned char *data;
+  size_t size;
+  bool mapped;
+};
+
+/**********************************************************************//**
+  Store a 32 bit value in little endian order.
+**************************************************************************/
+static inline void bin_put_u32(unsigned char *buf, uint32_t value)
+{
+  buf[0] = value & 0xFF;
+  buf[1] = (value >> 8) & 0xFF;
+  buf[2] = (value >> 16) & 0xFF;
+  buf[3] = (value >> 24) & 0xFF;
+}
+
+/**********************************************************************//**
+  Read a 32 bit value stored in little endian order.
+**************************************************************************/
+static inline uint32_t bin_get_u32(const unsigned char *buf)
+{
+  return ((uint32_t) buf[0]
+          | ((uint32_t) buf[1] << 8)
+          | ((uint32_t) buf[2] << 16)
+          | ((uint32_t) buf[3] << 24));
+}
+
+/**********************************************************************//**
+  Free a chunk of the string pool.
+**************************************************************************/
+static void binfile_chunk_destroy(struct binfile_chunk *pchunk)
+{
+  free(pchunk->data);
+  free(pchunk);
+}
+
+/**********************************************************************//**
+  Returns the offset of the string in the pool, adding it if it is not
+  already there.
+**************************************************************************/
+static uint32_t binfile_pool_add(struct binfile_writer *writer,
+                                 const char *str)
+{
+  struct binfile_chunk *pchunk = binfile_chunk_list_back(writer->pool);
+  size_t len;
+  int offset;
+
+  if (strpool_hash_lookup(writer->index, (char *) str, &offset)) {
+    return offset;
+  }
+
+  len = strlen(str) + 1;
+  fc_assert_ret_val(writer->pool_size + len < FCBIN_NO_STRING,
+                    FCBIN_NO_STRING);
+
+  if (NULL == pchunk || pchunk->used + len > pchunk->alloc) {
+    pchunk = fc_malloc(sizeof(*pchunk));
+    pchunk->alloc = MAX(FCBIN_POOL_CHUNK, len);
+    pchunk->data = fc_malloc(pchunk->alloc);
+    pchunk->used = 0;
+    binfile_chunk_list_append(writer->pool, pchunk);
+  }
+
+  offset = writer->pool_size;
+  memcpy(pchunk->data + pchunk->used, str, len);
+  strpool_hash_insert(writer->index, pchunk->data + pchunk->used, offset);
+  pchunk->used += len;
+  writer->pool_size += len;
+
+  return offset;
+}
+
+/**********************************************************************//**
+  Write the record of an entry. Returns TRUE on success.
+**************************************************************************/
+static bool binfile_write_entry(struct binfile_writer *writer,
+                                const struct entry *pentry)
+{
+  unsigned char rec[FCBIN_ENTRY_SIZE];
+  const char *comment = entry_comment(pentry);
+  enum entry_type type = entry_type_get(pentry);
+  uint32_t value = 0;
+  unsigned char flags = 0;
+
+  switch (type) {
+  case ENTRY_BOOL:
+    {
+      bool bval;
+
+      entry_bool_get(pentry, &bval);
+      value = bval ? 1 : 0;
+    }
+    break;
+  case ENTRY_INT:
+    {
+      int ival;
+
+      entry_int_get(pentry, &ival);
+      value = (uint32_t) ival;
+    }
+    break;
+  case ENTRY_FLOAT:
+    {
+      float fval;
+
+      entry_float_get(pentry, &fval);
+      memcpy(&value, &fval, sizeof(value));
+    }
+    break;
+  case ENTRY_STR:
+    {
+      const char *str;
+
+      entry_str_get(pentry, &str);
+      value = binfile_pool_add(writer, str);
+      if (entry_str_escaped(pentry)) {
+        flags |= FCBIN_STR_ESCAPED;
+      }
+      if (entry_str_gt_marking(pentry)) {
+        flags |= FCBIN_STR_GT_MARKING;
+      }
+    }
+    break;
+  case ENTRY_FILEREFERENCE:
+  case ENTRY_ILLEGAL:
+    SECFILE_LOG(entry_section(pentry)->secfile, entry_section(pentry),
+                "Entry \"%s\" cannot be saved in binary format.",
+                entry_name(pentry));
+    return FALSE;
+  }
+
+  bin_put_u32(rec, binfile_pool_add(writer, entry_name(pentry)));
+  rec[4] = type;
+  rec[5] = flags;
+  rec[6] = rec[7] = 0;
+  bin_put_u32(rec + 8, value);
+  bin_put_u32(rec + 12, NULL != comment
+              ? binfile_pool_add(writer, comment) : FCBIN_NO_STRING);
+
+  return 1 == fwrite(rec, sizeof(rec), 1, writer->fs);
+}
+
+/**********************************************************************//**
+  Open the file and start writing it. Returns NULL on error.
+**************************************************************************/
+static struct binfile_writer *binfile_writer_new(const char *filename)
+{
+  char real_filename[1024];
+  unsigned char header[FCBIN_HEADER_SIZE];
+  struct binfile_writer *writer;
+  FILE *fs;
+
+  interpret_tilde(real_filename, sizeof(real_filename), filename);
+  fs = fc_fopen(real_filename, "wb");
+  if (NULL == fs) {
+    SECFILE_LOG(NULL, NULL, _("Could not open %s for writing"),
+                real_filename);
+    return NULL;
+  }
+
+  writer = fc_malloc(sizeof(*writer));
+  writer->fs = fs;
+  writer->filename = fc_strdup(real_filename);
+  writer->index = strpool_hash_new();
+  writer->pool = binfile_chunk_list_new_full(binfile_chunk_destroy);
+  writer->pool_size = 0;
+  writer->num_sections = 0;
+  writer->num_entries = 0;
+
+  /* Counts and pool location are filled in once everything is out. */
+  memset(header, 0, sizeof(header));
+  writer->ok = (1 == fwrite(header, sizeof(header), 1, fs));
+
+  return writer;
+}
+
+/**********************************************************************//**
+  Write the records of a section and of its entries. Once a write has
+  failed, does nothing. Returns FALSE iff the file cannot be completed.
+**************************************************************************/
+bool binfile_writer_section(struct binfile_writer *writer,
+                            const struct section *psection)
+{
+  unsigned char rec[FCBIN_SECTION_SIZE];
+
+  if (!writer->ok) {
+    return FALSE;
+  }
+
+  if (EST_INCLUDE == psection->special) {
+    SECFILE_LOG(psection->secfile, psection,
+                "Include sections cannot be saved in binary format.");
+    writer->ok = FALSE;
+    return FALSE;
+  }
+
+  bin_put_u32(rec, binfile_pool_add(writer, section_name(psection)));
+  bin_put_u32(rec + 4, entry_list_size(section_entries(psection)));
+  bin_put_u32(rec + 8, psection->special);
+  writer->ok = (1 == fwrite(rec, sizeof(rec), 1, writer->fs));
+  writer->num_sections++;
+
+  entry_list_iterate(section_entries(psection), pentry) {
+    if (!writer->ok) {
+      break;
+    }
+    writer->ok = binfile_write_entry(writer, pentry);
+    writer->num_entries++;
+  } entry_list_iterate_end;
+
+  return writer->ok;
+}
+
+/**********************************************************************//**
+  Write the string pool and the header, close the file and free the
+  writer. Returns TRUE on success.
+**************************************************************************/
+bool binfile_writer_close(struct binfile_writer *writer)
+{
+  unsigned char header[FCBIN_HEADER_SIZE];
+  long pool_offset = -1;
+  bool ok = writer->ok;
+
+  if (ok) {
+    pool_offset = ftell(writer->fs);
+    ok = (0 < pool_offset);
+  }
+
+  binfile_chunk_list_iterate(writer->pool, pchunk) {
+    if (!ok) {
+      break;
+    }
+    ok = (1 == fwrite(pchunk->data, pchunk->used, 1, writer->fs));
+  } binfile_chunk_list_iterate_end;
+
+  if (ok) {
+    memcpy(header, FCBIN_MAGIC, FCBIN_MAGIC_LEN);
+    bin_put_u32(header + 8, FCBIN_VERSION);
+    bin_put_u32(header + 12, writer->num_sections);
+    bin_put_u32(header + 16, writer->num_entries);
+    bin_put_u32(header + 20, pool_offset);
+    bin_put_u32(header + 24, writer->pool_size);
+    bin_put_u32(header + 28, 0);
+    ok = (0 == fseek(writer->fs, 0, SEEK_SET)
+          && 1 == fwrite(header, sizeof(header), 1, writer->fs));
+  }
+
+  if (!ok && 0 != ferror(writer->fs)) {
+    SECFILE_LOG(NULL, NULL, "Error writing %s", writer->filename);
+  }
+
+  if (0 != fclose(writer->fs) && ok) {
+    SECFILE_LOG(NULL, NULL, "Error closing %s", writer->filename);
+    ok = FALSE;
+  }
+
+  strpool_hash_destroy(writer->index);
+  binfile_chunk_list_destroy(writer->pool);
+  free(writer->filename);
+  free(writer);
+
+  return ok;
+}
+
+/**********************************************************************//**
+  Save the section file in the binary format. Unlike secfile_save(), the
+  output is never compressed, so that it can be mapped when loading.
+  Include sections are not supported.
+**************************************************************************/
+bool secfile_save_binary(const struct section_file *secfile,
+                         const char *filename)
+{
+  struct binfile_writer *writer;
+
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL != secfile, FALSE);
+
+  if (NULL == filename) {
+    filename = secfile->name;
+  }
+
+  writer = binfile_writer_new(filename);
+  if (NULL == writer) {
+    return FALSE;
+  }
+
+  section_list_iterate(secfile->sections, psection) {
+    if (!binfile_writer_section(writer, psection)) {
+      break;
+    }
+  } section_list_iterate_end;
+
+  return binfile_writer_close(writer);
+}
+
+/**********************************************************************//**
+  Start writing the section file in the binary format while it is still
+  being filled in. secfile_stream_flush() and secfile_stream_close() then
+  work as after secfile_stream_open(). Returns TRUE on success.
+**************************************************************************/
+bool secfile_stream_open_binary(struct section_file *secfile,
+                                const char *filename)
+{
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL != secfile, FALSE);
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL == secfile->stream.fs
+                             && NULL == secfile->stream.binary, FALSE);
+
+  secfile->stream.binary = binfile_writer_new(filename);
+
+  return NULL != secfile->stream.binary;
+}
+
+/**********************************************************************//**
+  Returns TRUE iff the file starts with the binary registry magic.
+**************************************************************************/
+bool is_binfile(const char *filename)
+{
+  char magic[FCBIN_MAGIC_LEN];
+  FILE *fs = fc_fopen(filename, "rb");
+  bool ret;
+
+  if (NULL == fs) {
+    return FALSE;
+  }
+
+  ret = (1 == fread(magic, sizeof(magic), 1, fs)
+         && 0 == memcmp(magic, FCBIN_MAGIC, FCBIN_MAGIC_LEN));
+  fclose(fs);
+
+  return ret;
+}
+
+/**********************************************************************//**
+  Make the whole file available in memory, mapping it when possible.
+  Returns NULL on error.
+**************************************************************************/
+static struct binfile_data *binfile_data_new(const char *filename)
+{
+  struct binfile_data *bdata;
+  struct stat buf;
+  FILE *fs;
+
+  if (0 != fc_stat(filename, &buf) || 0 >= buf.st_size) {
+    return NULL;
+  }
+
+  fs = fc_fopen(filename, "rb");
+  if (NULL == fs) {
+    return NULL;
+  }
+
+  bdata = fc_malloc(sizeof(*bdata));
+  bdata->size = buf.st_size;
+
+#ifdef HAVE_SYS_MMAN_H
+  {
+    void *addr = mmap(NULL, bdata->size, PROT_READ, MAP_PRIVATE,
+                      fileno(fs), 0);
+
+    if (MAP_FAILED != addr) {
+      fclose(fs);
+      bdata->data = addr;
+      bdata->mapped = TRUE;
+      return bdata;
+    }
+  }
+#endif /* HAVE_SYS_MMAN_H */
+
+  {
+    unsigned char *data = fc_malloc(bdata->size);
+
+    if (1 != fread(data, bdata->size, 1, fs)) {
+      free(data);
+      free(bdata);
+      fclose(fs);
+      return NULL;
+    }
+
+    fclose(fs);
+    bdata->data = data;
+    bdata->mapped = FALSE;
+  }
+
+  return bdata;
+}
+
+/**********************************************************************//**
+  Release the memory of binfile_data_new().
+**************************************************************************/
+void binfile_data_destroy(struct binfile_data *bdata)
+{
+#ifdef HAVE_SYS_MMAN_H
+  if (bdata->mapped) {
+    munmap((void *) bdata->data, bdata->size);
+    free(bdata);
+    return;
+  }
+#endif /* HAVE_SYS_MMAN_H */
+
+  free((void *) bdata->data);
+  free(bdata);
+}
+
+/**********************************************************************//**
+  Load a section file saved by secfile_save_binary(). Returns NULL on
+  error.
+**************************************************************************/
+struct section_file *binfile_load(const char *filename,
+                                  bool allow_duplicates)
+{
+  char real_filename[1024];
+  struct binfile_data *bdata;
+  struct section_file *secfile;
+  const unsigned char *rec;
+  const char *pool;
+  uint32_t num_sections, num_entries, pool_offset, pool_size, i, j;
+  size_t records_size;
+
+  interpret_tilde(real_filename, sizeof(real_filename), filename);
+  bdata = binfile_data_new(real_filename);
+  if (NULL == bdata) {
+    SECFILE_LOG(NULL, NULL, _("Could not open %s for reading"),
+                real_filename);
+    return NULL;
+  }
+
+  if (FCBIN_HEADER_SIZE > bdata->size
+      || 0 != memcmp(bdata->data, FCBIN_MAGIC, FCBIN_MAGIC_LEN)) {
+    SECFILE_LOG(NULL, NULL, "%s is not a binary registry file.",
+                real_filename);
+    binfile_data_destroy(bdata);
+    return NULL;
+  }
+
+  if (FCBIN_VERSION != bin_get_u32(bdata->data + 8)) {
+    SECFILE_LOG(NULL, NULL, "%s: unsupported binary format version %u.",
+                real_filename, (unsigned) bin_get_u32(bdata->data + 8));
+    binfile_data_destroy(bdata);
+    return NULL;
+  }
+
+  num_sections = bin_get_u32(bdata->data + 12);
+  num_entries = bin_get_u32(bdata->data + 16);
+  pool_offset = bin_get_u32(bdata->data + 20);
+  pool_size = bin_get_u32(bdata->data + 24);
+  records_size = (size_t) num_sections * FCBIN_SECTION_SIZE
+                 + (size_t) num_entries * FCBIN_ENTRY_SIZE;
+  pool = (const char *) bdata->data + pool_offset;
+
+  /* Every string reference is checked against the pool size, and the
+   * pool itself must end with a terminator. */
+  if (FCBIN_HEADER_SIZE + records_size != pool_offset
+      || (size_t) pool_offset + pool_size != bdata->size
+      || (0 < pool_size && '\0' != pool[pool_size - 1])) {
+    SECFILE_LOG(NULL, NULL, "%s: corrupted binary registry file.",
+                real_filename);
+    binfile_data_destroy(bdata);
+    return NULL;
+  }
+
+#define BINFILE_STR(_ref) \
+  ((_ref) < pool_size ? pool + (_ref) : NULL)
+
+  /* Like the text loader, check for duplicates only once all the entries
+   * are there, when building the hash table. */
+  secfile = secfile_new(TRUE);
+  secfile->name = fc_strdup(filename);
+  secfile->bindata = bdata;
+
+  rec = bdata->data + FCBIN_HEADER_SIZE;
+  for (i = 0; i < num_sections; i++) {
+    const char *sec_name = BINFILE_STR(bin_get_u32(rec));
+    uint32_t sec_entries = bin_get_u32(rec + 4);
+    enum entry_special_type special = bin_get_u32(rec + 8);
+    struct section *psection = NULL;
+
+    rec += FCBIN_SECTION_SIZE;
+    if (NULL == sec_name
+        || (const unsigned char *) pool
+           < rec + (size_t) sec_entries * FCBIN_ENTRY_SIZE) {
+      SECFILE_LOG(secfile, NULL, "Corrupted section record %u.", i);
+      secfile_destroy(secfile);
+      return NULL;
+    }
+
+    if (EST_NORMAL == special) {
+      psection = secfile_section_new(secfile, sec_name);
+      if (NULL == psection) {
+        secfile_destroy(secfile);
+        return NULL;
+      }
+    } else if (EST_COMMENT != special) {
+      SECFILE_LOG(secfile, NULL, "Unsupported section \"%s\".", sec_name);
+      secfile_destroy(secfile);
+      return NULL;
+    }
+
+    for (j = 0; j < sec_entries; j++, rec += FCBIN_ENTRY_SIZE) {
+      const char *name = BINFILE_STR(bin_get_u32(rec));
+      enum entry_type type = rec[4];
+      unsigned char flags = rec[5];
+      uint32_t value = bin_get_u32(rec + 8);
+      uint32_t comment = bin_get_u32(rec + 12);
+      struct entry *pentry = NULL;
+
+      if (NULL != name) {
+        if (NULL == psection) {
+          /* Long comments get their section name back from the
+           * registry, in the same order as they were saved. */
+          if (ENTRY_STR == type && NULL != BINFILE_STR(value)) {
+            secfile_insert_long_comment(secfile, BINFILE_STR(value));
+            continue;
+          }
+        } else {
+          switch (type) {
+          case ENTRY_BOOL:
+            pentry = section_entry_bool_new(psection, name, 0 != value);
+            break;
+          case ENTRY_INT:
+            pentry = section_entry_int_new(psection, name, (int) value);
+            break;
+          case ENTRY_FLOAT:
+            {
+              float fval;
+
+              memcpy(&fval, &value, sizeof(fval));
+              pentry = section_entry_float_new(psection, name, fval);
+            }
+            break;
+          case ENTRY_STR:
+            if (NULL != BINFILE_STR(value)) {
+              pentry = section_entry_str_new_shared(psection, name,
+                                                    BINFILE_STR(value),
+                                                    flags & FCBIN_STR_ESCAPED);
+              if (NULL != pentry && (flags & FCBIN_STR_GT_MARKING)) {
+                entry_str_set_gt_marking(pentry, TRUE);
+              }
+            }
+            break;
+          case ENTRY_FILEREFERENCE:
+          case ENTRY_ILLEGAL:
+            break;
+          }
+        }
+      }
+
+      if (NULL == pentry) {
+        SECFILE_LOG(secfile, psection, "Corrupted entry record %u.", j);
+        secfile_destroy(secfile);
+        return NULL;
+      }
+
+      if (NULL != BINFILE_STR(comment)) {
+        entry_set_comment(pentry, BINFILE_STR(comment));
+      }
+    }
+  }
+
+#undef BINFILE_STR
+
+  if (!secfile_hash_build(secfile, allow_duplicates)) {
+    secfile_destroy(secfile);
+    return NULL;
+  }
+
+  return secfile;
+}
@@ -0,0 +1,52 @@
+/***********************************************************************
+ Freeciv - Copyright (C) 1996 - A Kjeldberg, L Gregersen, P Unold
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2, or (at your option)
+   any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+***********************************************************************/
+#ifndef FC__REGISTRY_BIN_H
+#define FC__REGISTRY_BIN_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/* utility */
+#include "support.h"            /* bool type */
+
+struct binfile_data;
+struct binfile_writer;
+struct section;
+struct section_file;
+
+/* Binary registry files start with this magic, followed by the format
+ * version. Bump the version whenever the record layout changes. */
+#define FCBIN_MAGIC "FCSECBIN"
+#define FCBIN_MAGIC_LEN 8
+#define FCBIN_VERSION 1
+
+bool is_binfile(const char *filename);
+struct section_file *binfile_load(const char *filename,
+                                  bool allow_duplicates);
+bool secfile_save_binary(const struct section_file *secfile,
+                         const char *filename);
+bool secfile_stream_open_binary(struct section_file *secfile,
+                                const char *filename);
+
+/* For the registry itself. */
+bool binfile_writer_section(struct binfile_writer *writer,
+                            const struct section *psection);
+bool binfile_writer_close(struct binfile_writer *writer);
+void binfile_data_destroy(struct binfile_data *bdata);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif  /* FC__REGISTRY_BIN_H */
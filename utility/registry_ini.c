@@ -192,7 +192,8 @@ static void entry_from_inf_token(struct section *psection, const char *name,
  */
 struct entry {
   struct section *psection;     /* Parent section. */
-  char *name;                   /* Name, not including section prefix. */
+  const char *name;             /* Name, not including section prefix.
+                                 * Interned in the secfile. */
   enum entry_type type;         /* The type of the entry. */
   int used;                     /* Number of times entry looked up. */
   char *comment;                /* Comment, may be NULL. */
@@ -212,7 +213,8 @@ struct entry {
     } floating;
     /* ENTRY_STR */
     struct {
-      char *value;              /* Malloced string. */
+      char *value;              /* Malloced string, unless shared. */
+      bool shared;              /* Points in the data of the secfile. */
       bool escaped;             /* " or $. Usually TRUE */
       bool raw;                 /* Do not add anything. */
       bool gt_marking;          /* Save with gettext marking. */
@@ -294,6 +296,26 @@ static bool secfile_hash_delete(struct section_file *secfile,
   return entry_hash_remove(secfile->hash.entries, buf);
 }
 
+/**********************************************************************//**
+  Build the entry hash table of a section file which was filled without
+  it, and set its final duplicate policy.  Returns TRUE on success.
+**************************************************************************/
+bool secfile_hash_build(struct section_file *secfile, bool allow_duplicates)
+{
+  secfile->allow_duplicates = allow_duplicates;
+  secfile->hash.entries = entry_hash_new_nentries(secfile->num_entries);
+
+  section_list_iterate(secfile->sections, hashing_section) {
+    entry_list_iterate(section_entries(hashing_section), pentry) {
+      if (!secfile_hash_insert(secfile, pentry)) {
+        return FALSE;
+      }
+    } entry_list_iterate_end;
+  } section_list_iterate_end;
+
+  return TRUE;
+}
+
 /**********************************************************************//**
   Base function to load a section file.  Note it closes the inputfile.
 **************************************************************************/
@@ -550,21 +572,7 @@ END:
   }
 
   if (!error) {
-    /* Build the entry hash table. */
-    secfile->allow_duplicates = allow_duplicates;
-    secfile->hash.entries = entry_hash_new_nentries(secfile->num_entries);
-
-    section_list_iterate(secfile->sections, hashing_section) {
-      entry_list_iterate(section_entries(hashing_section), pentry) {
-        if (!secfile_hash_insert(secfile, pentry)) {
-          error = TRUE;
-          break;
-        }
-      } entry_list_iterate_end;
-      if (error) {
-        break;
-      }
-    } section_list_iterate_end;
+    error = !secfile_hash_build(secfile, allow_duplicates);
   }
   if (error) {
     secfile_destroy(secfile);
@@ -607,6 +615,209 @@ static bool is_legal_table_entry_name(char c, bool num)
   return (num ? fc_isalnum(c) : fc_isalpha(c)) || c == '_';
 }
 
+/**********************************************************************//**
+  Write a section to the stream, see secfile_save() for the format.
+  The file name is only used in messages.
+**************************************************************************/
+static void section_to_file(const struct section *psection, fz_FILE *fs,
+                            const char *filename)
+{
+  char pentry_name[128];
+  const char *col_entry_name;
+  const struct entry_list_link *ent_iter, *save_iter, *col_iter;
+  struct entry *pentry, *col_pentry;
+  int i;
+
+  if (psection->special == EST_INCLUDE) {
+    for (ent_iter = entry_list_head(section_entries(psection));
+         ent_iter && (pentry = entry_list_link_data(ent_iter));
+         ent_iter = entry_list_link_next(ent_iter)) {
+
+      fc_assert(!strcmp(entry_name(pentry), "file"));
+
+      fz_fprintf(fs, "*include ");
+      entry_to_file(pentry, fs);
+      fz_fprintf(fs, "\n");
+    }
+  } else if (psection->special == EST_COMMENT) {
+    for (ent_iter = entry_list_head(section_entries(psection));
+         ent_iter && (pentry = entry_list_link_data(ent_iter));
+         ent_iter = entry_list_link_next(ent_iter)) {
+
+      fc_assert(!strcmp(entry_name(pentry), "comment"));
+
+      entry_to_file(pentry, fs);
+      fz_fprintf(fs, "\n");
+    }
+  } else {
+    fz_fprintf(fs, "\n[%s]\n", section_name(psection));
+
+    /* Following doesn't use entry_list_iterate() because we want to do
+     * tricky things with the iterators...
+     */
+    for (ent_iter = entry_list_head(section_entries(psection));
+         ent_iter && (pentry = entry_list_link_data(ent_iter));
+         ent_iter = entry_list_link_next(ent_iter)) {
+      const char *comment;
+
+      /* Tables: break out of this loop if this is a non-table
+       * entry (pentry and ent_iter unchanged) or after table (pentry
+       * and ent_iter suitably updated, pentry possibly NULL).
+       * After each table, loop again in case the next entry
+       * is another table.
+       */
+      for (;;) {
+        char *c, *first, base[64];
+        int offset, irow, icol, ncol;
+
+        /* Example: for first table name of "xyz0.blah":
+         *  first points to the original string pentry->name
+         *  base contains "xyz";
+         *  offset = 5 (so first+offset gives "blah")
+         *  note strlen(base) = offset - 2
+         */
+
+        if (!SAVE_TABLES) {
+          break;
+        }
+
+        sz_strlcpy(pentry_name, entry_name(pentry));
+        c = first = pentry_name;
+        if (*c == '\0' || !is_legal_table_entry_name(*c, FALSE)) {
+          break;
+        }
+        for (; *c != '\0' && is_legal_table_entry_name(*c, FALSE); c++) {
+          /* nothing */
+        }
+        if (0 != strncmp(c, "0.", 2)) {
+          break;
+        }
+        c += 2;
+        if (*c == '\0' || !is_legal_table_entry_name(*c, TRUE)) {
+          break;
+        }
+
+        offset = c - first;
+        first[offset - 2] = '\0';
+        sz_strlcpy(base, first);
+        first[offset - 2] = '0';
+        fz_fprintf(fs, "%s={", base);
+
+        /* Save an iterator at this first entry, which we can later use
+         * to repeatedly iterate over column names:
+         */
+        save_iter = ent_iter;
+
+        /* write the column names, and calculate ncol: */
+        ncol = 0;
+        col_iter = save_iter;
+        for (; (col_pentry = entry_list_link_data(col_iter));
+             col_iter = entry_list_link_next(col_iter)) {
+          col_entry_name = entry_name(col_pentry);
+          if (strncmp(col_entry_name, first, offset) != 0) {
+            break;
+          }
+          fz_fprintf(fs, "%s\"%s\"", (ncol == 0 ? "" : ","),
+                     col_entry_name + offset);
+          ncol++;
+        }
+        fz_fprintf(fs, "\n");
+
+        /* Iterate over rows and columns, incrementing ent_iter as we go,
+         * and writing values to the table.  Have a separate iterator
+         * to the column names to check they all match.
+         */
+        irow = icol = 0;
+        col_iter = save_iter;
+        for (;;) {
+          char expect[128];     /* pentry->name we're expecting */
+
+          pentry = entry_list_link_data(ent_iter);
+          col_pentry = entry_list_link_data(col_iter);
+
+          fc_snprintf(expect, sizeof(expect), "%s%d.%s",
+                      base, irow, entry_name(col_pentry) + offset);
+
+          /* break out of tabular if doesn't match: */
+          if ((!pentry) || (strcmp(entry_name(pentry), expect) != 0)) {
+            if (icol != 0) {
+              /* If the second or later row of a table is missing some
+               * entries that the first row had, we drop out of the tabular
+               * format.  This is inefficient so we print a warning message;
+               * the calling code probably needs to be fixed so that it can
+               * use the more efficient tabular format.
+               *
+               * FIXME: If the first row is missing some entries that the
+               * second or later row has, then we'll drop out of tabular
+               * format without an error message. */
+              bugreport_request("In file %s, there is no entry in the registry for\n"
+                                "%s.%s (or the entries are out of order). This means\n"
+                                "a less efficient non-tabular format will be used.\n"
+                                "To avoid this make sure all rows of a table are\n"
+                                "filled out with an entry for every column.",
+                                filename, section_name(psection), expect);
+              fz_fprintf(fs, "\n");
+            }
+            fz_fprintf(fs, "}\n");
+            break;
+          }
+
+          if (icol > 0) {
+            fz_fprintf(fs, ",");
+          }
+          entry_to_file(pentry, fs);
+
+          ent_iter = entry_list_link_next(ent_iter);
+          col_iter = entry_list_link_next(col_iter);
+
+          icol++;
+          if (icol == ncol) {
+            fz_fprintf(fs, "\n");
+            irow++;
+            icol = 0;
+            col_iter = save_iter;
+          }
+        }
+        if (!pentry) {
+          break;
+        }
+      }
+      if (!pentry) {
+        break;
+      }
+
+      /* Classic entry. */
+      col_entry_name = entry_name(pentry);
+      fz_fprintf(fs, "%s=", col_entry_name);
+      entry_to_file(pentry, fs);
+
+      /* Check for vector. */
+      for (i = 1;; i++) {
+        col_iter = entry_list_link_next(ent_iter);
+        col_pentry = entry_list_link_data(col_iter);
+        if (NULL == col_pentry) {
+          break;
+        }
+        fc_snprintf(pentry_name, sizeof(pentry_name),
+                    "%s,%d", col_entry_name, i);
+        if (0 != strcmp(pentry_name, entry_name(col_pentry))) {
+          break;
+        }
+        fz_fprintf(fs, ",");
+        entry_to_file(col_pentry, fs);
+        ent_iter = col_iter;
+      }
+
+      comment = entry_comment(pentry);
+      if (comment) {
+        fz_fprintf(fs, "  # %s\n", comment);
+      } else {
+        fz_fprintf(fs, "\n");
+      }
+    }
+  }
+}
+
 /**********************************************************************//**
   Save the previously filled in section_file to disk.
 
@@ -630,12 +841,7 @@ bool secfile_save(const struct section_file *secfile, const char *filename,
                   int compression_level, enum fz_method compression_method)
 {
   char real_filename[1024];
-  char pentry_name[128];
-  const char *col_entry_name;
   fz_FILE *fs;
-  const struct entry_list_link *ent_iter, *save_iter, *col_iter;
-  struct entry *pentry, *col_pentry;
-  int i;
 
   SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL != secfile, FALSE);
 
@@ -654,208 +860,124 @@ bool secfile_save(const struct section_file *secfile, const char *filename,
   }
 
   section_list_iterate(secfile->sections, psection) {
-    if (psection->special == EST_INCLUDE) {
-      for (ent_iter = entry_list_head(section_entries(psection));
-           ent_iter && (pentry = entry_list_link_data(ent_iter));
-           ent_iter = entry_list_link_next(ent_iter)) {
+    section_to_file(psection, fs, real_filename);
+  } section_list_iterate_end;
 
-        fc_assert(!strcmp(entry_name(pentry), "file"));
+  if (0 != fz_ferror(fs)) {
+    SECFILE_LOG(secfile, NULL, "Error before closing %s: %s", 
+                real_filename, fz_strerror(fs));
+    fz_fclose(fs);
+    return FALSE;
+  }
+  if (0 != fz_fclose(fs)) {
+    SECFILE_LOG(secfile, NULL, "Error closing %s", real_filename);
+    return FALSE;
+  }
 
-        fz_fprintf(fs, "*include ");
-        entry_to_file(pentry, fs);
-        fz_fprintf(fs, "\n");
-      }
-    } else if (psection->special == EST_COMMENT) {
-      for (ent_iter = entry_list_head(section_entries(psection));
-           ent_iter && (pentry = entry_list_link_data(ent_iter));
-           ent_iter = entry_list_link_next(ent_iter)) {
+  return TRUE;
+}
 
-        fc_assert(!strcmp(entry_name(pentry), "comment"));
+/**********************************************************************//**
+  Start writing the section file to disk while it is still being filled
+  in.  Each call to secfile_stream_flush() writes out the sections
+  inserted so far and frees them, and secfile_stream_close() writes the
+  remaining ones.  This gives the same file as secfile_save() would at
+  the end, provided that nothing is added to a section after it has been
+  flushed.  Returns TRUE on success.
+**************************************************************************/
+bool secfile_stream_open(struct section_file *secfile, const char *filename,
+                         int compression_level,
+                         enum fz_method compression_method)
+{
+  char real_filename[1024];
 
-        entry_to_file(pentry, fs);
-        fz_fprintf(fs, "\n");
-      }
-    } else {
-      fz_fprintf(fs, "\n[%s]\n", section_name(psection));
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL != secfile, FALSE);
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL == secfile->stream.fs
+                             && NULL == secfile->stream.binary, FALSE);
 
-      /* Following doesn't use entry_list_iterate() because we want to do
-       * tricky things with the iterators...
-       */
-      for (ent_iter = entry_list_head(section_entries(psection));
-           ent_iter && (pentry = entry_list_link_data(ent_iter));
-           ent_iter = entry_list_link_next(ent_iter)) {
-        const char *comment;
-
-        /* Tables: break out of this loop if this is a non-table
-         * entry (pentry and ent_iter unchanged) or after table (pentry
-         * and ent_iter suitably updated, pentry possibly NULL).
-         * After each table, loop again in case the next entry
-         * is another table.
-         */
-        for (;;) {
-          char *c, *first, base[64];
-          int offset, irow, icol, ncol;
+  interpret_tilde(real_filename, sizeof(real_filename), filename);
+  secfile->stream.fs = fz_from_file(real_filename, "w",
+                                    compression_method, compression_level);
 
-          /* Example: for first table name of "xyz0.blah":
-           *  first points to the original string pentry->name
-           *  base contains "xyz";
-           *  offset = 5 (so first+offset gives "blah")
-           *  note strlen(base) = offset - 2
-           */
+  if (NULL == secfile->stream.fs) {
+    SECFILE_LOG(secfile, NULL, _("Could not open %s for writing"),
+                real_filename);
 
-          if (!SAVE_TABLES) {
-            break;
-          }
+    return FALSE;
+  }
 
-          sz_strlcpy(pentry_name, entry_name(pentry));
-          c = first = pentry_name;
-          if (*c == '\0' || !is_legal_table_entry_name(*c, FALSE)) {
-            break;
-          }
-          for (; *c != '\0' && is_legal_table_entry_name(*c, FALSE); c++) {
-            /* nothing */
-          }
-          if (0 != strncmp(c, "0.", 2)) {
-            break;
-          }
-          c += 2;
-          if (*c == '\0' || !is_legal_table_entry_name(*c, TRUE)) {
-            break;
-          }
+  secfile->stream.filename = fc_strdup(real_filename);
 
-          offset = c - first;
-          first[offset - 2] = '\0';
-          sz_strlcpy(base, first);
-          first[offset - 2] = '0';
-          fz_fprintf(fs, "%s={", base);
-
-          /* Save an iterator at this first entry, which we can later use
-           * to repeatedly iterate over column names:
-           */
-          save_iter = ent_iter;
-
-          /* write the column names, and calculate ncol: */
-          ncol = 0;
-          col_iter = save_iter;
-          for (; (col_pentry = entry_list_link_data(col_iter));
-               col_iter = entry_list_link_next(col_iter)) {
-            col_entry_name = entry_name(col_pentry);
-            if (strncmp(col_entry_name, first, offset) != 0) {
-              break;
-            }
-            fz_fprintf(fs, "%s\"%s\"", (ncol == 0 ? "" : ","),
-                       col_entry_name + offset);
-            ncol++;
-          }
-          fz_fprintf(fs, "\n");
-
-          /* Iterate over rows and columns, incrementing ent_iter as we go,
-           * and writing values to the table.  Have a separate iterator
-           * to the column names to check they all match.
-           */
-          irow = icol = 0;
-          col_iter = save_iter;
-          for (;;) {
-            char expect[128];     /* pentry->name we're expecting */
-
-            pentry = entry_list_link_data(ent_iter);
-            col_pentry = entry_list_link_data(col_iter);
-
-            fc_snprintf(expect, sizeof(expect), "%s%d.%s",
-                        base, irow, entry_name(col_pentry) + offset);
-
-            /* break out of tabular if doesn't match: */
-            if ((!pentry) || (strcmp(entry_name(pentry), expect) != 0)) {
-              if (icol != 0) {
-                /* If the second or later row of a table is missing some
-                 * entries that the first row had, we drop out of the tabular
-                 * format.  This is inefficient so we print a warning message;
-                 * the calling code probably needs to be fixed so that it can
-                 * use the more efficient tabular format.
-                 *
-                 * FIXME: If the first row is missing some entries that the
-                 * second or later row has, then we'll drop out of tabular
-                 * format without an error message. */
-                bugreport_request("In file %s, there is no entry in the registry for\n"
-                                  "%s.%s (or the entries are out of order). This means\n"
-                                  "a less efficient non-tabular format will be used.\n"
-                                  "To avoid this make sure all rows of a table are\n"
-                                  "filled out with an entry for every column.",
-                                  real_filename, section_name(psection), expect);
-                fz_fprintf(fs, "\n");
-              }
-              fz_fprintf(fs, "}\n");
-              break;
-            }
+  return TRUE;
+}
 
-            if (icol > 0) {
-              fz_fprintf(fs, ",");
-            }
-            entry_to_file(pentry, fs);
+/**********************************************************************//**
+  Write out all the sections of a streamed section file, and remove them
+  from it.  Does nothing if the section file is not streamed.
+**************************************************************************/
+void secfile_stream_flush(struct section_file *secfile)
+{
+  struct section *psection;
 
-            ent_iter = entry_list_link_next(ent_iter);
-            col_iter = entry_list_link_next(col_iter);
+  if (NULL == secfile
+      || (NULL == secfile->stream.fs && NULL == secfile->stream.binary)) {
+    return;
+  }
 
-            icol++;
-            if (icol == ncol) {
-              fz_fprintf(fs, "\n");
-              irow++;
-              icol = 0;
-              col_iter = save_iter;
-            }
-          }
-          if (!pentry) {
-            break;
-          }
-        }
-        if (!pentry) {
-          break;
-        }
+  while (NULL != (psection = section_list_front(secfile->sections))) {
+    if (NULL != secfile->stream.binary) {
+      /* Errors are reported by secfile_stream_close(). */
+      binfile_writer_section(secfile->stream.binary, psection);
+    } else {
+      section_to_file(psection, secfile->stream.fs,
+                      secfile->stream.filename);
+    }
+    section_destroy(psection);
+  }
+}
 
-        /* Classic entry. */
-        col_entry_name = entry_name(pentry);
-        fz_fprintf(fs, "%s=", col_entry_name);
-        entry_to_file(pentry, fs);
+/**********************************************************************//**
+  Write out the rest of a streamed section file, and close the file.
+  Returns TRUE on success.
+**************************************************************************/
+bool secfile_stream_close(struct section_file *secfile)
+{
+  fz_FILE *fs;
+  char *real_filename;
+  bool ok = TRUE;
 
-        /* Check for vector. */
-        for (i = 1;; i++) {
-          col_iter = entry_list_link_next(ent_iter);
-          col_pentry = entry_list_link_data(col_iter);
-          if (NULL == col_pentry) {
-            break;
-          }
-          fc_snprintf(pentry_name, sizeof(pentry_name),
-                      "%s,%d", col_entry_name, i);
-          if (0 != strcmp(pentry_name, entry_name(col_pentry))) {
-            break;
-          }
-          fz_fprintf(fs, ",");
-          entry_to_file(col_pentry, fs);
-          ent_iter = col_iter;
-        }
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL != secfile, FALSE);
+  SECFILE_RETURN_VAL_IF_FAIL(secfile, NULL, NULL != secfile->stream.fs
+                             || NULL != secfile->stream.binary, FALSE);
 
-        comment = entry_comment(pentry);
-        if (comment) {
-          fz_fprintf(fs, "  # %s\n", comment);
-        } else {
-          fz_fprintf(fs, "\n");
-        }
-      }
-    }
-  } section_list_iterate_end;
+  secfile_stream_flush(secfile);
+
+  if (NULL != secfile->stream.binary) {
+    struct binfile_writer *writer = secfile->stream.binary;
+
+    secfile->stream.binary = NULL;
+
+    return binfile_writer_close(writer);
+  }
+
+  fs = secfile->stream.fs;
+  real_filename = secfile->stream.filename;
+  secfile->stream.fs = NULL;
+  secfile->stream.filename = NULL;
 
   if (0 != fz_ferror(fs)) {
-    SECFILE_LOG(secfile, NULL, "Error before closing %s: %s", 
+    SECFILE_LOG(secfile, NULL, "Error before closing %s: %s",
                 real_filename, fz_strerror(fs));
     fz_fclose(fs);
-    return FALSE;
-  }
-  if (0 != fz_fclose(fs)) {
+    ok = FALSE;
+  } else if (0 != fz_fclose(fs)) {
     SECFILE_LOG(secfile, NULL, "Error closing %s", real_filename);
-    return FALSE;
+    ok = FALSE;
   }
 
-  return TRUE;
+  free(real_filename);
+
+  return ok;
 }
 
 /**********************************************************************//**
@@ -2846,7 +2968,7 @@ struct section *secfile_section_new(struct section_file *secfile,
 
   psection = fc_malloc(sizeof(struct section));
   psection->special = EST_NORMAL;
-  psection->name = fc_strdup(name);
+  psection->name = secfile_name_intern(secfile, name);
   psection->entries = entry_list_new_full(entry_destroy);
 
   /* Append to secfile. */
@@ -2883,7 +3005,6 @@ void section_destroy(struct section *psection)
   }
 
   entry_list_destroy(psection->entries);
-  free(psection->name);
   free(psection);
 }
 
@@ -2947,8 +3068,7 @@ bool section_set_name(struct section *psection, const char *name)
   }
 
   /* Really rename. */
-  free(psection->name);
-  psection->name = fc_strdup(name);
+  psection->name = secfile_name_intern(secfile, name);
 
   /* Reinsert new references into the hash tables. */
   if (NULL != secfile->hash.sections) {
@@ -3049,7 +3169,7 @@ static struct entry *entry_new(struct section *psection, const char *name)
   }
 
   pentry = fc_malloc(sizeof(struct entry));
-  pentry->name = fc_strdup(name);
+  pentry->name = secfile_name_intern(secfile, name);
   pentry->type = -1;    /* Invalid case. */
   pentry->used = 0;
   pentry->comment = NULL;
@@ -3125,6 +3245,30 @@ struct entry *section_entry_str_new(struct section *psection,
   if (NULL != pentry) {
     pentry->type = ENTRY_STR;
     pentry->string.value = fc_strdup(NULL != value ? value : "");
+    pentry->string.shared = FALSE;
+    pentry->string.escaped = escaped;
+    pentry->string.raw = FALSE;
+    pentry->string.gt_marking = FALSE;
+  }
+
+  return pentry;
+}
+
+/**********************************************************************//**
+  Returns a new entry of type ENTRY_STR, which uses the value as is
+  instead of copying it. The value must stay valid as long as the entry,
+  for example by being part of the data kept by the secfile.
+**************************************************************************/
+struct entry *section_entry_str_new_shared(struct section *psection,
+                                           const char *name,
+                                           const char *value, bool escaped)
+{
+  struct entry *pentry = entry_new(psection, name);
+
+  if (NULL != pentry) {
+    pentry->type = ENTRY_STR;
+    pentry->string.value = (char *) value;
+    pentry->string.shared = TRUE;
     pentry->string.escaped = escaped;
     pentry->string.raw = FALSE;
     pentry->string.gt_marking = FALSE;
@@ -3144,6 +3288,7 @@ static struct entry *section_entry_filereference_new(struct section *psection,
   if (NULL != pentry) {
     pentry->type = ENTRY_FILEREFERENCE;
     pentry->string.value = fc_strdup(NULL != value ? value : "");
+    pentry->string.shared = FALSE;
   }
 
   return pentry;
@@ -3183,7 +3328,9 @@ void entry_destroy(struct entry *pentry)
 
   case ENTRY_STR:
   case ENTRY_FILEREFERENCE:
-    free(pentry->string.value);
+    if (!pentry->string.shared) {
+      free(pentry->string.value);
+    }
     break;
 
   case ENTRY_ILLEGAL:
@@ -3192,7 +3339,6 @@ void entry_destroy(struct entry *pentry)
   }
 
   /* Common free. */
-  free(pentry->name);
   if (NULL != pentry->comment) {
     free(pentry->comment);
   }
@@ -3220,9 +3366,23 @@ enum entry_type entry_type_get(const struct entry *pentry)
 **************************************************************************/
 int entry_path(const struct entry *pentry, char *buf, size_t buf_len)
 {
-  return fc_snprintf(buf, buf_len, "%s.%s",
-                     section_name(entry_section(pentry)),
-                     entry_name(pentry));
+  const char *sname = section_name(entry_section(pentry));
+  const char *ename = entry_name(pentry);
+  size_t slen, elen;
+
+  if (NULL == sname || NULL == ename
+      || (slen = strlen(sname)) + 1 + (elen = strlen(ename)) >= buf_len) {
+    /* Leave the corner cases to fc_snprintf(). */
+    return fc_snprintf(buf, buf_len, "%s.%s", sname, ename);
+  }
+
+  /* This is called for every entry loaded, so avoid the format
+   * parsing. */
+  memcpy(buf, sname, slen);
+  buf[slen] = '.';
+  memcpy(buf + slen + 1, ename, elen + 1);
+
+  return slen + 1 + elen;
 }
 
 /**********************************************************************//**
@@ -3273,8 +3433,7 @@ bool entry_set_name(struct entry *pentry, const char *name)
   secfile_hash_delete(secfile, pentry);
 
   /* Really rename the entry. */
-  free(pentry->name);
-  pentry->name = fc_strdup(name);
+  pentry->name = secfile_name_intern(secfile, name);
 
   /* Insert into hash table the new path. */
   secfile_hash_insert(secfile, pentry);
@@ -3451,7 +3610,10 @@ bool entry_str_set(struct entry *pentry, const char *value)
    * to lose the entry in between. */
   old_val = pentry->string.value;
   pentry->string.value = fc_strdup(NULL != value ? value : "");
-  free(old_val);
+  if (!pentry->string.shared) {
+    free(old_val);
+  }
+  pentry->string.shared = FALSE;
   return TRUE;
 }
 
@@ -3480,6 +3642,18 @@ bool entry_str_set_escaped(struct entry *pentry, bool escaped)
   return TRUE;
 }
 
+/**********************************************************************//**
+  Returns if the string would get gettext marking.
+**************************************************************************/
+bool entry_str_gt_marking(const struct entry *pentry)
+{
+  SECFILE_RETURN_VAL_IF_FAIL(NULL, NULL, NULL != pentry, FALSE);
+  SECFILE_RETURN_VAL_IF_FAIL(pentry->psection->secfile, pentry->psection,
+                             ENTRY_STR == pentry->type, FALSE);
+
+  return pentry->string.gt_marking;
+}
+
 /**********************************************************************//**
   Sets if the string should get gettext marking. Returns TRUE on success.
 **************************************************************************/
@@ -65,6 +65,11 @@ struct section_file *secfile_from_stream(fz_FILE *stream,
 
 bool secfile_save(const struct section_file *secfile, const char *filename,
                   int compression_level, enum fz_method compression_method);
+bool secfile_stream_open(struct section_file *secfile, const char *filename,
+                         int compression_level,
+                         enum fz_method compression_method);
+void secfile_stream_flush(struct section_file *secfile);
+bool secfile_stream_close(struct section_file *secfile);
 void secfile_check_unused(const struct section_file *secfile);
 const char *secfile_name(const struct section_file *secfile);
 
@@ -611,6 +616,9 @@ struct entry *section_entry_float_new(struct section *psection,
 struct entry *section_entry_str_new(struct section *psection,
                                     const char *entry_name,
                                     const char *value, bool escaped);
+struct entry *section_entry_str_new_shared(struct section *psection,
+                                           const char *entry_name,
+                                           const char *value, bool escaped);
 
 /* Independant entry functions. */
 enum entry_type {
@@ -647,6 +655,7 @@ bool entry_str_get(const struct entry *pentry, const char **value);
 bool entry_str_set(struct entry *pentry, const char *value);
 bool entry_str_escaped(const struct entry *pentry);
 bool entry_str_set_escaped(struct entry *pentry, bool escaped);
+bool entry_str_gt_marking(const struct entry *pentry);
 bool entry_str_set_gt_marking(struct entry *pentry, bool gt_marking);
 
 #ifdef __cplusplus
@@ -85,6 +85,12 @@ struct section_file *secfile_new(bool allow_duplicates)
   secfile->hash.sections = section_hash_new();
   /* Maybe allocated later. */
   secfile->hash.entries = NULL;
+  secfile->names = name_pool_hash_new();
+
+  secfile->bindata = NULL;
+  secfile->stream.fs = NULL;
+  secfile->stream.filename = NULL;
+  secfile->stream.binary = NULL;
 
   return secfile;
 }
@@ -108,6 +114,20 @@ void secfile_destroy(struct section_file *secfile)
   }
 
   section_list_destroy(secfile->sections);
+  name_pool_hash_destroy(secfile->names);
+
+  if (NULL != secfile->bindata) {
+    /* After the entries, which may point in it. */
+    binfile_data_destroy(secfile->bindata);
+  }
+
+  if (NULL != secfile->stream.fs) {
+    /* Abandoned before secfile_stream_close(). */
+    fz_fclose(secfile->stream.fs);
+    free(secfile->stream.filename);
+  } else if (NULL != secfile->stream.binary) {
+    binfile_writer_close(secfile->stream.binary);
+  }
 
   if (NULL != secfile->name) {
     free(secfile->name);
@@ -116,6 +136,24 @@ void secfile_destroy(struct section_file *secfile)
   free(secfile);
 }
 
+/**********************************************************************//**
+  Returns the copy of the section or entry name kept by the secfile.
+  The same names repeat in many sections, for example for every player
+  and city of a savegame, so each is stored only once.
+**************************************************************************/
+const char *secfile_name_intern(struct section_file *secfile,
+                                const char *name)
+{
+  char *interned;
+
+  if (!name_pool_hash_lookup(secfile->names, name, &interned)) {
+    interned = fc_strdup(name);
+    name_pool_hash_insert(secfile->names, interned, interned);
+  }
+
+  return interned;
+}
+
 /**********************************************************************//**
   Set if we could consider values 0 and 1 as boolean. By default, this is
   not allowed, but we need to keep compatibility with old Freeciv version
@@ -144,12 +182,19 @@ bool entry_from_token(struct section *psection, const char *name,
   }
 
   if ('$' == tok[0] || '"' == tok[0]) {
-    char buf[strlen(tok) + 1];
     bool escaped = ('"' == tok[0]);
 
-    remove_escapes(tok + 1, escaped, buf, sizeof(buf));
-    (void) section_entry_str_new(psection, name, buf, escaped);
-    DEBUG_ENTRIES("entry %s '%s'", name, buf);
+    if (NULL == strchr(tok + 1, '\\')) {
+      /* Nothing to unescape, use the token as such. */
+      (void) section_entry_str_new(psection, name, tok + 1, escaped);
+      DEBUG_ENTRIES("entry %s '%s'", name, tok + 1);
+    } else {
+      char buf[strlen(tok) + 1];
+
+      remove_escapes(tok + 1, escaped, buf, sizeof(buf));
+      (void) section_entry_str_new(psection, name, buf, escaped);
+      DEBUG_ENTRIES("entry %s '%s'", name, buf);
+    }
     return TRUE;
   }
 
@@ -22,13 +22,14 @@ extern "C" {
 #endif /* __cplusplus */
 
 /* utility */
+#include "ioz.h"
 #include "support.h"
 
 /* Section structure. */
 struct section {
   struct section_file *secfile; /* Parent structure. */
   enum entry_special_type special;
-  char *name;                   /* Name of the section. */
+  const char *name;             /* Name of the section, interned. */
   struct entry_list *entries;   /* The list of the children. */
 };
 
@@ -48,6 +49,16 @@ struct section_file {
     struct section_hash *sections;
     struct entry_hash *entries;
   } hash;
+  struct name_pool_hash *names;         /* Interned section and entry
+                                         * names, owned by the secfile. */
+  struct binfile_data *bindata;         /* Binary file loaded, in which
+                                         * shared string values point. */
+  struct {
+    fz_FILE *fs;                        /* NULL unless streaming. */
+    char *filename;
+    struct binfile_writer *binary;      /* Instead of 'fs', when streaming
+                                         * in binary format. */
+  } stream;
 };
 
 void secfile_log(const struct section_file *secfile,
@@ -80,8 +91,19 @@ void secfile_log(const struct section_file *secfile,
 #define SPECHASH_IDATA_TYPE struct entry *
 #include "spechash.h"
 
+/* The key and the data are the same string. */
+#define SPECHASH_TAG name_pool
+#define SPECHASH_CSTR_KEY_TYPE
+#define SPECHASH_IDATA_TYPE char *
+#define SPECHASH_IDATA_FREE (name_pool_hash_data_free_fn_t) free
+#include "spechash.h"
+
+const char *secfile_name_intern(struct section_file *secfile,
+                                const char *name);
+
 bool entry_from_token(struct section *psection, const char *name,
                       const char *tok);
+bool secfile_hash_build(struct section_file *secfile, bool allow_duplicates);
 
 #ifdef __cplusplus
 }
@@ -24,6 +24,9 @@
  * You may also define:
  *   SPECLIST_TYPE - the typed genlist will contain pointers to this type;
  * If SPECLIST_TYPE is not defined, then 'struct SPECLIST_TAG' is used.
+ *   SPECLIST_MUTEX - the lists are created with a mutex, for sharing them
+ *                    between threads (see foo_list_allocate_mutex()).
+ *                    Other lists don't carry any mutex.
  * At the end of this file, these (and other defines) are undef-ed.
  *
  * Assuming SPECLIST_TAG were 'foo', and SPECLIST_TYPE were 'foo_t',
@@ -84,7 +87,9 @@
  *    void foo_list_shuffle(struct foo_list *plist);
  *    void foo_list_reverse(struct foo_list *plist);
  *    void foo_list_allocate_mutex(struct foo_list *plist);
+ *        (only if SPECLIST_MUTEX is defined)
  *    void foo_list_release_mutex(struct foo_list *plist);
+ *        (only if SPECLIST_MUTEX is defined)
  *    foo_t *foo_list_link_data(const struct foo_list_link *plink);
  *    struct foo_list_link *
  *        foo_list_link_prev(const struct foo_list_link *plink);
@@ -167,7 +172,14 @@ fc__warn_unused_result;
 
 static inline SPECLIST_LIST *SPECLIST_FOO(_list_new) (void)
 {
+#ifdef SPECLIST_MUTEX
+  struct genlist *plist = genlist_new();
+
+  genlist_init_mutex(plist);
+  return (SPECLIST_LIST *) plist;
+#else  /* SPECLIST_MUTEX */
   return (SPECLIST_LIST *) genlist_new();
+#endif /* SPECLIST_MUTEX */
 }
 
 /****************************************************************************
@@ -180,8 +192,15 @@ fc__warn_unused_result;
 static inline SPECLIST_LIST *
 SPECLIST_FOO(_list_new_full) (SPECLIST_FOO(_list_free_fn_t) free_data_func)
 {
+#ifdef SPECLIST_MUTEX
+  struct genlist *plist = genlist_new_full((genlist_free_fn_t) free_data_func);
+
+  genlist_init_mutex(plist);
+  return (SPECLIST_LIST *) plist;
+#else  /* SPECLIST_MUTEX */
   return ((SPECLIST_LIST *)
           genlist_new_full((genlist_free_fn_t) free_data_func));
+#endif /* SPECLIST_MUTEX */
 }
 
 /****************************************************************************
@@ -490,6 +509,7 @@ static inline void SPECLIST_FOO(_list_reverse) (SPECLIST_LIST *tthis)
   genlist_reverse((struct genlist *) tthis);
 }
 
+#ifdef SPECLIST_MUTEX
 /****************************************************************************
   Allocate speclist mutex
 ****************************************************************************/
@@ -505,6 +525,7 @@ static inline void SPECLIST_FOO(_list_release_mutex) (SPECLIST_LIST *tthis)
 {
   genlist_release_mutex((struct genlist *) tthis);
 }
+#endif /* SPECLIST_MUTEX */
 
 /****************************************************************************
   Return the data of the link.
@@ -546,6 +567,7 @@ SPECLIST_FOO(_list_link_next) (const SPECLIST_LINK *plink)
 
 #undef SPECLIST_TAG
 #undef SPECLIST_TYPE
+#undef SPECLIST_MUTEX
 #undef SPECLIST_PASTE_
 #undef SPECLIST_PASTE
 #undef SPECLIST_LIST